@@ -0,0 +1,43 @@
+#include <benchmark/benchmark.h>
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+#include "bench_signals.h"
+#include "playback_clock.h"
+
+namespace {
+
+// 播放时钟的读取：写入线程按1024帧的设备周期推进时钟，
+// 测量线程像界面或视频同步那样反复读取。range(0)为写入周期（微秒），
+// 0表示写入线程不停地推进，测量最坏情况下顺序锁的重试开销
+void BM_PlaybackClockRead(benchmark::State &state) {
+    PlaybackClock clock;
+    clock.configure(BENCH_SAMPLE_RATE, 1024);
+    auto period = std::chrono::microseconds(state.range(0));
+
+    std::atomic<bool> running{true};
+    std::thread writer([&]() {
+        int64_t frame = 0;
+        while (running.load(std::memory_order_relaxed)) {
+            clock.advance(frame, 1024, PlaybackClock::nowNanos(), 0);
+            frame += 1024;
+            if (period.count() > 0) {
+                std::this_thread::sleep_for(period);
+            }
+        }
+    });
+
+    for (auto _ : state) {
+        ClockReading reading = clock.read();
+        benchmark::DoNotOptimize(reading);
+    }
+
+    running = false;
+    writer.join();
+}
+
+}  // namespace
+
+BENCHMARK(BM_PlaybackClockRead)->ArgName("period_us")->Arg(0)->Arg(21333);
@@ -0,0 +1,151 @@
+#include <benchmark/benchmark.h>
+
+#include <random>
+#include <string>
+
+#include "audio_decoder.h"
+#include "bench_signals.h"
+
+namespace {
+
+// 打开测试信号文件，缺少编码器或文件无法打开时跳过该测试
+bool openSignal(benchmark::State &state, const char *codecName,
+                AudioDecoder &decoder, std::string *openedPath = nullptr) {
+    const BenchCodec *codec = findBenchCodec(codecName);
+    std::string error;
+    std::string path = codec ? benchSignalFile(*codec, error) : "";
+    if (path.empty()) {
+        state.SkipWithError(error.c_str());
+        return false;
+    }
+    if (decoder.open(path) != AudioDecoderError::SUCCESS) {
+        state.SkipWithError("could not open test signal");
+        return false;
+    }
+    if (openedPath) {
+        *openedPath = path;
+    }
+    return true;
+}
+
+// 解码线程吞吐量：每次迭代从头解码整个文件，经过decodeLoop、帧池和帧队列
+void BM_DecodeLoop(benchmark::State &state, const char *codecName) {
+    AudioDecoderConfig config;
+    config.maxQueueSize = 64;
+    AudioDecoder decoder(config);
+    if (!openSignal(state, codecName, decoder)) {
+        return;
+    }
+
+    int64_t samples = 0;
+    for (auto _ : state) {
+        decoder.seek(0.0);
+        decoder.start();
+        AVFrame *frame = nullptr;
+        while (!decoder.isFinished()) {
+            if (decoder.getAudioFrame(&frame, 1000) && frame) {
+                samples += frame->nb_samples;
+                decoder.releaseFrame(frame);
+            }
+        }
+        decoder.stop();
+    }
+
+    state.SetItemsProcessed(samples);
+    state.counters["x_realtime"] = benchmark::Counter(
+        static_cast<double>(samples) / decoder.getSampleRate(),
+        benchmark::Counter::kIsRate);
+}
+
+// 定位延迟：定位到随机位置并解出第一帧。range(0)为1时使用定位索引
+void BM_Seek(benchmark::State &state, const char *codecName) {
+    AudioDecoderConfig config;
+    config.seekIndexMode = state.range(0) ? SeekIndexMode::ON_FIRST_SEEK
+                                          : SeekIndexMode::DISABLED;
+    config.cacheSeekIndex = false;
+    AudioDecoder decoder(config);
+    if (!openSignal(state, codecName, decoder)) {
+        return;
+    }
+
+    AudioDecoder::FramePtr frame(av_frame_alloc());
+    // 索引在第一次定位时建立，不计入测量
+    decoder.seek(1.0);
+
+    std::mt19937 random(42);
+    std::uniform_real_distribution<double> position(
+        0.0, BENCH_SIGNAL_SECONDS - 1.0);
+    for (auto _ : state) {
+        if (!decoder.seek(position(random)) ||
+            decoder.decodeNextFrame(frame.get()) < 0) {
+            state.SkipWithError("seek failed");
+            break;
+        }
+        av_frame_unref(frame.get());
+    }
+}
+
+// 打开耗时：每次迭代打开文件并打开解码器。range(0)为1时使用ProbeMode::FAST
+void BM_Open(benchmark::State &state, const char *codecName) {
+    AudioDecoderConfig config;
+    config.probeMode = state.range(0) ? ProbeMode::FAST : ProbeMode::FULL;
+    AudioDecoder decoder(config);
+    std::string path;
+    if (!openSignal(state, codecName, decoder, &path)) {
+        return;
+    }
+
+    for (auto _ : state) {
+        if (decoder.open(path) != AudioDecoderError::SUCCESS) {
+            state.SkipWithError("open failed");
+            break;
+        }
+    }
+}
+
+}  // namespace
+
+BENCHMARK_CAPTURE(BM_DecodeLoop, wav, "wav")->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_DecodeLoop, flac, "flac")->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_DecodeLoop, mp3, "mp3")->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_DecodeLoop, aac, "aac")->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_DecodeLoop, vorbis, "vorbis")
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_DecodeLoop, opus, "opus")->Unit(benchmark::kMillisecond);
+
+BENCHMARK_CAPTURE(BM_Seek, flac, "flac")
+    ->ArgName("indexed")
+    ->Arg(0)
+    ->Arg(1)
+    ->Unit(benchmark::kMicrosecond);
+BENCHMARK_CAPTURE(BM_Seek, mp3, "mp3")
+    ->ArgName("indexed")
+    ->Arg(0)
+    ->Arg(1)
+    ->Unit(benchmark::kMicrosecond);
+BENCHMARK_CAPTURE(BM_Seek, aac, "aac")
+    ->ArgName("indexed")
+    ->Arg(0)
+    ->Arg(1)
+    ->Unit(benchmark::kMicrosecond);
+
+BENCHMARK_CAPTURE(BM_Open, wav, "wav")
+    ->ArgName("fast")
+    ->Arg(0)
+    ->Arg(1)
+    ->Unit(benchmark::kMicrosecond);
+BENCHMARK_CAPTURE(BM_Open, flac, "flac")
+    ->ArgName("fast")
+    ->Arg(0)
+    ->Arg(1)
+    ->Unit(benchmark::kMicrosecond);
+BENCHMARK_CAPTURE(BM_Open, mp3, "mp3")
+    ->ArgName("fast")
+    ->Arg(0)
+    ->Arg(1)
+    ->Unit(benchmark::kMicrosecond);
+BENCHMARK_CAPTURE(BM_Open, aac, "aac")
+    ->ArgName("fast")
+    ->Arg(0)
+    ->Arg(1)
+    ->Unit(benchmark::kMicrosecond);
@@ -0,0 +1,24 @@
+#include <benchmark/benchmark.h>
+
+#include "logger.h"
+
+// 基准测试入口：日志只写文件且只保留警告，避免日志IO影响测量结果。
+// 结果可以通过--benchmark_format=json或--benchmark_out=<文件>输出为JSON
+int main(int argc, char **argv) {
+    Logger::LoggerConfig lconfig;
+    lconfig.filename = "logs/bench.log";
+    lconfig.level = Logger::Level::WARN;
+    lconfig.console_output = false;
+    lconfig.async_mode = true;
+    Logger::getInstance().initialize(lconfig);
+
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv)) {
+        return 1;
+    }
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+
+    Logger::getInstance().shutdown();
+    return 0;
+}
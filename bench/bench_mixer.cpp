@@ -0,0 +1,67 @@
+#include <benchmark/benchmark.h>
+
+#include <memory>
+#include <vector>
+
+#include "audio_mixer.h"
+#include "bench_signals.h"
+
+namespace {
+
+// 混音回调：range(0)个声部同时播放同一个1秒的缓存片段，每次混音1024帧，
+// 不打开设备；片段播放完之前在计时之外结束全部声部并重新开始
+void BM_MixVoices(benchmark::State &state) {
+    size_t voiceCount = static_cast<size_t>(state.range(0));
+    const size_t callbackFrames = 1024;
+
+    AudioMixerConfig config;
+    config.sampleRate = BENCH_SAMPLE_RATE;
+    config.maxVoices = voiceCount;
+    config.maxStreams = 0;
+    AudioMixer mixer(config);
+
+    auto clip = std::make_shared<PcmClip>();
+    clip->format = mixer.getOutputFormat();
+    auto planes = makeSinePlanes(BENCH_CHANNELS, BENCH_SAMPLE_RATE,
+                                 BENCH_SAMPLE_RATE);
+    std::vector<float> pcm(planes[0].size() * BENCH_CHANNELS);
+    for (size_t i = 0; i < planes[0].size(); i++) {
+        pcm[i * 2] = planes[0][i];
+        pcm[i * 2 + 1] = planes[1][i];
+    }
+    const auto *bytes = reinterpret_cast<const uint8_t *>(pcm.data());
+    clip->data.assign(bytes, bytes + pcm.size() * sizeof(float));
+
+    // 声像分散在左右之间，增益保证混音结果不会全部被限幅
+    auto startVoices = [&]() {
+        for (size_t i = 0; i < voiceCount; i++) {
+            VoiceParams params;
+            params.gain = 1.0f / voiceCount;
+            params.pan = voiceCount > 1 ? -1.0f + 2.0f * i / (voiceCount - 1)
+                                        : 0.0f;
+            mixer.play(clip, params);
+        }
+    };
+    startVoices();
+
+    std::vector<float> output(callbackFrames * BENCH_CHANNELS);
+    size_t restartInterval = clip->frames() / callbackFrames;
+    size_t callbacks = 0;
+    for (auto _ : state) {
+        mixer.mix(output.data(), callbackFrames);
+        benchmark::DoNotOptimize(output.data());
+        if (++callbacks % restartInterval == 0) {
+            state.PauseTiming();
+            mixer.close();  // 没有打开设备时只回收全部声部
+            startVoices();
+            state.ResumeTiming();
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * callbackFrames * voiceCount);
+    state.counters["voices"] = static_cast<double>(voiceCount);
+    state.SetLabel(AudioKernels::get().name);
+}
+
+}  // namespace
+
+BENCHMARK(BM_MixVoices)->RangeMultiplier(4)->Range(1, 1024);
@@ -0,0 +1,91 @@
+#include <benchmark/benchmark.h>
+
+#include "audio_kernels.h"
+#include "audio_resampler.h"
+#include "bench_signals.h"
+
+namespace {
+
+constexpr int FRAME_SAMPLES = 1024;  // 与常见解码器一帧的采样数相当
+
+// 重采样开销：与processDecodedFrame相同的调用方式，输入一帧、写入固定容量的块。
+// range(0)/range(1)为输入/输出采样率，range(2)为1时输出F32，否则输出S16
+void BM_Resample(benchmark::State &state) {
+    int inputRate = static_cast<int>(state.range(0));
+    AudioOutputFormat output;
+    output.sampleRate = static_cast<int>(state.range(1));
+    output.channels = BENCH_CHANNELS;
+    output.sampleFormat =
+        state.range(2) ? AV_SAMPLE_FMT_FLT : AV_SAMPLE_FMT_S16;
+
+    AudioResampler resampler;
+    if (!resampler.init(inputRate, BENCH_CHANNELS, AV_SAMPLE_FMT_FLTP,
+                        output)) {
+        state.SkipWithError("could not initialize resampler");
+        return;
+    }
+
+    auto planes = makeSinePlanes(BENCH_CHANNELS, FRAME_SAMPLES, inputRate);
+    const uint8_t *input[BENCH_CHANNELS];
+    for (int c = 0; c < BENCH_CHANNELS; c++) {
+        input[c] = reinterpret_cast<const uint8_t *>(planes[c].data());
+    }
+    int capacity = 4096;
+    std::vector<uint8_t> block(capacity * output.bytesPerFrame());
+
+    int64_t samples = 0;
+    for (auto _ : state) {
+        int inputSamples = FRAME_SAMPLES;
+        while (true) {
+            int converted = resampler.convert(input, inputSamples,
+                                              block.data(), capacity);
+            inputSamples = 0;
+            if (converted < capacity) {
+                break;
+            }
+        }
+        benchmark::DoNotOptimize(block.data());
+        samples += FRAME_SAMPLES;
+    }
+    state.SetItemsProcessed(samples);
+    state.SetLabel(resampler.isPassThrough() ? "pass-through"
+                   : inputRate == output.sampleRate ? "convert"
+                                                    : "resample");
+}
+
+// 平面转交错内核，range(0)为每次处理的采样帧数
+void BM_InterleaveKernel(benchmark::State &state) {
+    const AudioKernels &kernels = AudioKernels::get();
+    size_t frames = static_cast<size_t>(state.range(0));
+    auto planes = makeSinePlanes(BENCH_CHANNELS, static_cast<int>(frames),
+                                 BENCH_SAMPLE_RATE);
+    const float *input[BENCH_CHANNELS];
+    for (int c = 0; c < BENCH_CHANNELS; c++) {
+        input[c] = planes[c].data();
+    }
+    std::vector<float> output(frames * BENCH_CHANNELS);
+
+    for (auto _ : state) {
+        kernels.interleaveF32(input, 0, BENCH_CHANNELS, frames, 0.8f,
+                              output.data());
+        benchmark::DoNotOptimize(output.data());
+    }
+    state.SetItemsProcessed(state.iterations() * frames);
+    state.SetLabel(kernels.name);
+}
+
+}  // namespace
+
+// 常见的输入/输出采样率组合，分别输出S16和F32
+BENCHMARK(BM_Resample)
+    ->ArgNames({"in", "out", "f32"})
+    ->Args({48000, 48000, 0})
+    ->Args({48000, 48000, 1})
+    ->Args({44100, 48000, 0})
+    ->Args({44100, 48000, 1})
+    ->Args({48000, 44100, 0})
+    ->Args({96000, 48000, 0})
+    ->Args({96000, 48000, 1})
+    ->Args({22050, 48000, 0});
+
+BENCHMARK(BM_InterleaveKernel)->Arg(256)->Arg(1024)->Arg(4096);
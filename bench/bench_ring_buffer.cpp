@@ -0,0 +1,94 @@
+#include <benchmark/benchmark.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include "audio_kernels.h"
+#include "bench_signals.h"
+#include "spsc_ring_buffer.h"
+
+namespace {
+
+// 环形缓冲区与回调路径：生产者线程按解码线程的方式写入4096帧的块，
+// 测量线程按回调的方式取出range(0)帧并做音量处理，空间不足时补静音记为欠载。
+// range(1)为1时使用F32，否则使用S16
+void BM_RingBufferCallback(benchmark::State &state) {
+    size_t callbackFrames = static_cast<size_t>(state.range(0));
+    bool useFloat = state.range(1) != 0;
+    size_t sampleBytes = useFloat ? sizeof(float) : sizeof(int16_t);
+    size_t frameBytes = BENCH_CHANNELS * sampleBytes;
+    const AudioKernels &kernels = AudioKernels::get();
+
+    // 500ms的环形缓冲区，与播放器默认配置相同
+    SpscRingBuffer ring(BENCH_SAMPLE_RATE / 2 * frameBytes);
+    std::vector<uint8_t> block(4096 * frameBytes, 0x11);
+    std::vector<uint8_t> output(callbackFrames * frameBytes);
+
+    std::atomic<bool> running{true};
+    std::thread producer([&]() {
+        while (running.load(std::memory_order_relaxed)) {
+            size_t offset = 0;
+            while (offset < block.size() &&
+                   running.load(std::memory_order_relaxed)) {
+                size_t chunk = std::min(block.size() - offset,
+                                        ring.writeAvailable());
+                chunk -= chunk % frameBytes;
+                if (chunk == 0) {
+                    std::this_thread::yield();
+                    continue;
+                }
+                offset += ring.write(block.data() + offset, chunk);
+            }
+        }
+    });
+
+    // 先填满一半，模拟开始播放前的预缓冲
+    while (ring.readAvailable() < ring.capacity() / 2) {
+        std::this_thread::yield();
+    }
+
+    int64_t underruns = 0;
+    for (auto _ : state) {
+        size_t wanted = output.size();
+        size_t available = std::min(wanted, ring.readAvailable());
+        available -= available % frameBytes;
+
+        SpscRingBuffer::Span spans[2];
+        size_t copied = ring.peek(available, spans[0], spans[1]);
+        uint8_t *out = output.data();
+        for (const auto &span : spans) {
+            size_t samples = span.size / sampleBytes;
+            if (useFloat) {
+                kernels.gainF32(reinterpret_cast<const float *>(span.data),
+                                reinterpret_cast<float *>(out), samples, 0.8f);
+            } else {
+                kernels.gainS16(reinterpret_cast<const int16_t *>(span.data),
+                                reinterpret_cast<int16_t *>(out), samples,
+                                0.8f);
+            }
+            out += span.size;
+        }
+        ring.consume(copied);
+        if (copied < wanted) {
+            std::memset(out, 0, wanted - copied);
+            underruns++;
+        }
+        benchmark::DoNotOptimize(output.data());
+    }
+
+    running = false;
+    producer.join();
+
+    state.SetBytesProcessed(state.iterations() * output.size());
+    state.counters["underruns"] = static_cast<double>(underruns);
+    state.SetLabel(kernels.name);
+}
+
+}  // namespace
+
+BENCHMARK(BM_RingBufferCallback)
+    ->ArgNames({"frames", "f32"})
+    ->ArgsProduct({{64, 256, 1024, 4096}, {0, 1}});
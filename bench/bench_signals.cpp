@@ -0,0 +1,266 @@
+#include "bench_signals.h"
+
+#include <cmath>
+#include <filesystem>
+#include <map>
+#include <memory>
+#include <mutex>
+
+#include "audio_decoder.h"
+
+namespace {
+
+constexpr double PI = 3.14159265358979323846;
+
+// 输出封装上下文需要先关闭IO再释放，与解码器的FormatContextDeleter不同
+struct OutputContextDeleter {
+    void operator()(AVFormatContext *ctx) {
+        if (ctx) {
+            if (ctx->pb && !(ctx->oformat->flags & AVFMT_NOFILE)) {
+                avio_closep(&ctx->pb);
+            }
+            avformat_free_context(ctx);
+        }
+    }
+};
+
+using OutputContextPtr = std::unique_ptr<AVFormatContext, OutputContextDeleter>;
+
+std::string errorString(int errnum) {
+    char buf[AV_ERROR_MAX_STRING_SIZE];
+    av_strerror(errnum, buf, sizeof(buf));
+    return buf;
+}
+
+// 选择编码器支持的第一种采样格式
+AVSampleFormat encoderSampleFormat(const AVCodec *codec) {
+#if LIBAVCODEC_VERSION_INT >= AV_VERSION_INT(61, 13, 100)
+    const void *formats = nullptr;
+    int count = 0;
+    if (avcodec_get_supported_config(nullptr, codec,
+                                     AV_CODEC_CONFIG_SAMPLE_FORMAT, 0,
+                                     &formats, &count) >= 0 &&
+        count > 0) {
+        return static_cast<const AVSampleFormat *>(formats)[0];
+    }
+#else
+    if (codec->sample_fmts) {
+        return codec->sample_fmts[0];
+    }
+#endif
+    return AV_SAMPLE_FMT_S16;
+}
+
+// 把[-1, 1]的浮点样本按帧的采样格式写入
+void storeSample(AVFrame *frame, int channel, int index, double value) {
+    AVSampleFormat format = static_cast<AVSampleFormat>(frame->format);
+    bool planar = av_sample_fmt_is_planar(format);
+    int channels = frame->ch_layout.nb_channels;
+    int plane = planar ? channel : 0;
+    int offset = planar ? index : index * channels + channel;
+    uint8_t *data = frame->extended_data[plane];
+
+    switch (av_get_packed_sample_fmt(format)) {
+        case AV_SAMPLE_FMT_FLT:
+            reinterpret_cast<float *>(data)[offset] =
+                static_cast<float>(value);
+            break;
+        case AV_SAMPLE_FMT_DBL:
+            reinterpret_cast<double *>(data)[offset] = value;
+            break;
+        case AV_SAMPLE_FMT_S32:
+            reinterpret_cast<int32_t *>(data)[offset] =
+                static_cast<int32_t>(value * 2147483647.0);
+            break;
+        default:
+            reinterpret_cast<int16_t *>(data)[offset] =
+                static_cast<int16_t>(value * 32767.0);
+            break;
+    }
+}
+
+// 把编码器输出的数据包全部写入文件
+int drainEncoder(AVCodecContext *codecCtx, AVFormatContext *formatCtx,
+                 AVStream *stream, AVPacket *packet) {
+    while (true) {
+        int ret = avcodec_receive_packet(codecCtx, packet);
+        if (ret == AVERROR(EAGAIN) || ret == AVERROR_EOF) {
+            return 0;
+        }
+        if (ret < 0) {
+            return ret;
+        }
+        av_packet_rescale_ts(packet, codecCtx->time_base, stream->time_base);
+        packet->stream_index = stream->index;
+        ret = av_interleaved_write_frame(formatCtx, packet);
+        if (ret < 0) {
+            return ret;
+        }
+    }
+}
+
+bool encodeSignal(const BenchCodec &codec, const std::string &path,
+                  std::string &error) {
+    const AVCodec *encoder = avcodec_find_encoder_by_name(codec.encoder);
+    if (!encoder) {
+        error = std::string("encoder not available: ") + codec.encoder;
+        return false;
+    }
+
+    AVFormatContext *rawFormat = nullptr;
+    int ret = avformat_alloc_output_context2(&rawFormat, nullptr,
+                                             codec.container, path.c_str());
+    if (ret < 0 || !rawFormat) {
+        error = "could not create container: " + errorString(ret);
+        return false;
+    }
+    OutputContextPtr formatCtx(rawFormat);
+
+    AudioDecoder::CodecContextPtr codecCtx(avcodec_alloc_context3(encoder));
+    codecCtx->sample_fmt = encoderSampleFormat(encoder);
+    codecCtx->sample_rate = BENCH_SAMPLE_RATE;
+    av_channel_layout_default(&codecCtx->ch_layout, BENCH_CHANNELS);
+    codecCtx->bit_rate = 160000;
+    codecCtx->time_base = AVRational{1, BENCH_SAMPLE_RATE};
+    // FFmpeg自带的vorbis编码器仍标记为实验性
+    codecCtx->strict_std_compliance = FF_COMPLIANCE_EXPERIMENTAL;
+    if (formatCtx->oformat->flags & AVFMT_GLOBALHEADER) {
+        codecCtx->flags |= AV_CODEC_FLAG_GLOBAL_HEADER;
+    }
+    ret = avcodec_open2(codecCtx.get(), encoder, nullptr);
+    if (ret < 0) {
+        error = "could not open encoder: " + errorString(ret);
+        return false;
+    }
+
+    AVStream *stream = avformat_new_stream(formatCtx.get(), nullptr);
+    avcodec_parameters_from_context(stream->codecpar, codecCtx.get());
+    stream->time_base = codecCtx->time_base;
+
+    if (!(formatCtx->oformat->flags & AVFMT_NOFILE)) {
+        ret = avio_open(&formatCtx->pb, path.c_str(), AVIO_FLAG_WRITE);
+        if (ret < 0) {
+            error = "could not open output: " + errorString(ret);
+            return false;
+        }
+    }
+    ret = avformat_write_header(formatCtx.get(), nullptr);
+    if (ret < 0) {
+        error = "could not write header: " + errorString(ret);
+        return false;
+    }
+
+    // 可变帧长的编码器（PCM、FLAC）没有固定frame_size
+    int frameSize = codecCtx->frame_size > 0 ? codecCtx->frame_size : 1024;
+    AudioDecoder::FramePtr frame(av_frame_alloc());
+    AudioDecoder::PacketPtr packet(av_packet_alloc());
+    int64_t total =
+        static_cast<int64_t>(BENCH_SIGNAL_SECONDS * BENCH_SAMPLE_RATE);
+
+    for (int64_t pts = 0; pts < total; pts += frameSize) {
+        frame->nb_samples = static_cast<int>(
+            std::min<int64_t>(frameSize, total - pts));
+        // 固定帧长的编码器每帧都必须是frame_size，最后一帧多编码几个样本
+        if (codecCtx->frame_size > 0 &&
+            !(encoder->capabilities & AV_CODEC_CAP_VARIABLE_FRAME_SIZE)) {
+            frame->nb_samples = frameSize;
+        }
+        frame->format = codecCtx->sample_fmt;
+        frame->sample_rate = BENCH_SAMPLE_RATE;
+        av_channel_layout_copy(&frame->ch_layout, &codecCtx->ch_layout);
+        if (av_frame_get_buffer(frame.get(), 0) < 0) {
+            error = "could not allocate frame";
+            return false;
+        }
+
+        for (int i = 0; i < frame->nb_samples; i++) {
+            double t = static_cast<double>(pts + i) / BENCH_SAMPLE_RATE;
+            for (int c = 0; c < BENCH_CHANNELS; c++) {
+                double frequency = 440.0 * (c + 1);
+                storeSample(frame.get(), c, i,
+                            0.5 * std::sin(2.0 * PI * frequency * t));
+            }
+        }
+        frame->pts = pts;
+
+        ret = avcodec_send_frame(codecCtx.get(), frame.get());
+        av_frame_unref(frame.get());
+        if (ret < 0 || (ret = drainEncoder(codecCtx.get(), formatCtx.get(),
+                                           stream, packet.get())) < 0) {
+            error = "encoding failed: " + errorString(ret);
+            return false;
+        }
+    }
+
+    // 冲刷编码器
+    avcodec_send_frame(codecCtx.get(), nullptr);
+    ret = drainEncoder(codecCtx.get(), formatCtx.get(), stream, packet.get());
+    if (ret < 0 || av_write_trailer(formatCtx.get()) < 0) {
+        error = "could not finish file: " + errorString(ret);
+        return false;
+    }
+    return true;
+}
+
+}  // namespace
+
+const std::vector<BenchCodec> &benchCodecs() {
+    static const std::vector<BenchCodec> codecs = {
+        {"wav", "pcm_s16le", "wav", "wav"},
+        {"flac", "flac", "flac", "flac"},
+        {"mp3", "libmp3lame", "mp3", "mp3"},
+        {"aac", "aac", "adts", "aac"},
+        {"vorbis", "vorbis", "ogg", "ogg"},
+        {"opus", "libopus", "ogg", "opus"},
+    };
+    return codecs;
+}
+
+const BenchCodec *findBenchCodec(const std::string &name) {
+    for (const auto &codec : benchCodecs()) {
+        if (name == codec.name) {
+            return &codec;
+        }
+    }
+    return nullptr;
+}
+
+std::string benchSignalFile(const BenchCodec &codec, std::string &error) {
+    static std::mutex mutex;
+    static std::map<std::string, std::string> files;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = files.find(codec.name);
+    if (it != files.end()) {
+        return it->second;
+    }
+
+    std::filesystem::path dir =
+        std::filesystem::temp_directory_path() / "texas_bench";
+    std::filesystem::create_directories(dir);
+    std::string path =
+        (dir / (std::string("signal_") + codec.name + "." + codec.extension))
+            .string();
+
+    // 不同进程之间也复用已生成的文件
+    if (!std::filesystem::exists(path) && !encodeSignal(codec, path, error)) {
+        std::filesystem::remove(path);
+        return "";
+    }
+    files[codec.name] = path;
+    return path;
+}
+
+std::vector<std::vector<float>> makeSinePlanes(int channels, int samples,
+                                               int sampleRate) {
+    std::vector<std::vector<float>> planes(channels,
+                                           std::vector<float>(samples));
+    for (int c = 0; c < channels; c++) {
+        double frequency = 440.0 * (c + 1);
+        for (int i = 0; i < samples; i++) {
+            planes[c][i] = static_cast<float>(
+                0.5 * std::sin(2.0 * PI * frequency * i / sampleRate));
+        }
+    }
+    return planes;
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+// 基准测试使用的编码格式
+struct BenchCodec {
+    const char *name;       // 基准测试名称中使用的短名
+    const char *encoder;    // FFmpeg编码器名
+    const char *container;  // FFmpeg封装格式名
+    const char *extension;  // 文件扩展名
+};
+
+// 参与测试的编码格式，运行时缺少编码器的格式会被跳过
+const std::vector<BenchCodec> &benchCodecs();
+const BenchCodec *findBenchCodec(const std::string &name);
+
+// 测试信号的参数，所有编码格式相同，便于横向比较
+constexpr int BENCH_SAMPLE_RATE = 48000;
+constexpr int BENCH_CHANNELS = 2;
+constexpr double BENCH_SIGNAL_SECONDS = 30.0;
+
+// 获取指定编码格式的测试信号文件（两个声道为不同频率的正弦波），
+// 第一次调用时编码写入临时目录，之后复用；失败时返回空字符串并写入error
+std::string benchSignalFile(const BenchCodec &codec, std::string &error);
+
+// 生成平面浮点格式的正弦信号，用于不经过解码器的测试
+std::vector<std::vector<float>> makeSinePlanes(int channels, int samples,
+                                               int sampleRate);
@@ -1,9 +1,10 @@
 #pragma once
 
+#include <atomic>
+#include <cmath>
 #include <condition_variable>
 #include <memory>
 #include <mutex>
-#include <queue>
 #include <string>
 #include <thread>
 
@@ -16,6 +17,15 @@ extern "C" {
 }
 #include <spdlog/logger.h>
 
+#include "fixed_queue.h"
+#include "frame_pool.h"
+#include "latency_histogram.h"
+#include "media_info_cache.h"
+#include "media_input.h"
+#include "packet_prefetcher.h"
+#include "seek_index.h"
+#include "thread_scheduling.h"
+
 // 自定义删除器，用于智能指针管理
 struct FormatContextDeleter {
     void operator()(AVFormatContext *ctx) {
@@ -33,11 +43,71 @@ struct CodecContextDeleter {
     }
 };
 
+struct PacketDeleter {
+    void operator()(AVPacket *packet) {
+        if (packet) {
+            av_packet_free(&packet);
+        }
+    }
+};
+
+struct FrameDeleter {
+    void operator()(AVFrame *frame) {
+        if (frame) {
+            av_frame_free(&frame);
+        }
+    }
+};
+
+// 定位索引的建立时机
+enum class SeekIndexMode {
+    DISABLED,       // 不使用索引，按时间戳定位到之前的关键帧
+    ON_FIRST_SEEK,  // 第一次定位时同步建立
+    ON_OPEN         // 打开文件后在后台线程建立
+};
+
+// 打开文件时的流信息探测方式
+enum class ProbeMode {
+    FULL,  // 总是调用avformat_find_stream_info，解码各个流的开头确定参数
+    FAST   // 容器头部的音频参数完整可信时跳过探测，不可信时回退到FULL
+};
+
+// 解码器内部的多线程方式，只对声明支持对应方式的解码器生效
+enum class CodecThreading {
+    FRAME,           // 多帧并行解码，每个线程多缓存一帧，增加首帧和定位后的延迟
+    SLICE,           // 一帧内按片并行，不增加延迟
+    FRAME_AND_SLICE  // 由FFmpeg按解码器能力选择
+};
+
 // 解码器配置结构体
+// 帧队列的三种上限可以同时设置，任意一个达到即视为队列已满，0表示不限制
 struct AudioDecoderConfig {
-    size_t maxQueueSize = 100;        // 最大帧队列大小
+    size_t maxQueueSize = 100;        // 最大帧队列大小（帧数）
+    size_t maxQueueBytes = 0;         // 最大帧队列大小（解码后PCM字节数）
+    int maxQueueDurationMs = 0;       // 最大帧队列大小（音频时长，毫秒）
     bool dropFramesWhenFull = false;  // 队列满时是否丢弃帧
     int timeoutMs = -1;               // 获取帧超时时间（毫秒），-1为无限等待
+    SeekIndexMode seekIndexMode = SeekIndexMode::DISABLED;  // 定位索引
+    bool cacheSeekIndex = true;  // 把定位索引缓存到音频文件旁的.tsidx文件
+    bool accurateSeek = true;    // 定位后丢弃目标时间之前的样本，精确到采样
+    bool memoryMapInput = true;  // 本地文件映射到内存读取，失败时回退到文件IO
+    PrefetchConfig prefetch;     // 数据包预读、抖动缓冲和断线重连
+
+    // 打开速度：探测读取的数据量和时长上限，0为FFmpeg默认（5MB/5秒）
+    ProbeMode probeMode = ProbeMode::FAST;
+    int64_t probeSizeBytes = 0;
+    int analyzeDurationMs = 0;
+
+    // 解码器内部线程数：1为单线程，0为按CPU核心数自动选择。
+    // 高采样率FLAC、DSD和多声道TrueHD等单线程解码接近实时的格式可以开启
+    int codecThreads = 1;
+    CodecThreading codecThreading = CodecThreading::FRAME_AND_SLICE;
+    // 解码线程的CPU亲和性和优先级
+    ThreadSchedulingPolicy decodeScheduling;
+
+    // 探测结果和定位索引的持久缓存，可在多个解码器间共享，为空时不使用。
+    // 命中时打开文件只读取容器头部；设置后定位索引保存在这里而不是.tsidx文件
+    std::shared_ptr<MediaInfoCache> mediaInfoCache;
 };
 
 // 解码器错误枚举
@@ -52,6 +122,9 @@ enum class AudioDecoderError {
     CODEC_OPEN_ERROR
 };
 
+// 错误码的文字描述
+const char *audioDecoderErrorString(AudioDecoderError error);
+
 class AudioDecoder {
    public:
     // 使用类型别名定义智能指针
@@ -59,6 +132,8 @@ class AudioDecoder {
         std::unique_ptr<AVFormatContext, FormatContextDeleter>;
     using CodecContextPtr =
         std::unique_ptr<AVCodecContext, CodecContextDeleter>;
+    using PacketPtr = std::unique_ptr<AVPacket, PacketDeleter>;
+    using FramePtr = std::unique_ptr<AVFrame, FrameDeleter>;
 
     explicit AudioDecoder(
         const AudioDecoderConfig &config = AudioDecoderConfig());
@@ -66,6 +141,10 @@ class AudioDecoder {
 
     // 文件操作
     AudioDecoderError open(const std::string &filename);
+    // 从调用方持有的内存解码，不复制数据，data在close()或下次open()前必须有效
+    // name只作为格式探测的提示（如扩展名），内存输入不使用定位索引
+    AudioDecoderError open(const uint8_t *data, size_t size,
+                           const std::string &name = "");
     void close();
 
     // 解码控制
@@ -73,9 +152,32 @@ class AudioDecoder {
     void stop();
     void flush();
 
-    // 帧操作
+    // 同步解码：在调用线程上读取并解码下一帧，不经过解码线程和帧队列
+    // 返回0表示成功，AVERROR_EOF表示解码完毕，其他负值为错误
+    // 不能与start()启动的解码线程同时使用
+    int decodeNextFrame(AVFrame *frame);
+
+    // 帧操作：取出的帧用完后必须通过releaseFrame归还到帧池
     bool getAudioFrame(AVFrame **frame, int timeout_ms = -1);
+    // 等待队列中有帧但不取出，超时或解码结束时返回false
+    bool waitForFrame(int timeout_ms);
+    void releaseFrame(AVFrame *frame);
     size_t getQueueSize();
+    // 解码线程已读到文件末尾且队列中的帧都已取走
+    bool isFinished();
+    size_t getQueuedBytes();        // 队列中解码后PCM的字节数
+    double getQueuedDurationMs();   // 队列中音频的时长（毫秒）
+    size_t getQueueHighWater() const;  // 打开文件以来队列的最大帧数
+
+    // 解码线程把每帧的解码耗时记录到histogram，需在start()之前设置，
+    // histogram的生命周期由调用方保证不短于解码器
+    void setDecodeHistogram(LatencyHistogram *histogram);
+
+    // 预读缓冲的填充状态，未开启预读时active为false
+    PrefetchStats getPrefetchStats();
+
+    // 累计内存分配次数（帧池和帧队列），稳态解码时应保持不变
+    uint64_t getAllocationCount() const;
 
     // 设置与获取
     void setConfig(const AudioDecoderConfig &config);
@@ -84,40 +186,109 @@ class AudioDecoder {
     int getSampleRate() const;
     int getChannels() const;
     uint64_t getChannelLayout() const;
+    // 解码输出的完整声道布局，可能不是按掩码表示的顺序；未打开时为nullptr
+    const AVChannelLayout *getChannelLayoutInfo() const;
     AVSampleFormat getSampleFormat() const;
     double getDuration() const;
+    // 文件标签中的曲目增益（dB，参考-18 LUFS），没有标签时为NaN
+    double getTrackGainDb() const;
+    // 以上参数的汇总，可写入MediaInfoCache
+    MediaInfo getMediaInfo() const;
     double getCurrentTimestamp() const;
     AVRational getTimeBase() const;
 
-    // 定位操作
+    // 定位操作，解码线程运行时会先停下，定位后自动恢复
     bool seek(double seconds);
+    bool hasSeekIndex();
+
+    // 数据包由预读线程读取（网络输入，或强制开启预读），decodeNextFrame可能
+    // 长时间阻塞在抖动缓冲上
+    bool isPrefetched() const { return shouldPrefetch(); }
 
    private:
     void cleanup();
+    void resetInput();
+    AudioDecoderError openInput(const std::string &url);
+    AudioDecoderError openCodec();
+    bool isHeaderTrusted() const;
+    int openFormat(const std::string &url, AVFormatContext **formatCtx);
+    static int interruptCallback(void *opaque);
     void decodeLoop();
+    bool trimToSeekTarget(AVFrame *frame);
+    int64_t ptsToSamples(int64_t pts) const;
+    int64_t samplesToPts(int64_t samples) const;
+
+    // 预读：预读线程运行时独占formatContext，解码线程从预读缓冲取数据包
+    bool isNetworkInput() const;
+    bool shouldPrefetch() const;
+    int readAudioPacket(AVPacket *packet);
+    int reconnectInput();
+    PacketPrefetcher prefetcher;
+    int64_t lastPacketPts{AV_NOPTS_VALUE};  // 最后读到的数据包时间戳
+    int64_t resumePts{AV_NOPTS_VALUE};  // 重连后丢弃不晚于此时间戳的数据包
+
+    // 定位索引
+    static constexpr double SEEK_INDEX_INTERVAL = 0.1;  // 索引条目间隔（秒）
+    static constexpr double SEEK_PREROLL = 0.1;  // 定位提前量，让解码器预热
+    std::shared_ptr<const SeekIndex> loadOrBuildSeekIndex();
+    std::shared_ptr<const SeekIndex> readSeekIndex();
+    void cancelSeekIndexBuild();
+    std::string currentFile;
+    FileIdentity fileIdentity;  // 本地文件打开时的大小和修改时间
+    bool hasFileIdentity{false};
+    std::shared_ptr<const SeekIndex> seekIndex;
+    std::mutex seekIndexMutex;
+    std::thread seekIndexThread;
+    std::atomic<bool> cancelIndexBuild{false};
+
+    // 精确定位：sampleClock>=0时按解码出的样本数推算时间戳（按字节定位后
+    // 解复用器无法给出时间戳），seekTargetSamples>=0时丢弃目标之前的样本
+    int64_t sampleClock{-1};
+    int64_t seekTargetSamples{-1};
     bool pushFrame(AVFrame *frame);
+    void enqueueFrame(AVFrame *frame);
+    AVFrame *dequeueFrame();
+    void clearQueue();
+    bool isQueueFull() const;
 
     // 配置
     AudioDecoderConfig config;
 
-    // FFmpeg组件
+    // FFmpeg组件，input须在formatContext之后销毁
+    std::unique_ptr<MediaInput> input;
     FormatContextPtr formatContext;
     CodecContextPtr codecContext;
     const AVCodec *codec{nullptr};
     int audioStreamIndex{-1};
+    // 打开时记录，重连替换formatContext后其他线程读取的仍然有效
+    AVRational streamTimeBase{0, 1};
+    double streamDuration{0.0};
+    double trackGainDb{NAN};
 
-    // 线程控制
+    // 线程控制。isDecoding在frameQueueMutex内清除，等待队列的线程不会
+    // 错过停止通知
     std::thread decoderThread;
-    bool isDecoding{false};
+    std::atomic<bool> isDecoding{false};
+    bool endOfStream{false};  // 解码线程已结束，受frameQueueMutex保护
 
-    // 帧队列
-    std::queue<AVFrame *> frameQueue;
+    // 帧队列与帧池
+    FixedQueue<AVFrame *> frameQueue;
+    AVFramePool framePool;
+    std::atomic<uint64_t> queueAllocations{0};
+    size_t queuedBytes{0};    // 队列中帧数据的总字节数
+    int64_t queuedSamples{0};  // 队列中帧的总采样数
+    std::atomic<size_t> queueHighWater{0};
+    LatencyHistogram *decodeHistogram{nullptr};
     std::mutex frameQueueMutex;
     std::condition_variable frameAvailable;
     std::condition_variable queueNotFull;
 
+    // 数据包复用，解码结束后进入排空状态
+    PacketPtr packet;
+    bool draining{false};
+
     // 时间戳
-    double currentPts{0.0};
+    std::atomic<double> currentPts{0.0};
 
     // 日志
     std::shared_ptr<spdlog::logger> _logger;
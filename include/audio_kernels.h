@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// 音频处理内核：平面转交错、增益、限幅、混音和电平统计。
+// 运行时检测CPU特性选择AVX2（x86）或NEON（ARM）实现，否则使用标量实现。
+// 所有内核都不分配内存、不加锁，可以在音频回调中调用
+struct AudioKernels {
+    // 把planes[c][offset...]的平面数据转为交错数据，乘以增益并限幅到[-1, 1]
+    void (*interleaveF32)(const float *const *planes, size_t offset,
+                          int channels, size_t frames, float gain, float *out);
+
+    // 乘以增益并限幅，in和out可以是同一块内存；count为样本数（不是帧数）
+    void (*gainF32)(const float *in, float *out, size_t count, float gain);
+    void (*gainS16)(const int16_t *in, int16_t *out, size_t count, float gain);
+
+    // 增益按采样帧从startGain线性变化到endGain，用于欠载后的淡入
+    void (*rampF32)(const float *in, float *out, size_t frames, int channels,
+                    float startGain, float endGain);
+    void (*rampS16)(const int16_t *in, int16_t *out, size_t frames,
+                    int channels, float startGain, float endGain);
+
+    // 把双声道交错数据乘以左右声道增益后累加到out，不限幅；
+    // 增益按采样帧从start线性变化到end，用于声部的音量、声像变化和淡出
+    void (*mixStereoF32)(const float *in, float *out, size_t frames,
+                         float leftStart, float rightStart, float leftEnd,
+                         float rightEnd);
+
+    // 样本绝对值的最大值与*peak比较后写回，平方和累加到*sumSquares；
+    // count为样本数，用于峰值和RMS统计
+    void (*peakF32)(const float *in, size_t count, float *peak,
+                    double *sumSquares);
+
+    const char *name;  // 选中的实现："avx2"、"neon"或"scalar"
+
+    // 第一次调用时完成检测，之后返回同一组内核
+    static const AudioKernels &get();
+    // 标量实现，用于校验和对比
+    static const AudioKernels &scalar();
+};
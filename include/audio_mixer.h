@@ -0,0 +1,169 @@
+#pragma once
+
+#include <SDL2/SDL.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "audio_decoder.h"
+#include "audio_kernels.h"
+#include "audio_resampler.h"
+#include "latency_histogram.h"
+#include "pcm_cache.h"
+#include "spsc_ring_buffer.h"
+
+// 声部句柄，0为无效句柄；声部结束后句柄失效，不会指向之后复用同一位置的声部
+using VoiceId = uint32_t;
+constexpr VoiceId INVALID_VOICE = 0;
+
+// 混音器配置，声部和流式解码槽位在构造时全部分配
+struct AudioMixerConfig {
+    int sampleRate = 48000;          // 输出采样率，固定为双声道F32
+    size_t maxVoices = 256;          // 同时播放的声部上限
+    size_t maxStreams = 16;          // 其中由解码器流式解码的声部上限
+    int deviceBufferSamples = 1024;  // 设备缓冲采样数
+    int streamBufferMs = 250;        // 每个流式声部的PCM缓冲时长
+    // 按文件名播放时先查找缓存，短文件解码一次后放入缓存
+    std::shared_ptr<PcmCache> pcmCache;
+};
+
+struct VoiceParams {
+    float gain = 1.0f;  // 线性增益
+    float pan = 0.0f;   // 声像，-1为最左，1为最右，按等功率分配
+};
+
+struct MixerStats {
+    size_t activeVoices{0};
+    size_t peakVoices{0};
+    uint64_t callbacks{0};
+    uint64_t voiceUnderruns{0};  // 流式声部的缓冲在回调中被读空的次数
+    uint64_t rejectedVoices{0};  // 声部或解码槽位用尽而拒绝的播放请求
+    LatencySummary callback;     // 每次混音的耗时（纳秒）
+};
+
+// 软件混音器：任意多个声部共用一个SDL设备和一个回调。
+// 声部的数据来自缓存的PCM片段（回调直接读取共享内存）或流式解码，
+// 所有流式声部由同一个填充线程解码，总共只有回调和填充两个线程。
+// 回调中不分配内存、不加锁，用SIMD内核把各声部按增益和声像累加到输出
+class AudioMixer {
+   public:
+    explicit AudioMixer(const AudioMixerConfig &config = AudioMixerConfig());
+    ~AudioMixer();
+
+    AudioMixer(const AudioMixer &) = delete;
+    AudioMixer &operator=(const AudioMixer &) = delete;
+
+    // 打开音频设备并启动填充线程
+    bool open();
+    void close();
+
+    // 播放缓存的片段，片段必须是getOutputFormat()格式；不分配内存
+    VoiceId play(std::shared_ptr<const PcmClip> clip,
+                 const VoiceParams &params = VoiceParams());
+    // 播放文件：命中缓存或能放入缓存时按片段播放，否则占用一个流式解码槽位
+    VoiceId play(const std::string &filename,
+                 const VoiceParams &params = VoiceParams());
+
+    // 在下一次回调内淡出后释放声部
+    void stop(VoiceId voice);
+    void stopAll();
+    bool setGain(VoiceId voice, float gain);
+    bool setPan(VoiceId voice, float pan);
+    bool isPlaying(VoiceId voice);
+    void setMasterGain(float gain);
+
+    AudioOutputFormat getOutputFormat() const;
+    MixerStats getStats() const;
+
+    // 混音frames帧写入out（双声道交错）。open()后由设备回调调用；
+    // 不打开设备时可以直接调用，用于无设备输出和基准测试。不能与回调同时调用
+    void mix(float *out, size_t frames);
+    // 不打开设备时手动执行一次填充线程的工作：解码流式声部并回收结束的声部
+    void service();
+
+   private:
+    static constexpr int CHANNELS = 2;
+    static constexpr int STREAM_CHUNK_SAMPLES = 1024;  // 流式解码每次转换的帧数
+
+    enum VoiceState : int { FREE, PLAYING, STOPPING, FINISHED };
+
+    // 流式解码槽位：解码器在填充线程上同步解码，经重采样写入声部自己的缓冲
+    struct StreamSlot {
+        AudioDecoder decoder;
+        AudioResampler resampler;
+        SpscRingBuffer ring;
+        AudioDecoder::FramePtr frame;
+        std::vector<uint8_t> scratch;
+        bool hasFrame{false};  // frame仍被重采样器引用
+        bool draining{false};  // 已解码完毕，正在冲刷重采样器
+        std::atomic<bool> active{false};
+        std::atomic<bool> finished{false};  // 所有PCM都已写入缓冲
+    };
+
+    struct Voice {
+        std::atomic<int> state{FREE};
+        std::atomic<float> gain{1.0f};
+        std::atomic<float> pan{0.0f};
+        uint16_t generation{0};  // 持有voiceMutex时修改
+
+        // 片段数据：控制线程持有引用，回调只读裸指针
+        std::shared_ptr<const PcmClip> clipRef;
+        const float *clipData{nullptr};
+        size_t clipFrames{0};
+        StreamSlot *stream{nullptr};
+
+        // 以下只由回调访问
+        size_t position{0};
+        float leftGain{0.0f};  // 上次回调结束时的声道增益
+        float rightGain{0.0f};
+    };
+
+    static void audioCallback(void *userdata, Uint8 *stream, int len);
+    VoiceId startVoice(std::shared_ptr<const PcmClip> clip,
+                       StreamSlot *stream, const VoiceParams &params);
+    Voice *findVoice(VoiceId voice);  // 调用方需持有voiceMutex
+    bool mixClip(Voice &voice, float *out, size_t frames, float left,
+                 float right);
+    bool mixStream(Voice &voice, float *out, size_t frames, float left,
+                   float right);
+    void fillStream(StreamSlot &slot);
+    void reclaimVoices();
+    void feederLoop();
+
+    AudioMixerConfig config;
+    const AudioKernels &kernels;
+
+    std::unique_ptr<Voice[]> voices;
+    std::unique_ptr<StreamSlot[]> streams;
+    std::mutex voiceMutex;            // 控制线程与填充线程之间，回调不使用
+    std::vector<size_t> freeVoices;   // 容量预留为maxVoices
+    std::vector<size_t> freeStreams;  // 容量预留为maxStreams
+
+    std::atomic<float> masterGain{1.0f};
+
+    SDL_AudioDeviceID audioDevice{0};
+    bool sdlInitialized{false};
+
+    std::thread feederThread;
+    std::mutex feederMutex;
+    std::condition_variable feederWakeup;
+    bool isFeederRunning{false};
+    int feederIntervalMs{10};
+
+    // 统计
+    std::atomic<size_t> activeVoices{0};
+    std::atomic<size_t> peakVoices{0};
+    std::atomic<uint64_t> callbackCount{0};
+    std::atomic<uint64_t> voiceUnderruns{0};
+    std::atomic<uint64_t> rejectedVoices{0};
+    LatencyHistogram callbackHistogram;
+
+    std::shared_ptr<spdlog::logger> _logger;
+};
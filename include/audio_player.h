@@ -2,34 +2,146 @@
 
 #include <SDL2/SDL.h>
 
+#include <atomic>
 #include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
 #include <memory>
 #include <mutex>
-#include <queue>
+#include <string>
+#include <thread>
 #include <vector>
 
 #include "audio_decoder.h"
+#include "audio_kernels.h"
+#include "audio_resampler.h"
+#include "buffer_controller.h"
+#include "frame_pool.h"
+#include "latency_histogram.h"
+#include "loudness_meter.h"
+#include "pcm_cache.h"
+#include "playback_clock.h"
+#include "player_stats.h"
+#include "rt_event_ring.h"
+#include "spsc_ring_buffer.h"
+#include "thread_scheduling.h"
+#include "wav_writer.h"
 
-// 添加 FFmpeg 重采样相关头文件
-extern "C" {
-#include <libavutil/channel_layout.h>
-#include <libavutil/opt.h>
-#include <libavutil/samplefmt.h>
-#include <libswresample/swresample.h>
-}
+// 无设备模式的输出回调，返回false时停止渲染
+using AudioSinkCallback = std::function<bool(const uint8_t *data, size_t size)>;
+
+// 输出采样格式
+enum class OutputSampleFormat {
+    AUTO,  // 源文件为浮点格式（AAC、Opus、Vorbis等）时用F32，否则用S16
+    S16,
+    F32
+};
+
+// 解码流水线
+enum class PipelineMode {
+    THREADED,  // 解码器线程经帧队列交给播放器线程重采样，每帧两次线程交接
+    DIRECT,    // 播放器线程直接解码和重采样后写入环形缓冲区，缓冲区满时按周期检查
+    ON_DEMAND  // 同DIRECT，缓冲区满后休眠到回调发现缓冲区降到一半时唤醒
+};
+
+// 播放器配置结构体
+struct AudioPlayerConfig {
+    // 无设备模式：不初始化SDL也不打开音频设备，通过render()以CPU允许的
+    // 最快速度解码和重采样，输出写入文件或交给回调
+    bool headless = false;
+    int outputSampleRate = 0;  // 无设备模式输出采样率，0为与源文件相同
+    int outputChannels = 0;    // 无设备模式输出声道数，0为与源文件相同
+    std::string outputFile;    // 无设备模式输出WAV文件路径，为空则不写文件
+    AudioSinkCallback sink;    // 无设备模式输出回调，可为空
+    OutputSampleFormat sampleFormat = OutputSampleFormat::AUTO;  // 输出格式
+
+    // 延迟配置：两者都为0时使用默认的4096采样设备缓冲和500ms环形缓冲。
+    // 设置后设备缓冲、环形缓冲和解码器预读深度都按目标延迟缩小
+    int targetLatencyMs = 0;      // 目标输出延迟（毫秒）
+    int deviceBufferSamples = 0;  // 直接指定设备缓冲采样数，优先于目标延迟
+
+    // 自适应缓冲：按欠载、回调开始时的余量和解码耗时调整环形缓冲区的填充
+    // 深度，出现抖动时增长，平稳后逐步收缩回延迟目标（默认模式为100ms）
+    bool adaptiveBuffer = true;
+    int maxBufferMs = 0;  // 填充深度上限，0为初始深度的两倍且至少多200ms
+
+    // 短音频的解码结果缓存，可在多个播放器间共享，为空时不缓存
+    std::shared_ptr<PcmCache> pcmCache;
+    // 探测结果和定位索引的持久缓存（见AudioDecoderConfig::mediaInfoCache）
+    std::shared_ptr<MediaInfoCache> mediaInfoCache;
+    // 定位索引和精确定位，见AudioDecoderConfig中的同名选项
+    SeekIndexMode seekIndexMode = SeekIndexMode::DISABLED;
+    bool cacheSeekIndex = true;
+    bool accurateSeek = true;
+
+    // 首次加载时在探测文件的同时按预测的参数打开设备，参数一致时直接使用
+    bool parallelDeviceOpen = true;
+
+    // 预读的网络输入解码可能阻塞在抖动缓冲上，总是按THREADED解码
+    PipelineMode pipelineMode = PipelineMode::DIRECT;
+
+    // 解码器内部线程数（见AudioDecoderConfig::codecThreads），0为自动
+    int codecThreads = 1;
+    // 解码和重采样线程的CPU亲和性和优先级，THREADED模式下两个线程都使用
+    ThreadSchedulingPolicy decodeScheduling;
+
+    // 声卡和系统混音器的额外输出延迟。SDL只报告设备缓冲，音画同步需要
+    // 更准确的播放位置时按实测值设置
+    int extraOutputLatencyMs = 0;
+
+    // 响度分析：PCM写入输出前按曲目测量EBU R128响度、真峰值和RMS，
+    // 无设备模式同样有效
+    bool analyzeLoudness = false;
+    // 按文件的REPLAYGAIN_TRACK_GAIN或R128_TRACK_GAIN标签调整曲目增益，
+    // 随音量一起在音频回调中应用。缓存的片段和无设备模式不调整
+    bool applyReplayGain = false;
+    double replayGainPreampDb = 0.0;  // 有标签的曲目额外增加的增益
+};
+
+// 输出延迟：已写入但尚未播放的音频时长
+struct OutputLatency {
+    double bufferedMs{0.0};  // 环形缓冲区中的时长
+    double deviceMs{0.0};    // 音频设备缓冲区的时长
+    double totalMs{0.0};     // 端到端输出延迟
+};
+
+// 无设备模式的渲染结果
+struct RenderStats {
+    bool success{false};         // 是否完整解码到文件末尾
+    uint64_t samples{0};         // 输出的采样帧数
+    double audioSeconds{0.0};    // 输出的音频时长（秒）
+    double wallSeconds{0.0};     // 实际耗时（秒）
+    double realtimeFactor{0.0};  // 相对实时播放的倍速
+    LoudnessResult loudness;     // analyzeLoudness开启时有效
+};
+
+// 音频回调的累计统计
+struct AudioCallbackStats {
+    uint64_t callbacks{0};      // 回调次数
+    uint64_t underruns{0};      // 欠载次数
+    uint64_t maxCallbackUs{0};  // 单次回调最长耗时（微秒）
+    uint64_t droppedEvents{0};  // 事件队列满时丢弃的事件数
+};
 
 class AudioPlayer {
    public:
     // 播放器状态枚举
     enum class State { STOPPED, PLAYING, PAUSED };
 
-    AudioPlayer();
+    explicit AudioPlayer(const AudioPlayerConfig &config = AudioPlayerConfig());
     ~AudioPlayer();
 
     // 文件操作
     bool loadFile(const std::string &filename);    // 加载音频文件
     bool switchFile(const std::string &filename);  // 切换到新的音频文件
 
+    // 播放列表（无缝播放）：当前曲目结束前在后台打开并预解码下一曲，
+    // 其PCM直接接续写入同一个环形缓冲区，不停止播放也不重新打开音频设备
+    void enqueue(const std::string &filename);  // 添加到播放列表末尾
+    void clearPlaylist();                       // 清空播放列表
+    size_t getPlaylistSize() const;             // 播放列表中等待的曲目数
+
     // 播放控制
     void play();                // 开始播放
     void pause();               // 暂停播放
@@ -37,64 +149,247 @@ class AudioPlayer {
     void stop();                // 停止播放
     void seek(double seconds);  // 跳转到指定时间
 
+    // 无设备模式：在调用线程上解码已加载的文件直到结束或stop()
+    RenderStats render();
+
     // 播放器控制
     void setVolume(int volume);  // 设置音量 (0-128)
     int getVolume() const;       // 获取当前音量
 
     // 状态查询
     State getState() const;             // 获取当前播放状态
-    double getCurrentPosition() const;  // 获取当前播放位置（秒）
+    // 正在发声的位置（秒），已扣除设备延迟；不加锁，可以在任意线程高频调用
+    double getCurrentPosition() const;
+    ClockReading getPlaybackClock() const;  // 采样帧精度的播放位置
     double getDuration() const;         // 获取音频总时长（秒）
+    OutputLatency getOutputLatency() const;  // 当前实测的输出延迟
+    AudioCallbackStats getCallbackStats() const;
+    PlayerStats getStats() const;  // 运行指标快照，可导出为JSON或Prometheus
+
+    // 响度分析结果，analyzeLoudness未开启时为空结果
+    LoudnessResult getLoudness() const;           // 当前曲目到目前为止
+    LoudnessResult getLastTrackLoudness() const;  // 无缝切换前播完的曲目
 
     // 音频格式信息
     int getSampleRate() const;
     int getChannels() const;
 
+    // 解码/播放管线累计的内存分配次数，稳态播放时应保持不变
+    uint64_t getAllocationCount() const;
+
    private:
     static void audioCallback(void *userdata, Uint8 *stream, int len);
     void fillAudioBuffer(Uint8 *stream, int len);
-    bool pushAudioData(const uint8_t *data, int size);
+    size_t mixFromRing(Uint8 *stream, size_t size);
+    void mixSpan(const uint8_t *in, uint8_t *out, size_t size, float startGain,
+                 float endGain);
     bool init(int sampleRate, int channels);
+    void initHeadless(int sampleRate, int channels);
     void processDecodedFrame(AVFrame *frame);
+    void drainResampler();
+
+    // 无缝播放
+    static constexpr double PRELOAD_AHEAD_SECONDS = 5.0;  // 提前预加载的时长
+    void startPreload();
+    void preloadNext();
+    void cancelPreload();
+    bool advanceToNextTrack();
 
     // 音频格式转换
     bool initResampler();
+    AudioOutputFormat deviceOutputFormat() const;
+
+    // 缓存的PCM片段：clip不为空时不使用解码器和重采样器，
+    // 解码线程直接把片段写入环形缓冲区。clip只在解码线程停止时或由解码线程
+    // 持有decoderMutex修改
+    bool loadFromCache(const std::string &filename);
+    void useClip(std::shared_ptr<const PcmClip> cached);
+    bool feedClip();
+    std::shared_ptr<const PcmClip> clip;
+    std::atomic<size_t> clipPosition{0};  // 下一个写入的采样帧
+
+    AudioPlayerConfig config;
+    bool sdlInitialized{false};
 
     SDL_AudioDeviceID audioDevice;
+    SDL_AudioSpec requestedSpec{};  // 当前设备打开时请求的参数，相同时复用设备
+    AudioDecoderConfig decoderConfig;
+    // 解码线程切换曲目时替换decoder，控制线程访问decoder前需加锁
+    mutable std::mutex decoderMutex;
     std::unique_ptr<AudioDecoder> decoder;
-    State playerState;
+    // 状态只由控制线程转换，转换完成后以release发布；回调、解码线程和
+    // 状态查询以acquire读取，不需要加锁
+    std::atomic<State> playerState;
+    bool isActive() const;  // 正在播放或暂停
 
-    // 音频队列
-    static const size_t MAX_QUEUE_SIZE = 50;
-    std::queue<std::vector<uint8_t>> audioQueue;
-    std::mutex queueMutex;
-    std::condition_variable dataCondition;
+    // 播放列表与预加载的下一曲
+    mutable std::mutex playlistMutex;
+    std::deque<std::string> playlist;
+    std::unique_ptr<AudioDecoder> nextDecoder;  // 已打开并开始解码的下一曲
+    std::thread preloadThread;
+    bool preloadStarted{false};  // 只在解码线程和控制线程停止解码线程后访问
 
-    // 播放控制
-    bool isPlaying;
-    bool isPaused;
-    int volume;
-    double currentPosition;  // 当前播放位置（秒）
+    // 延迟配置
+    static constexpr int DEFAULT_DEVICE_SAMPLES = 4096;  // 默认设备缓冲采样数
+    static constexpr int MIN_DEVICE_SAMPLES = 64;        // 低延迟下限
+    static constexpr int MIN_PREFETCH_MS = 40;  // 低延迟模式解码器最少预读
+    // 帧队列槽位按最短的编码帧（Opus的2.5ms）计算，深度只由时长限制
+    static constexpr int MIN_CODEC_FRAME_US = 2500;
+    static constexpr int MAX_DEVICE_CHANNELS = 8;  // SDL2支持到7.1
+    bool isLowLatency() const;
+    int deviceSamplesFor(int sampleRate) const;
+    int ringBufferMs() const;
+
+    // 音频环形缓冲区（解码线程写，SDL回调读）
+    static constexpr int AUDIO_BUFFER_MS = 500;  // 缓冲区容量（毫秒）
+    SpscRingBuffer ringBuffer;
+    size_t frameBytes{0};  // 每个采样帧（所有声道）的字节数
+    size_t bytesForDuration(int ms) const;
+    bool waitForSpace(size_t bytes, uint64_t serial);
+    bool writePcm(const uint8_t *data, size_t size);
+    bool emitPcm(const uint8_t *data, size_t size);
+    bool emitBlock(PcmBlock &block);
+
+    // 重采样输出数据块池
+    static constexpr int PCM_BLOCK_SAMPLES = 4096;  // 每块容纳的采样帧数
+    static constexpr size_t PCM_POOL_BLOCKS = 2;    // 预分配块数
+    PcmBlockPool pcmPool;
 
-    // 解码线程
+    // 播放控制。音量由回调读取，appliedGain是回调上一块结束时的增益，
+    // 只由回调或已锁住回调的控制线程访问
+    std::atomic<int> volume;
+    float appliedGain{1.0f};
+    std::atomic<double> currentPosition;  // 解码位置（秒），领先于发声位置
+
+    // 解码线程。DIRECT模式下解码线程持有decoderMutex调用decodeNextFrame，
+    // THREADED模式下持有它取序号和帧；seek()持有同一把锁，定位不会与
+    // 解码或取帧交错
     std::thread decodingThread;
-    bool isDecodingThreadRunning;
+    std::atomic<bool> isDecodingThreadRunning;
     void decodingLoop();
+    bool isDirectDecode(const AudioDecoder &source) const;
+    int decodeDirect(AVFrame *frame);
+    void checkPreload();
+
+    // 生产者等待：stop()和seek()立即唤醒；按需模式下由回调唤醒。
+    // seekSerial在每次定位时递增，写入中途发生定位时丢弃旧位置的数据
+    static constexpr int IDLE_WAIT_MS = 10;  // 没有可解码数据时的等待
+    std::mutex producerMutex;
+    std::condition_variable producerWakeup;
+    std::atomic<bool> producerWaiting{false};
+    std::atomic<uint64_t> producerWakeups{0};
+    std::atomic<uint64_t> seekSerial{0};
+    uint64_t emitSerial{0};  // 只由解码线程访问
+    // 解码线程检查序号并写入环形缓冲区，与seek()递增序号并清空缓冲区互斥
+    std::mutex ringWriteMutex;
+    void wakeProducer();
+    void waitForProducer(int ms);
+
+    // 播放时钟：回调按环形缓冲区中消费的字节推进。无缝切换曲目时解码线程
+    // 写入一个标记，记录新曲目第一个字节在环形缓冲区中的累计偏移，
+    // 回调读到这里时时钟从新曲目的0开始
+    struct ClockMark {
+        uint64_t ringBytes;  // SpscRingBuffer::totalWritten()/totalRead()
+        int64_t mediaFrame;  // 这个偏移处的媒体位置（输出采样帧）
+        float gain;          // 这个偏移之后的曲目增益（线性）
+    };
+    static constexpr size_t CLOCK_MARKS = 16;
+    PlaybackClock playbackClock;
+    SpscRingBuffer clockMarks{CLOCK_MARKS * sizeof(ClockMark)};
+    // 以下只由回调，或回调已停止、设备已锁住时的控制线程访问
+    ClockMark clockBase{0, 0, 1.0f};
+    ClockMark pendingMark{0, 0, 1.0f};
+    bool hasPendingMark{false};
+    void pushClockMark(int64_t mediaFrame, float gain);
+    int64_t playbackFrameAt(size_t ringBytes);
+    void resetClock(int64_t mediaFrame);
 
     // 音频格式转换
-    SwrContext *swrContext{nullptr};
+    void selectSampleFormat(AVSampleFormat sourceFormat);
+    bool isFloatOutput() const;
+    AudioResampler resampler;
+    const AudioKernels &kernels;  // 音量和淡入内核
+    AVSampleFormat outputSampleFormat{AV_SAMPLE_FMT_S16};
     SDL_AudioFormat deviceFormat;
     int deviceChannels;
     int deviceSampleRate;
 
-    // 增加更细致的缓冲区控制
-    static constexpr size_t MAX_AUDIO_BUFFER_SIZE = 8192;  // 最大缓冲区大小
-    static constexpr size_t LOW_WATER_MARK = 10;           // 低水位标记
+    // 响度分析与曲目增益。loudnessMeter只在解码线程停止时替换，
+    // lastTrackLoudness受decoderMutex保护
+    std::unique_ptr<LoudnessMeter> loudnessMeter;
+    LoudnessResult lastTrackLoudness;
+    std::atomic<float> trackGain{1.0f};  // 当前曲目的增益，定位时写入时钟基准
+    void prepareTrack();
+    float trackGainFor(const AudioDecoder *source) const;
+    void analyzePcm(const uint8_t *data, size_t size);
+
+    // 无设备模式输出
+    WavWriter wavWriter;
+    uint64_t renderedSamples{0};
+
+    static constexpr int LOW_WATER_MARK_MS = 100;  // 低水位标记（毫秒）
+
+    // 自适应缓冲：环形缓冲区按上限一次分配，生产者只填充到bufferLimit。
+    // 回调记录窗口内的最低水位，解码线程记录最长的单帧耗时，监控线程每个
+    // 窗口取走后交给控制器，调整后的填充深度立即对生产者生效
+    static constexpr int MIN_BUFFER_MS = 100;         // 默认模式的收缩下限
+    static constexpr int BUFFER_HEADROOM_MS = 200;    // 自动上限至少多出的时长
+    static constexpr int BUFFER_SETTLE_WINDOWS = 2;  // 定位后不观测的窗口数
+    mutable std::mutex bufferControlMutex;
+    BufferController bufferController;  // 以下两项也受bufferControlMutex保护
+    size_t bufferMinBytes{0};
+    size_t bufferMaxBytes{0};
+    std::atomic<size_t> bufferLimit{0};
+    std::atomic<size_t> windowMinFill{SIZE_MAX};
+    std::atomic<uint64_t> windowMaxProduceNs{0};
+    std::atomic<bool> producerIdle{false};  // 窗口内生产者曾无数据可写
+    // 以下只由监控线程访问
+    uint64_t observedUnderruns{0};
+    uint64_t observedCallbacks{0};
+    uint64_t observedSeekSerial{0};
+    int settleWindows{0};
+    int maxBufferMs(int initialMs) const;
+    void configureBuffer(int initialMs, int maxMs);
+    void adaptBuffer();
+    size_t fillSpace() const;
+    void noteProduceTime(uint64_t nanoseconds);
+
+    // 添加缓冲区状态监控（回调中只做原子操作，由监控线程负责记录日志）
+    std::atomic<bool> underrun{false};             // 缓冲区不足标志
+    std::atomic<uint64_t> underrunCount{0};        // 回调累计欠载次数
+    std::atomic<uint64_t> callbackCount{0};        // 回调累计次数
+    std::atomic<uint64_t> maxCallbackUs{0};        // 回调最长耗时
+    int deviceBufferSamples{0};                    // 设备缓冲区采样数
+    std::atomic<size_t> bufferHighWater{0};        // 环形缓冲区最高水位
+
+    // 耗时分布，跨曲目累计
+    LatencyHistogram decodeHistogram;
+    LatencyHistogram resampleHistogram;
+    LatencyHistogram callbackHistogram;
+
+    // 启动耗时：loadFile的耗时，以及加载耗时加上play()到第一次输出音频的时间
+    static constexpr int PREDICTED_SAMPLE_RATE = 48000;  // 预先打开设备的参数
+    static constexpr int PREDICTED_CHANNELS = 2;
+    LatencyHistogram openHistogram;
+    LatencyHistogram firstAudioHistogram;
+    uint64_t lastLoadNanos{0};
+    std::atomic<int64_t> firstAudioStartNs{0};  // steady_clock纳秒
+    std::atomic<bool> awaitingFirstAudio{false};
+    bool openDeviceForLoad(const std::string &filename);
 
-    // 添加缓冲区状态监控
-    std::atomic<bool> underrun{false};     // 缓冲区不足标志
-    std::atomic<size_t> bufferedSize{0};   // 当前缓冲的总大小
-    void updateBufferSize(int64_t delta);  // 添加新方法
+    // 回调事件队列及其监控线程
+    static constexpr int MONITOR_INTERVAL_MS = 100;  // 事件取出间隔
+    RtEventRing callbackEvents;
+    uint64_t fillReportInterval{0};  // 每隔多少次回调报告一次水位
+    uint64_t slowCallbackUs{0};      // 超过该耗时的回调记为过慢
+    std::thread monitorThread;
+    std::mutex monitorMutex;
+    std::condition_variable monitorWakeup;
+    bool isMonitorRunning{false};
+    void monitorLoop();
+    void drainCallbackEvents();
+    void startMonitor();
+    void stopMonitor();
 
     // 日志
     std::shared_ptr<spdlog::logger> _logger;
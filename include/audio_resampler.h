@@ -0,0 +1,89 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+
+extern "C" {
+#include <libavutil/channel_layout.h>
+#include <libavutil/samplefmt.h>
+#include <libswresample/swresample.h>
+}
+#include <spdlog/logger.h>
+
+class AudioDecoder;
+
+// 重采样输出格式（交错存储）。声道按SDL的顺序排列，布局见sdlChannelLayout
+struct AudioOutputFormat {
+    int sampleRate{0};
+    int channels{0};
+    AVSampleFormat sampleFormat{AV_SAMPLE_FMT_S16};
+
+    int bytesPerFrame() const {
+        return channels * av_get_bytes_per_sample(sampleFormat);
+    }
+};
+
+// 按SDL的声道顺序取布局：3为2.1，4为quad，5为4.1（FL FR LFE BL BR），
+// 6为5.1，7为6.1，8为7.1。FFmpeg的默认布局在4、5声道上与SDL不同，
+// 输出布局不能用av_channel_layout_default。超过8声道时取默认布局
+void sdlChannelLayout(int channels, AVChannelLayout *layout);
+
+// 对SwrContext的封装，把解码器输出转换为设备或文件需要的格式。
+// 输入的采样格式、声道布局和采样率都与输出相同时进入直通模式，不创建SwrContext；
+// 只差平面/交错存储的浮点输入（FLTP转FLT）由SIMD内核直接交错。
+// 声道顺序相同（后环绕与侧环绕视为同一对扬声器）时不做声道重混，
+// 只有声道数或扬声器位置不同时才由SwrContext按重混矩阵转换
+class AudioResampler {
+   public:
+    AudioResampler();
+    ~AudioResampler();
+
+    AudioResampler(const AudioResampler &) = delete;
+    AudioResampler &operator=(const AudioResampler &) = delete;
+
+    // 根据解码器的输入格式和指定的输出格式初始化
+    bool init(const AudioDecoder &decoder, const AudioOutputFormat &output);
+    // 直接指定输入格式初始化，输入可以是平面格式。
+    // inputLayout为空或顺序未指定时按声道数取默认布局
+    bool init(int inputSampleRate, int inputChannels,
+              AVSampleFormat inputFormat, const AudioOutputFormat &output,
+              const AVChannelLayout *inputLayout = nullptr);
+    void reset();
+    bool isInitialized() const {
+        return swrContext != nullptr || mode != Mode::RESAMPLE;
+    }
+    bool isPassThrough() const { return mode == Mode::PASS_THROUGH; }
+    bool isRemixing() const { return remixing; }
+
+    // 转换样本，返回写入output的采样帧数，负值为FFmpeg错误码
+    // 输出空间不足时剩余样本缓存在重采样器内，以inputSamples=0再次调用取出；
+    // input为nullptr时冲刷重采样器的延迟样本，只应在流结束时调用。
+    // 直通和交错模式不缓存样本，剩余样本直接引用input，取出前调用方不能释放输入帧
+    int convert(const uint8_t **input, int inputSamples, uint8_t *output,
+                int outputCapacity);
+
+    // 重采样器内部延迟（以输入采样率计）
+    int64_t getDelay(int64_t base) const;
+
+    const AudioOutputFormat &getOutputFormat() const { return outputFormat; }
+
+   private:
+    int copyThrough(const uint8_t **input, int inputSamples, uint8_t *output,
+                    int outputCapacity);
+
+    SwrContext *swrContext{nullptr};
+    AudioOutputFormat outputFormat;
+
+    enum class Mode { RESAMPLE, PASS_THROUGH, INTERLEAVE };
+    Mode mode{Mode::RESAMPLE};
+    bool remixing{false};  // 输入输出的扬声器布局不同，需要重混声道
+
+    // 直通和交错模式：上次未转换完的输入
+    const uint8_t **pendingInput{nullptr};
+    int pendingOffset{0};
+    int pendingSamples{0};
+    std::vector<const float *> planes;  // 交错模式按声道预分配的平面指针
+
+    // 日志
+    std::shared_ptr<spdlog::logger> _logger;
+};
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "loudness_meter.h"
+
+// 批量解码配置
+struct BatchDecoderConfig {
+    size_t threadCount = 0;    // 工作线程数，0为CPU核心数
+    int outputSampleRate = 0;  // 重采样目标采样率，0为与源文件相同
+    int outputChannels = 0;    // 重采样目标声道数，0为与源文件相同
+    bool analyzeLoudness = false;  // 解码的同时测量EBU R128响度和真峰值
+};
+
+// 单个文件的解码结果
+struct BatchFileResult {
+    std::string filename;
+    bool success{false};
+    std::string error;              // 失败原因
+    double duration{0.0};           // 实际解码出的音频时长（秒）
+    double containerDuration{0.0};  // 容器声明的时长（秒）
+    int sampleRate{0};              // 输出采样率
+    int channels{0};                // 输出声道数
+    uint64_t samples{0};            // 输出采样帧数
+    float peak{0.0f};               // 采样峰值，满幅为1.0
+    double decodeSeconds{0.0};      // 解码耗时（秒）
+    LoudnessResult loudness;        // analyzeLoudness开启时有效
+};
+
+// 整批任务的汇总
+struct BatchSummary {
+    size_t files{0};
+    size_t failed{0};
+    double audioSeconds{0.0};
+    double wallSeconds{0.0};
+    double realtimeFactor{0.0};
+};
+
+// 多文件并行解码器：工作窃取线程池中的每个工作线程拥有自己的
+// AudioDecoder和AudioResampler，各文件独立处理，不打开音频设备
+class BatchDecoder {
+   public:
+    // 结果回调在工作线程上串行调用，每个文件完成时调用一次
+    using ResultCallback = std::function<void(const BatchFileResult &)>;
+
+    explicit BatchDecoder(
+        const BatchDecoderConfig &config = BatchDecoderConfig());
+
+    // 阻塞直到所有文件处理完毕
+    BatchSummary run(const std::vector<std::string> &files,
+                     const ResultCallback &onResult);
+
+   private:
+    BatchDecoderConfig config;
+};
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// 缓冲控制器的参数，时长都以毫秒计
+struct BufferControllerConfig {
+    int sampleRate{0};
+    size_t frameBytes{0};  // 每个采样帧（所有声道）的字节数
+    int periodMs{0};       // 设备周期，回调每次取走的时长
+    int minMs{0};          // 平稳时收缩到的下限（延迟目标），不低于两个周期
+    int maxMs{0};          // 出现抖动时增长到的上限（缓冲区容量）
+    int initialMs{0};      // 第一次配置时的目标
+    int calmWindows{50};   // 连续多少个平稳的观测窗口后收缩一次
+};
+
+// 一个观测窗口内的统计
+struct BufferObservation {
+    uint64_t underruns{0};     // 新增的欠载次数
+    size_t minFillBytes{0};    // 回调开始时缓冲区中最少的字节数
+    uint64_t maxProduceNs{0};  // 生产者解码或重采样一帧最长的耗时
+};
+
+struct BufferControllerStats {
+    int targetMs{0};
+    uint64_t growths{0};
+    uint64_t shrinks{0};
+};
+
+// 按观测到的抖动调整缓冲目标：欠载时目标加倍，回调开始时的余量不足
+// 一个设备周期加上最长的生产耗时时补足差额；连续平稳一段时间后按余量
+// 的富余部分逐步收缩，每次最多1/8。只做计算，调用方负责加锁
+class BufferController {
+   public:
+    // 重新配置时保留已经学到的目标（按新的上下限截断）
+    void configure(const BufferControllerConfig &config);
+    // 处理一个观测窗口，目标改变时返回true
+    bool update(const BufferObservation &observation);
+
+    int getTargetMs() const { return targetMs; }
+    size_t getTargetBytes() const;
+    size_t bytesForMs(double ms) const;
+    BufferControllerStats getStats() const;
+
+   private:
+    double bytesToMs(size_t bytes) const;
+    void setTarget(int ms);
+
+    BufferControllerConfig config;
+    bool configured{false};
+    int targetMs{0};
+    int calmCount{0};
+    double calmMinFillMs{0.0};     // 平稳窗口中最低的余量
+    double calmMaxProduceMs{0.0};  // 平稳窗口中最长的生产耗时
+    uint64_t growths{0};
+    uint64_t shrinks{0};
+};
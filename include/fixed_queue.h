@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+// 预分配容量的环形FIFO队列，push/pop不分配内存
+// 不是线程安全的，由调用方加锁保护
+template <typename T>
+class FixedQueue {
+   public:
+    explicit FixedQueue(size_t capacity = 0) : items(capacity) {}
+
+    bool empty() const { return count == 0; }
+    bool full() const { return count == items.size(); }
+    size_t size() const { return count; }
+    size_t capacity() const { return items.size(); }
+
+    // 扩容并保持元素顺序，只有这里会分配内存
+    void reserve(size_t newCapacity) {
+        if (newCapacity <= items.size()) {
+            return;
+        }
+        std::vector<T> grown(newCapacity);
+        for (size_t i = 0; i < count; i++) {
+            grown[i] = std::move(items[(head + i) % items.size()]);
+        }
+        items.swap(grown);
+        head = 0;
+    }
+
+    // 队列已满时返回false
+    bool push(T value) {
+        if (full()) {
+            return false;
+        }
+        items[(head + count) % items.size()] = std::move(value);
+        count++;
+        return true;
+    }
+
+    T &front() { return items[head]; }
+    const T &front() const { return items[head]; }
+
+    void pop() {
+        items[head] = T();
+        head = (head + 1) % items.size();
+        count--;
+    }
+
+   private:
+    std::vector<T> items;
+    size_t head{0};
+    size_t count{0};
+};
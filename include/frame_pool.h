@@ -0,0 +1,87 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+extern "C" {
+#include <libavutil/frame.h>
+}
+
+// 帧对象池：在解码器生命周期内复用AVFrame结构体，避免逐帧av_frame_clone
+class AVFramePool {
+   public:
+    explicit AVFramePool(size_t initialFrames = 0);
+    ~AVFramePool();
+
+    AVFramePool(const AVFramePool &) = delete;
+    AVFramePool &operator=(const AVFramePool &) = delete;
+
+    // 获取一个空帧，池为空时才会分配新帧
+    AVFrame *acquire();
+    // 释放帧引用的数据并归还到池中
+    void release(AVFrame *frame);
+
+    size_t getIdleCount();
+    uint64_t getAllocationCount() const { return allocations.load(); }
+
+   private:
+    std::mutex poolMutex;
+    std::vector<AVFrame *> idleFrames;
+    size_t totalFrames{0};
+    std::atomic<uint64_t> allocations{0};  // 累计调用分配器的次数
+};
+
+// 固定容量的PCM数据块，消费者通过readOffset记录已读位置
+struct PcmBlock {
+    std::unique_ptr<uint8_t[]> data;
+    size_t capacity{0};
+    size_t size{0};        // 有效数据字节数
+    size_t readOffset{0};  // 已消费字节数
+
+    size_t remaining() const { return size - readOffset; }
+    const uint8_t *readPtr() const { return data.get() + readOffset; }
+};
+
+class PcmBlockPool;
+
+// 智能指针析构时把数据块归还给所属的池
+struct PcmBlockReleaser {
+    PcmBlockPool *pool{nullptr};
+    void operator()(PcmBlock *block) const;
+};
+
+// PCM数据块池：所有块容量相同，会话期间反复复用
+class PcmBlockPool {
+   public:
+    using BlockPtr = std::unique_ptr<PcmBlock, PcmBlockReleaser>;
+
+    PcmBlockPool() = default;
+    PcmBlockPool(size_t blockCapacity, size_t initialBlocks);
+
+    PcmBlockPool(const PcmBlockPool &) = delete;
+    PcmBlockPool &operator=(const PcmBlockPool &) = delete;
+
+    // 按新的块容量重建池，调用时不能有未归还的数据块
+    void reset(size_t blockCapacity, size_t initialBlocks);
+
+    // 获取一个空数据块，池为空时才会分配新块
+    BlockPtr acquire();
+
+    size_t getBlockCapacity() const { return blockCapacity; }
+    uint64_t getAllocationCount() const { return allocations.load(); }
+
+   private:
+    friend struct PcmBlockReleaser;
+    void release(PcmBlock *block);
+    PcmBlock *allocateBlock();
+
+    std::mutex poolMutex;
+    std::vector<std::unique_ptr<PcmBlock>> blocks;
+    std::vector<PcmBlock *> idleBlocks;
+    size_t blockCapacity{0};
+    std::atomic<uint64_t> allocations{0};  // 累计调用分配器的次数
+};
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// 延迟统计摘要（纳秒）
+struct LatencySummary {
+    uint64_t count{0};
+    uint64_t sum{0};
+    uint64_t min{0};
+    uint64_t max{0};
+    uint64_t p50{0};
+    uint64_t p90{0};
+    uint64_t p99{0};
+    uint64_t p999{0};
+};
+
+// HDR风格的对数-线性直方图，记录纳秒级耗时
+// 每个2的幂区间分为32个子桶，相对误差约3%，覆盖1ns到约68秒。
+// record()只做原子加法，不加锁、不分配内存，可以在音频回调中调用
+class LatencyHistogram {
+   public:
+    static constexpr int SUB_BUCKET_BITS = 6;
+    static constexpr uint64_t SUB_BUCKET_COUNT = 1ULL << SUB_BUCKET_BITS;
+    static constexpr uint64_t SUB_BUCKET_HALF = SUB_BUCKET_COUNT / 2;
+    static constexpr int MAX_VALUE_BITS = 36;  // 超过2^36ns的值记入最后一个桶
+    static constexpr size_t BUCKET_COUNT =
+        SUB_BUCKET_COUNT + (MAX_VALUE_BITS - SUB_BUCKET_BITS) * SUB_BUCKET_HALF;
+
+    LatencyHistogram() = default;
+
+    LatencyHistogram(const LatencyHistogram &) = delete;
+    LatencyHistogram &operator=(const LatencyHistogram &) = delete;
+
+    void record(uint64_t nanoseconds);
+    // 清空统计，与record()并发调用时可能丢失少量样本
+    void reset();
+
+    // 计算摘要；记录线程不会被阻塞，结果是近似一致的快照
+    LatencySummary summarize() const;
+
+   private:
+    static size_t bucketIndex(uint64_t value);
+    static uint64_t bucketUpperBound(size_t index);
+
+    std::array<std::atomic<uint64_t>, BUCKET_COUNT> buckets{};
+    std::atomic<uint64_t> count{0};
+    std::atomic<uint64_t> sum{0};
+    std::atomic<uint64_t> min{UINT64_MAX};
+    std::atomic<uint64_t> max{0};
+};
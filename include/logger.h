@@ -1,17 +1,49 @@
 // logger.h
 #pragma once
+// 编译期最低日志级别由xmake的log-level-min选项为所有源文件定义
+// SPDLOG_ACTIVE_LEVEL；不经过xmake构建时在这里保留全部级别
+#ifndef SPDLOG_ACTIVE_LEVEL
+#define SPDLOG_ACTIVE_LEVEL SPDLOG_LEVEL_TRACE
+#endif
+#include <spdlog/async.h>
 #include <spdlog/sinks/daily_file_sink.h>
 #include <spdlog/sinks/rotating_file_sink.h>
 #include <spdlog/sinks/stdout_color_sinks.h>
 #include <spdlog/spdlog.h>
 
 #include <memory>
+#include <mutex>
 #include <string>
 #include <unordered_map>
+#include <vector>
+
+// 热路径日志宏：低于编译期级别的调用连同参数求值一起被移除，
+// logger可以是Logger::getLogger()返回的任意子logger
+#define TEXAS_LOG_TRACE(logger, ...) SPDLOG_LOGGER_TRACE(logger, __VA_ARGS__)
+#define TEXAS_LOG_DEBUG(logger, ...) SPDLOG_LOGGER_DEBUG(logger, __VA_ARGS__)
+#define TEXAS_LOG_INFO(logger, ...) SPDLOG_LOGGER_INFO(logger, __VA_ARGS__)
+#define TEXAS_LOG_WARN(logger, ...) SPDLOG_LOGGER_WARN(logger, __VA_ARGS__)
+#define TEXAS_LOG_ERROR(logger, ...) SPDLOG_LOGGER_ERROR(logger, __VA_ARGS__)
+#define TEXAS_LOG_CRITICAL(logger, ...) \
+    SPDLOG_LOGGER_CRITICAL(logger, __VA_ARGS__)
 
 class Logger {
    public:
+    // 与SPDLOG_LEVEL_*的取值一一对应
     enum class Level { TRACE, DEBUG, INFO, WARN, ERROR, CRITICAL };
+
+    // 该级别的日志是否被编译进来，可用于跳过只为日志准备数据的代码
+    static constexpr bool isCompiledIn(Level level) {
+        return static_cast<int>(level) >= SPDLOG_ACTIVE_LEVEL;
+    }
+
+    // 异步模式下队列满时的处理方式
+    enum class OverflowPolicy {
+        BLOCK,        // 等待后台线程腾出空间
+        DROP_OLDEST,  // 覆盖队列中最旧的消息
+        DROP_NEW      // 丢弃新消息（spdlog 1.12以下按DROP_OLDEST处理）
+    };
+
     struct LoggerConfig {
         std::string filename;
         Level level;
@@ -21,6 +53,13 @@ class Logger {
         bool daily_rotation;
         std::string pattern;
 
+        // 异步模式：消息进入预分配的队列，由后台线程格式化并写入文件，
+        // 所有子logger共用同一个线程池和同一组sink
+        bool async_mode;
+        size_t async_queue_size;  // 队列容量（消息条数）
+        size_t async_threads;     // 后台线程数
+        OverflowPolicy overflow_policy;
+
         LoggerConfig()
             : filename("logs/app.log"),
               level(Level::INFO),
@@ -29,7 +68,11 @@ class Logger {
               max_files(5),
               console_output(true),
               daily_rotation(false),
-              pattern("[%Y-%m-%d %H:%M:%S.%e] [%n] [%l] [%t] %v") {}
+              pattern("[%Y-%m-%d %H:%M:%S.%e] [%n] [%l] [%t] %v"),
+              async_mode(false),
+              async_queue_size(8192),
+              async_threads(1),
+              overflow_policy(OverflowPolicy::DROP_OLDEST) {}
     };
 
     static Logger &getInstance() {
@@ -38,37 +81,39 @@ class Logger {
     }
 
     bool initialize(const LoggerConfig &config = LoggerConfig());
+    // 写出异步队列中剩余的消息并释放所有logger
+    void shutdown();
     void setLevel(Level level);
     void setPattern(const std::string &pattern);
 
     template <typename... Args>
     void trace(const char *fmt, const Args &...args) {
-        log(Level::TRACE, fmt, args...);
+        log<Level::TRACE>(fmt, args...);
     }
 
     template <typename... Args>
     void debug(const char *fmt, const Args &...args) {
-        log(Level::DEBUG, fmt, args...);
+        log<Level::DEBUG>(fmt, args...);
     }
 
     template <typename... Args>
     void info(const char *fmt, const Args &...args) {
-        log(Level::INFO, fmt, args...);
+        log<Level::INFO>(fmt, args...);
     }
 
     template <typename... Args>
     void warn(const char *fmt, const Args &...args) {
-        log(Level::WARN, fmt, args...);
+        log<Level::WARN>(fmt, args...);
     }
 
     template <typename... Args>
     void error(const char *fmt, const Args &...args) {
-        log(Level::ERROR, fmt, args...);
+        log<Level::ERROR>(fmt, args...);
     }
 
     template <typename... Args>
     void critical(const char *fmt, const Args &...args) {
-        log(Level::CRITICAL, fmt, args...);
+        log<Level::CRITICAL>(fmt, args...);
     }
 
     // 获取指定名称的子logger
@@ -76,37 +121,42 @@ class Logger {
 
    private:
     Logger() = default;
-    ~Logger() = default;
+    ~Logger() { shutdown(); }
     Logger(const Logger &) = delete;
     Logger &operator=(const Logger &) = delete;
 
-    template <typename... Args>
-    void log(Level level, const char *fmt, const Args &...args) {
-        if (!logger_) return;
+    // 级别是模板参数，低于编译期级别时整个函数体为空
+    template <Level level, typename... Args>
+    void log(const char *fmt, const Args &...args) {
+        if constexpr (isCompiledIn(level)) {
+            if (!logger_) return;
 
-        switch (level) {
-            case Level::TRACE:
+            if constexpr (level == Level::TRACE) {
                 logger_->trace(fmt, args...);
-                break;
-            case Level::DEBUG:
+            } else if constexpr (level == Level::DEBUG) {
                 logger_->debug(fmt, args...);
-                break;
-            case Level::INFO:
+            } else if constexpr (level == Level::INFO) {
                 logger_->info(fmt, args...);
-                break;
-            case Level::WARN:
+            } else if constexpr (level == Level::WARN) {
                 logger_->warn(fmt, args...);
-                break;
-            case Level::ERROR:
+            } else if constexpr (level == Level::ERROR) {
                 logger_->error(fmt, args...);
-                break;
-            case Level::CRITICAL:
+            } else {
                 logger_->critical(fmt, args...);
-                break;
+            }
         }
     }
 
+    std::vector<spdlog::sink_ptr> createSinks(const std::string &filename);
+    std::shared_ptr<spdlog::logger> createLogger(
+        const std::string &name, const std::vector<spdlog::sink_ptr> &sinks);
+
     std::shared_ptr<spdlog::logger> logger_;
     std::unordered_map<std::string, std::shared_ptr<spdlog::logger>> loggers_;
+    std::mutex loggersMutex_;  // 各模块可能在不同线程中获取子logger
     LoggerConfig config_;
+
+    // 异步模式
+    std::shared_ptr<spdlog::details::thread_pool> threadPool_;
+    std::vector<spdlog::sink_ptr> sharedSinks_;
 };
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+#include "audio_kernels.h"
+
+// 响度测量结果，响度单位LUFS，电平单位dBFS；没有足够数据时为-inf
+struct LoudnessResult {
+    double integratedLufs;  // 整体响度（EBU R128门限积分）
+    double momentaryLufs;   // 最近400ms
+    double shortTermLufs;   // 最近3秒
+    double loudnessRange;   // 响度范围（LU）
+    double samplePeakDb;    // 采样峰值
+    double truePeakDb;      // 4倍过采样估计的真峰值（dBTP）
+    double rmsDb;           // 所有声道的RMS（未加权）
+    uint64_t frames;        // 参与测量的采样帧数
+    bool complete;          // 从头测量到当前，期间没有定位
+
+    LoudnessResult();
+
+    // 按ReplayGain 2.0的参考响度（-18 LUFS）计算的增益（dB），
+    // 真峰值超过峰值上限时降低增益避免削波
+    double replayGainDb(double referenceLufs = -18.0,
+                        double peakLimitDb = -1.0) const;
+};
+
+// EBU R128 / ITU-R BS.1770-4响度计：按K加权滤波后的均方值做400ms块、
+// 75%重叠的双重门限积分，3秒短期响度用于响度范围。峰值和RMS由SIMD内核统计。
+// 声道按SDL/FFmpeg默认布局加权：LFE不计入，环绕声道乘以1.41。
+// process()由单个线程调用，result()可以在其他线程调用
+class LoudnessMeter {
+   public:
+    LoudnessMeter(int sampleRate, int channels);
+
+    LoudnessMeter(const LoudnessMeter &) = delete;
+    LoudnessMeter &operator=(const LoudnessMeter &) = delete;
+
+    // 输入交错PCM
+    void process(const float *samples, size_t frames);
+    void process(const int16_t *samples, size_t frames);
+
+    // 清空测量，开始新的曲目
+    void reset();
+    // 定位后不再是完整的测量，已有结果保留
+    void markDiscontinuity();
+
+    LoudnessResult result() const;
+
+    int getSampleRate() const { return sampleRate; }
+    int getChannels() const { return channels; }
+
+   private:
+    static constexpr int BLOCK_STEPS = 4;       // 400ms块 = 4个100ms步长
+    static constexpr int SHORT_TERM_STEPS = 30;  // 3秒
+    static constexpr int MAX_OVERSAMPLING = 4;
+    static constexpr int TAPS_PER_PHASE = 12;
+
+    struct Biquad {
+        double b0, b1, b2, a1, a2;
+    };
+    struct FilterState {
+        double x1{0}, x2{0}, y1{0}, y2{0};
+    };
+
+    void processLocked(const float *samples, size_t frames);
+    void finishStep();
+    double truePeakOf(int channel, float sample);
+    double meanOfSteps(int count) const;
+
+    const int sampleRate;
+    const int channels;
+    const AudioKernels &kernels;
+
+    // K加权：高频搁架 + 高通，每个声道两级状态
+    Biquad shelf{};
+    Biquad highPass{};
+    std::vector<FilterState> shelfState;
+    std::vector<FilterState> highPassState;
+    std::vector<double> weights;
+
+    // 真峰值：多相FIR插值，每个声道保存最近TAPS_PER_PHASE个样本
+    int oversampling{1};
+    std::vector<float> phaseTaps;  // oversampling * TAPS_PER_PHASE
+    std::vector<float> history;    // channels * TAPS_PER_PHASE，环形
+    size_t historyPos{0};
+
+    mutable std::mutex mutex;
+    size_t stepFrames;             // 100ms的帧数
+    size_t stepFilled{0};
+    double stepEnergy{0.0};        // 当前步长内加权平方和
+    std::array<double, SHORT_TERM_STEPS> recentSteps{};  // 环形，均方值
+    size_t completedSteps{0};
+    std::vector<double> blockPowers;      // 每100ms一个400ms块的功率
+    std::vector<double> shortTermPowers;  // 每100ms一个3秒窗口的功率
+
+    float samplePeak{0.0f};
+    double truePeak{0.0};
+    double sumSquares{0.0};
+    uint64_t totalFrames{0};
+    bool continuous{true};
+    std::vector<float> scratch;  // S16转换
+};
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+extern "C" {
+#include <libavcodec/avcodec.h>
+#include <libavutil/samplefmt.h>
+}
+
+#include <spdlog/logger.h>
+
+#include "media_input.h"
+#include "seek_index.h"
+
+// 打开文件时探测到的音频流参数
+struct MediaInfo {
+    int sampleRate{0};
+    int channels{0};
+    uint64_t channelLayout{0};  // 声道掩码，不能按掩码表示的布局为0
+    AVSampleFormat sampleFormat{AV_SAMPLE_FMT_NONE};
+    AVCodecID codecId{AV_CODEC_ID_NONE};
+    int streamIndex{-1};
+    AVRational timeBase{0, 1};
+    double duration{0.0};     // 秒，直播流为0
+    int64_t bitRate{0};       // 容器给出的总码率，未知为0
+    double trackGainDb{NAN};  // 见AudioDecoder::getTrackGainDb()
+};
+
+struct MediaInfoCacheStats {
+    size_t entries{0};  // 缓存文件中的条目数
+    size_t pending{0};  // 尚未写回的新条目数
+    uint64_t hits{0};
+    uint64_t misses{0};
+};
+
+// 探测结果和定位索引的持久缓存：以文件路径为键，大小或修改时间变化时失效。
+// 缓存文件按路径哈希排序，打开时映射到内存，查找只做二分查找，
+// 媒体库扫描和重新打开文件时不需要解复用。新条目先保存在内存中，
+// flush()或析构时与已有条目合并后整体写回。可在多个解码器间共享，
+// 同一个缓存文件只应由一个进程写入
+class MediaInfoCache {
+   public:
+    explicit MediaInfoCache(const std::string &cachePath);
+    ~MediaInfoCache();
+
+    MediaInfoCache(const MediaInfoCache &) = delete;
+    MediaInfoCache &operator=(const MediaInfoCache &) = delete;
+
+    // 查找仍然有效的探测结果
+    bool find(const std::string &path, const FileIdentity &identity,
+              MediaInfo &info);
+    // 查找同一文件、同一音频流的定位索引
+    std::shared_ptr<const SeekIndex> findSeekIndex(
+        const std::string &path, const FileIdentity &identity,
+        int streamIndex);
+
+    void insert(const std::string &path, const FileIdentity &identity,
+                const MediaInfo &info);
+    // 已有探测结果的文件才保存定位索引
+    void insertSeekIndex(const std::string &path, const FileIdentity &identity,
+                         std::shared_ptr<const SeekIndex> index);
+
+    // 媒体库扫描：命中缓存时不打开文件，否则按快速探测打开一次并写入缓存
+    bool probe(const std::string &path, MediaInfo &info);
+
+    // 把新条目合并写回缓存文件（先写临时文件再改名）并重新映射
+    bool flush();
+    MediaInfoCacheStats getStats();
+
+   private:
+    struct Record {
+        FileIdentity identity;
+        MediaInfo info;
+        std::shared_ptr<const SeekIndex> seekIndex;
+    };
+
+    // 调用方需持有cacheMutex
+    void mapCache();
+    bool findMapped(const std::string &path, uint64_t hash, Record &record,
+                    bool withSeekIndex) const;
+    bool findRecord(const std::string &path, const FileIdentity &identity,
+                    Record &record, bool withSeekIndex);
+
+    std::string cachePath;
+    std::mutex cacheMutex;
+    std::unique_ptr<MediaInput> mapping;  // 缓存文件的只读映射，可能为空
+    size_t mappedCount{0};                // 映射中的条目数
+    std::unordered_map<std::string, Record> pending;
+    uint64_t hits{0};
+    uint64_t misses{0};
+
+    std::shared_ptr<spdlog::logger> _logger;
+};
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+extern "C" {
+#include <libavformat/avio.h>
+#include <libavutil/mem.h>
+}
+
+// AVIOContext的缓冲区由av_malloc分配，可能已被FFmpeg替换，释放时以上下文中的为准
+struct IOContextDeleter {
+    void operator()(AVIOContext *ctx) {
+        if (ctx) {
+            av_freep(&ctx->buffer);
+            avio_context_free(&ctx);
+        }
+    }
+};
+
+// 内存输入：把本地文件映射到内存，或直接读取调用方持有的缓冲区，
+// 通过自定义AVIOContext交给解复用器，读取时不再经过read/seek系统调用
+class MediaInput {
+   public:
+    using IOContextPtr = std::unique_ptr<AVIOContext, IOContextDeleter>;
+
+    ~MediaInput();
+    MediaInput(const MediaInput &) = delete;
+    MediaInput &operator=(const MediaInput &) = delete;
+
+    // 映射本地文件并提示内核顺序读取、提前预读文件开头
+    // 空文件或文件系统不支持映射时返回nullptr，调用方可回退到普通文件IO
+    static std::unique_ptr<MediaInput> mapFile(const std::string &path);
+
+    // 读取调用方持有的内存（如嵌入程序的音频资源），不复制数据，
+    // data在MediaInput销毁前必须保持有效
+    static std::unique_ptr<MediaInput> fromMemory(const uint8_t *data,
+                                                  size_t size);
+
+    // 供AVFormatContext::pb使用，需配合AVFMT_FLAG_CUSTOM_IO，
+    // 必须在关闭AVFormatContext之后再销毁MediaInput
+    AVIOContext *getIOContext() const { return ioContext.get(); }
+
+    const uint8_t *data() const { return buffer; }
+    size_t size() const { return bufferSize; }
+    bool isMapped() const { return mappedAddress != nullptr; }
+
+   private:
+    MediaInput(const uint8_t *data, size_t size, void *mapped);
+    bool createIOContext();
+
+    // AVIOContext回调
+    static int readPacket(void *opaque, uint8_t *buf, int bufSize);
+    static int64_t seekPacket(void *opaque, int64_t offset, int whence);
+
+    static constexpr int IO_BUFFER_SIZE = 32 * 1024;
+    static constexpr size_t READAHEAD_BYTES = 1024 * 1024;  // 打开时预读的字节数
+
+    const uint8_t *buffer;
+    size_t bufferSize;
+    size_t position{0};
+    void *mappedAddress;  // 映射的起始地址，读取调用方内存时为nullptr
+    IOContextPtr ioContext;
+};
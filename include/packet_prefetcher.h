@@ -0,0 +1,115 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+extern "C" {
+#include <libavcodec/avcodec.h>
+}
+#include <spdlog/logger.h>
+
+#include "fixed_queue.h"
+
+// 预读模式
+enum class PrefetchMode {
+    AUTO,     // 只对网络输入（URL）开启
+    ENABLED,  // 总是开启
+    DISABLED  // 解码线程直接读取数据包
+};
+
+// 预读与抖动缓冲配置
+// 两种预读上限任意一个达到即暂停读取，0表示不限制
+struct PrefetchConfig {
+    PrefetchMode mode = PrefetchMode::AUTO;
+    size_t maxBytes = 4 * 1024 * 1024;  // 预读上限（压缩数据字节数）
+    int maxDurationMs = 10000;          // 预读上限（音频时长，毫秒）
+    int jitterBufferMs = 2000;  // 开始播放和断流后需积累的时长才交给解码器
+    int ioTimeoutMs = 5000;     // 网络读写超时，超时按断线处理
+    int maxReconnects = 5;      // 连续重连次数上限，-1为不限制
+    int reconnectDelayMs = 500;      // 第一次重连前的等待，之后逐次翻倍
+    int maxReconnectDelayMs = 8000;  // 重连等待的上限
+};
+
+// 预读状态快照
+struct PrefetchStats {
+    bool active{false};     // 预读线程正在运行
+    bool buffering{false};  // 正在积累抖动缓冲，解码器暂时取不到数据包
+    size_t packets{0};
+    size_t bytes{0};
+    double bufferedMs{0.0};
+    uint64_t rebuffers{0};   // 播放中缓冲被读空的次数
+    uint64_t reconnects{0};  // 重新连接的次数
+};
+
+// 数据包预读：在解码线程之前用独立线程读取数据包，放入有界的抖动缓冲。
+// 读取出错时按退避策略重连，网络短暂卡顿由缓冲吸收，不会直接变成播放欠载
+class PacketPrefetcher {
+   public:
+    // 读取下一个数据包，返回0、AVERROR_EOF或其他错误码
+    using ReadFunction = std::function<int(AVPacket *)>;
+    // 重新打开输入，返回0表示成功
+    using ReconnectFunction = std::function<int()>;
+
+    PacketPrefetcher();
+    ~PacketPrefetcher();
+
+    PacketPrefetcher(const PacketPrefetcher &) = delete;
+    PacketPrefetcher &operator=(const PacketPrefetcher &) = delete;
+
+    // timeBase用于把数据包时长换算为毫秒
+    void start(const PrefetchConfig &config, AVRational timeBase,
+               ReadFunction read, ReconnectFunction reconnect);
+    // 停止预读线程，缓冲中的数据包保留到flush()
+    void stop();
+    void flush();
+
+    // 取出一个数据包，缓冲中积累的时长不足时阻塞等待
+    // 返回0、AVERROR_EOF、读取失败的错误码，或在stop()后返回AVERROR_EXIT
+    int pop(AVPacket *packet);
+
+    bool isRunning() const { return running.load(); }
+    // 正在停止，供阻塞读取的中断回调使用
+    bool isStopping() const { return stopping.load(); }
+    PrefetchStats getStats();
+
+   private:
+    void prefetchLoop();
+    bool isFull() const;
+    bool waitForRetry(int delayMs);
+    void finish(int code);
+    void clearQueue();
+    AVPacket *acquirePacket();
+
+    PrefetchConfig config;
+    AVRational timeBase{0, 1};
+    ReadFunction read;
+    ReconnectFunction reconnect;
+
+    std::thread prefetchThread;
+    std::atomic<bool> running{false};
+    std::atomic<bool> stopping{false};
+
+    // 以下成员受queueMutex保护
+    std::mutex queueMutex;
+    std::condition_variable packetAvailable;
+    std::condition_variable spaceAvailable;
+    FixedQueue<AVPacket *> queue;
+    std::vector<AVPacket *> idlePackets;  // 复用AVPacket结构体
+    size_t queuedBytes{0};
+    int64_t queuedDuration{0};  // 流时间基准
+    bool buffering{true};
+    bool started{false};  // 已向解码器交出过数据包，之后读空才算断流
+    bool finished{false};
+    int finishCode{0};
+    uint64_t rebuffers{0};
+    uint64_t reconnects{0};
+
+    std::shared_ptr<spdlog::logger> _logger;
+};
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "audio_resampler.h"
+#include "seek_index.h"
+
+class AudioDecoder;
+
+// 完整解码后的音频片段，PCM为设备输出格式（交错存储），解码后只读
+struct PcmClip {
+    std::vector<uint8_t> data;
+    AudioOutputFormat format;
+    // 源文件参数，命中缓存时按与解码时相同的方式打开设备
+    int sourceSampleRate{0};
+    int sourceChannels{0};
+    AVSampleFormat sourceFormat{AV_SAMPLE_FMT_NONE};
+
+    size_t frames() const {
+        int bytes = format.bytesPerFrame();
+        return bytes > 0 ? data.size() / bytes : 0;
+    }
+    double duration() const {
+        return format.sampleRate > 0
+                   ? static_cast<double>(frames()) / format.sampleRate
+                   : 0.0;
+    }
+};
+
+struct PcmCacheConfig {
+    size_t memoryBudgetBytes = 64 * 1024 * 1024;  // 缓存PCM的总字节数上限
+    double maxClipSeconds = 10.0;  // 超过该时长的文件不缓存，照常流式解码
+};
+
+struct PcmCacheStats {
+    size_t entries{0};
+    size_t bytes{0};
+    uint64_t hits{0};
+    uint64_t misses{0};
+    uint64_t evictions{0};
+};
+
+// 解码后PCM的LRU缓存：反复播放的短音效只解码一次，之后直接从共享内存
+// 写入播放器的环形缓冲区，不再打开文件，也不经过解码器和重采样器。
+// 以文件路径为键，文件大小或修改时间变化时缓存失效；可在多个播放器间共享
+class PcmCache {
+   public:
+    explicit PcmCache(const PcmCacheConfig &config = PcmCacheConfig());
+
+    PcmCache(const PcmCache &) = delete;
+    PcmCache &operator=(const PcmCache &) = delete;
+
+    // 刚打开的解码器对应的文件是否适合缓存（时长已知且不超过maxClipSeconds）
+    bool isCacheable(const AudioDecoder &decoder) const;
+
+    // 查找仍然有效的缓存片段，命中时移到最近使用的位置
+    std::shared_ptr<const PcmClip> find(const std::string &path);
+
+    // 把刚打开的解码器完整解码为format格式并放入缓存，解码器随后位于文件末尾。
+    // 不适合缓存或解码失败时返回nullptr；单个片段超过内存预算时照常返回但不缓存
+    std::shared_ptr<const PcmClip> insert(const std::string &path,
+                                          AudioDecoder &decoder,
+                                          const AudioOutputFormat &format);
+
+    void clear();
+    PcmCacheStats getStats();
+
+   private:
+    std::shared_ptr<PcmClip> decodeClip(AudioDecoder &decoder,
+                                        const AudioOutputFormat &format);
+    // 调用方需持有cacheMutex
+    void evictFor(size_t bytes);
+    void erase(const std::string &path);
+
+    struct Entry {
+        std::shared_ptr<const PcmClip> clip;
+        FileIdentity identity;
+        std::list<std::string>::iterator lruPosition;
+    };
+
+    PcmCacheConfig config;
+    std::mutex cacheMutex;
+    std::unordered_map<std::string, Entry> entries;
+    std::list<std::string> lru;  // 头部为最近使用
+    size_t usedBytes{0};
+    uint64_t hits{0};
+    uint64_t misses{0};
+    uint64_t evictions{0};
+
+    std::shared_ptr<spdlog::logger> _logger;
+};
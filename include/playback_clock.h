@@ -0,0 +1,52 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+// 播放时钟的一次读数
+struct ClockReading {
+    int64_t frame{0};       // 正在发声的采样帧（输出采样率）
+    double seconds{0.0};    // frame换算的秒数
+    bool running{false};    // 设备正在消费数据，读数随时间前进
+};
+
+// 由音频回调按消费的采样帧推进的播放时钟，已扣除设备延迟。
+// 写入方同时只有一个（音频回调，或已锁住回调的控制线程），按顺序锁发布；
+// 读取不加锁、不写共享内存，任意线程可以高频读取而不与回调竞争。
+// 两次回调之间按墙钟时间插值，不超过已交给设备的数据
+class PlaybackClock {
+   public:
+    PlaybackClock() = default;
+
+    PlaybackClock(const PlaybackClock &) = delete;
+    PlaybackClock &operator=(const PlaybackClock &) = delete;
+
+    // 写入方接口
+    // 设置输出采样率和数据交给设备到发声的延迟
+    void configure(int sampleRate, int64_t latencyFrames);
+    // 回调开始时（timestampNs，steady_clock）从frame起交给设备frames帧；
+    // 扣除延迟后的读数不小于floor（当前曲目或定位的起点）
+    void advance(int64_t frame, int64_t frames, int64_t timestampNs,
+                 int64_t floor);
+    // 暂停、停止或定位：时钟停在frame
+    void freeze(int64_t frame);
+
+    // 读取方接口，nowNs小于等于0时取当前时间
+    ClockReading read(int64_t nowNs = 0) const;
+    int64_t getLatencyFrames() const;
+
+    static int64_t nowNanos();
+
+   private:
+    void beginWrite();
+    void endWrite();
+
+    // 奇数表示正在写入
+    alignas(64) std::atomic<uint32_t> sequence{0};
+    std::atomic<int64_t> startFrame{0};  // 回调时正在发声的帧
+    std::atomic<int64_t> endFrame{0};    // 本次交给设备的数据全部发声时的帧
+    std::atomic<int64_t> timestamp{0};
+    std::atomic<bool> running{false};
+    std::atomic<int> rate{0};
+    std::atomic<int64_t> latency{0};
+};
@@ -0,0 +1,120 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "audio_player.h"
+
+// 控制命令
+enum class PlayerCommandType {
+    LOAD,            // path
+    SWITCH,          // path
+    ENQUEUE,         // path
+    CLEAR_PLAYLIST,
+    PLAY,
+    PAUSE,
+    RESUME,
+    STOP,
+    SEEK,            // seconds
+    SET_VOLUME       // volume
+};
+
+struct PlayerCommand {
+    PlayerCommandType type;
+    std::string path{};
+    double seconds{0.0};
+    int volume{0};
+};
+
+// 命令完成时在命令线程上调用，不应阻塞
+using CommandCallback = std::function<void(uint64_t id, bool success)>;
+
+// 控制器维护的状态快照，读取时不访问播放器的锁
+struct PlayerStatus {
+    AudioPlayer::State state{AudioPlayer::State::STOPPED};
+    double position{0.0};  // 正在发声的位置（秒）
+    double duration{0.0};
+    int volume{0};
+    std::string file;            // 最后成功加载的文件
+    size_t pendingCommands{0};    // 队列中等待执行的命令数
+    uint64_t completedCommands{0};
+};
+
+// 播放器的异步控制接口：命令进入有界队列后立即返回，由控制器自己的命令线程
+// 按顺序在播放器上执行，loadFile、stop、seek等需要等待解码线程的操作不会阻塞
+// 调用线程。队列中尚未执行的连续定位或音量命令合并为最后一条，合并掉的命令
+// 与最后一条同时完成。所有公开方法都可以在任意线程调用
+class PlayerController {
+   public:
+    static constexpr size_t DEFAULT_MAX_PENDING = 256;
+
+    explicit PlayerController(
+        const AudioPlayerConfig &config = AudioPlayerConfig(),
+        size_t maxPending = DEFAULT_MAX_PENDING);
+    ~PlayerController();
+
+    PlayerController(const PlayerController &) = delete;
+    PlayerController &operator=(const PlayerController &) = delete;
+
+    // 返回命令编号；队列已满或控制器已关闭时返回0，回调随即以失败调用
+    uint64_t post(PlayerCommand command, CommandCallback callback = nullptr);
+    std::future<bool> submit(PlayerCommand command);
+
+    std::future<bool> load(const std::string &filename);
+    std::future<bool> switchFile(const std::string &filename);
+    std::future<bool> enqueue(const std::string &filename);
+    std::future<bool> clearPlaylist();
+    std::future<bool> play();
+    std::future<bool> pause();
+    std::future<bool> resume();
+    std::future<bool> stop();
+    std::future<bool> seek(double seconds);
+    std::future<bool> setVolume(int volume);
+
+    PlayerStatus getStatus() const;
+
+    // 丢弃尚未执行的命令（以失败完成），等待当前命令结束后停止播放。
+    // 之后提交的命令都失败；析构时自动调用，不能在命令回调中调用
+    void shutdown();
+
+   private:
+    struct Waiter {
+        uint64_t id;
+        CommandCallback callback;
+    };
+    struct Pending {
+        PlayerCommand command;
+        std::vector<Waiter> waiters;
+    };
+
+    static constexpr int STATUS_INTERVAL_MS = 100;  // 空闲时刷新状态的间隔
+
+    void commandLoop();
+    bool execute(const PlayerCommand &command);
+    void refreshStatus();
+    static void complete(std::vector<Waiter> &waiters, bool success);
+
+    AudioPlayer player;
+    size_t maxPending;
+
+    mutable std::mutex queueMutex;
+    std::condition_variable queueWakeup;
+    std::deque<Pending> queue;
+    bool isRunning{true};
+    uint64_t nextId{1};
+
+    mutable std::mutex statusMutex;
+    PlayerStatus status;
+
+    std::thread commandThread;
+    std::shared_ptr<spdlog::logger> _logger;
+};
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "latency_histogram.h"
+
+// 播放器运行指标快照，由AudioPlayer::getStats()生成
+struct PlayerStats {
+    // 耗时分布（纳秒）
+    LatencySummary decode;    // 解码线程每解出一帧的耗时
+    LatencySummary resample;  // 每次重采样转换的耗时
+    LatencySummary callback;  // 音频回调的耗时
+    LatencySummary open;      // loadFile()的耗时（打开、探测和初始化设备）
+    // 首次出声：加载耗时加上play()到第一次回调输出音频的时间
+    LatencySummary firstAudio;
+
+    // 音频回调
+    uint64_t callbacks{0};
+    uint64_t underruns{0};
+    uint64_t droppedEvents{0};
+
+    // 解码器帧队列（当前曲目）
+    size_t decoderQueueFrames{0};
+    size_t decoderQueueHighWater{0};
+
+    // 预读缓冲（当前曲目，只在开启预读时有值）
+    bool prefetchActive{false};
+    bool prefetchBuffering{false};
+    size_t prefetchBytes{0};
+    double prefetchMs{0.0};
+    uint64_t prefetchRebuffers{0};
+    uint64_t prefetchReconnects{0};
+
+    // 播放器环形缓冲区
+    size_t bufferedBytes{0};
+    size_t bufferHighWaterBytes{0};
+    size_t bufferCapacityBytes{0};
+    double bufferedMs{0.0};
+    double bufferTargetMs{0.0};  // 自适应缓冲当前的填充深度
+    uint64_t bufferGrowths{0};   // 出现抖动后增长的次数
+    uint64_t bufferShrinks{0};   // 平稳后收缩的次数
+    uint64_t producerWakeups{0};  // 生产者等待缓冲区空间后被唤醒的次数
+
+    std::string toJson() const;
+    // Prometheus文本格式，耗时以summary类型按秒输出
+    std::string toPrometheus(const std::string &prefix = "texas") const;
+};
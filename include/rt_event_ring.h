@@ -0,0 +1,42 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+#include "spsc_ring_buffer.h"
+
+// 音频回调产生的事件，由非实时线程取出后写入日志
+struct AudioEvent {
+    enum class Type : uint32_t {
+        UNDERRUN,       // value: 补静音的字节数
+        FILL_LEVEL,     // value: 回调开始时环形缓冲区中的字节数
+        SLOW_CALLBACK   // value: 回调耗时（微秒）
+    };
+
+    Type type{Type::UNDERRUN};
+    uint32_t value{0};
+    uint64_t sequence{0};  // 发生时的回调序号
+};
+
+// 实时线程向非实时线程传递事件的无锁队列
+// 基于SpscRingBuffer按定长记录读写；队列满时丢弃新事件并计数，生产者从不等待
+class RtEventRing {
+   public:
+    explicit RtEventRing(size_t capacity = 256);
+
+    RtEventRing(const RtEventRing &) = delete;
+    RtEventRing &operator=(const RtEventRing &) = delete;
+
+    // 生产者（音频回调）调用，队列满时返回false
+    bool push(const AudioEvent &event);
+    // 消费者调用，没有事件时返回false
+    bool pop(AudioEvent &event);
+
+    // 丢弃全部事件，调用时生产者必须已停止
+    void clear();
+    uint64_t getDroppedCount() const;
+
+   private:
+    SpscRingBuffer ring;
+    std::atomic<uint64_t> dropped{0};
+};
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+extern "C" {
+#include <libavutil/avutil.h>
+}
+
+// 文件身份：用大小和修改时间判断缓存是否仍然有效
+struct FileIdentity {
+    uint64_t size{0};
+    int64_t mtime{0};
+
+    static bool get(const std::string &filename, FileIdentity &identity);
+    bool operator==(const FileIdentity &other) const {
+        return size == other.size && mtime == other.mtime;
+    }
+};
+
+// 定位索引：数据包字节偏移 -> 时间戳，按时间戳升序排列
+// 通过纯解复用扫描一次文件建立，可缓存到音频文件旁的.tsidx文件
+class SeekIndex {
+   public:
+    struct Entry {
+        int64_t pos;  // 数据包在文件中的字节偏移
+        int64_t pts;  // 数据包时间戳（流时间基准）
+    };
+
+    // 扫描文件建立索引，相邻条目间隔不小于intervalSeconds
+    // cancel被置位时提前返回nullptr
+    static std::shared_ptr<SeekIndex> build(const std::string &filename,
+                                            int streamIndex,
+                                            double intervalSeconds,
+                                            const std::atomic<bool> &cancel);
+
+    // 从缓存文件加载，文件身份或流编号不一致时返回nullptr
+    static std::shared_ptr<SeekIndex> load(const std::string &cachePath,
+                                           const FileIdentity &identity,
+                                           int streamIndex);
+    bool save(const std::string &cachePath,
+              const FileIdentity &identity) const;
+
+    // 缓存文件路径：音频文件路径加.tsidx后缀
+    static std::string cachePathFor(const std::string &filename);
+
+    // 由其他缓存保存的条目重建，条目须已按时间戳升序
+    static std::shared_ptr<SeekIndex> fromEntries(std::vector<Entry> entries,
+                                                  AVRational timeBase,
+                                                  int streamIndex);
+
+    // 查找时间戳不晚于pts的最后一个条目，没有则返回nullptr
+    const Entry *find(int64_t pts) const;
+
+    size_t size() const { return entries.size(); }
+    const std::vector<Entry> &getEntries() const { return entries; }
+    AVRational getTimeBase() const { return timeBase; }
+    int getStreamIndex() const { return streamIndex; }
+
+   private:
+    std::vector<Entry> entries;
+    AVRational timeBase{0, 1};
+    int streamIndex{-1};
+};
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+// 单生产者/单消费者无锁字节环形缓冲区
+// 生产者（解码线程）只修改写指针，消费者（SDL音频回调）只修改读指针，
+// 两端都只做原子读写和memcpy，不加锁、不分配内存
+class SpscRingBuffer {
+   public:
+    static constexpr size_t CACHE_LINE_SIZE = 64;
+
+    // 一段连续的可读区域
+    struct Span {
+        const uint8_t *data{nullptr};
+        size_t size{0};
+    };
+
+    explicit SpscRingBuffer(size_t capacity = 0);
+    ~SpscRingBuffer() = default;
+
+    SpscRingBuffer(const SpscRingBuffer &) = delete;
+    SpscRingBuffer &operator=(const SpscRingBuffer &) = delete;
+
+    // 重新分配存储空间，调用时生产者和消费者都必须已停止
+    void reset(size_t capacity);
+    // 丢弃全部可读数据，属于消费者侧操作
+    void clear();
+
+    // 生产者接口：返回实际写入的字节数
+    size_t write(const uint8_t *data, size_t size);
+    size_t writeAvailable() const;
+
+    // 消费者接口：返回实际读取的字节数
+    size_t read(uint8_t *dest, size_t size);
+    // 获取最多size字节的可读区域（环绕时分为两段），不移动读指针
+    size_t peek(size_t size, Span &first, Span &second) const;
+    // 移动读指针，size不能超过readAvailable()
+    void consume(size_t size);
+    size_t readAvailable() const;
+
+    size_t capacity() const { return bufferCapacity; }
+    // 累计写入和读取的字节数，clear()丢弃的数据计为已读取，reset()时归零。
+    // totalWritten()只能由生产者调用，totalRead()只能由消费者调用
+    size_t totalWritten() const {
+        return writeIndex.load(std::memory_order_relaxed);
+    }
+    size_t totalRead() const {
+        return readIndex.load(std::memory_order_relaxed);
+    }
+
+   private:
+    // 读写指针单调递增，取模得到实际偏移；分别放在独立的缓存行避免伪共享
+    alignas(CACHE_LINE_SIZE) std::atomic<size_t> readIndex{0};
+    alignas(CACHE_LINE_SIZE) std::atomic<size_t> writeIndex{0};
+
+    // 存储区在reset之后只读，与读写指针分开存放
+    alignas(CACHE_LINE_SIZE) std::unique_ptr<uint8_t[]> storage;
+    size_t bufferCapacity{0};
+};
@@ -0,0 +1,85 @@
+/* texas.h - Texas音频播放器的C接口 */
+#pragma once
+
+#include <stdint.h>
+
+/* 构建或使用动态库时定义TEXAS_SHARED，构建动态库时另外定义TEXAS_BUILD_DLL */
+#if defined(_WIN32) && defined(TEXAS_SHARED)
+#ifdef TEXAS_BUILD_DLL
+#define TEXAS_API __declspec(dllexport)
+#else
+#define TEXAS_API __declspec(dllimport)
+#endif
+#elif defined(TEXAS_SHARED)
+#define TEXAS_API __attribute__((visibility("default")))
+#else
+#define TEXAS_API
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct texas_player texas_player;
+
+typedef enum texas_state {
+    TEXAS_STATE_STOPPED = 0,
+    TEXAS_STATE_PLAYING = 1,
+    TEXAS_STATE_PAUSED = 2
+} texas_state;
+
+typedef struct texas_config {
+    int target_latency_ms;    /* 目标输出延迟，0为默认 */
+    int headless;             /* 非0时不打开音频设备 */
+    const char *output_file;  /* 无设备模式输出的WAV文件，可为NULL */
+    int max_pending;          /* 命令队列容量，0为默认 */
+} texas_config;
+
+/* 命令完成时在播放器的命令线程上调用，不应阻塞；request为提交时返回的编号 */
+typedef void (*texas_callback)(uint64_t request, int success, void *userdata);
+
+/* 可选：初始化日志文件，在创建播放器之前调用。成功返回0，失败返回-1 */
+TEXAS_API int texas_init_logging(const char *filename);
+
+/* config可为NULL。失败返回NULL */
+TEXAS_API texas_player *texas_player_create(const texas_config *config);
+/* 丢弃未执行的命令（回调以失败调用）并停止播放 */
+TEXAS_API void texas_player_destroy(texas_player *player);
+
+/* 以下命令都立即返回请求编号，队列已满或内存不足时返回0（回调同样以失败调用）。
+   callback可为NULL */
+TEXAS_API uint64_t texas_player_load(texas_player *player, const char *path,
+                                     texas_callback callback, void *userdata);
+TEXAS_API uint64_t texas_player_switch(texas_player *player, const char *path,
+                                       texas_callback callback,
+                                       void *userdata);
+TEXAS_API uint64_t texas_player_enqueue(texas_player *player, const char *path,
+                                        texas_callback callback,
+                                        void *userdata);
+TEXAS_API uint64_t texas_player_clear_playlist(texas_player *player,
+                                               texas_callback callback,
+                                               void *userdata);
+TEXAS_API uint64_t texas_player_play(texas_player *player,
+                                     texas_callback callback, void *userdata);
+TEXAS_API uint64_t texas_player_pause(texas_player *player,
+                                      texas_callback callback, void *userdata);
+TEXAS_API uint64_t texas_player_resume(texas_player *player,
+                                       texas_callback callback,
+                                       void *userdata);
+TEXAS_API uint64_t texas_player_stop(texas_player *player,
+                                     texas_callback callback, void *userdata);
+TEXAS_API uint64_t texas_player_seek(texas_player *player, double seconds,
+                                     texas_callback callback, void *userdata);
+TEXAS_API uint64_t texas_player_set_volume(texas_player *player, int volume,
+                                           texas_callback callback,
+                                           void *userdata);
+
+/* 状态查询不等待命令执行 */
+TEXAS_API texas_state texas_player_get_state(const texas_player *player);
+TEXAS_API double texas_player_get_position(const texas_player *player);
+TEXAS_API double texas_player_get_duration(const texas_player *player);
+TEXAS_API int texas_player_get_volume(const texas_player *player);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// 工作窃取线程池：每个工作线程有自己的任务队列，
+// 本地队列为空时从其他线程队列的尾部窃取任务
+class WorkStealingThreadPool {
+   public:
+    // 任务参数为执行它的工作线程编号，可用于访问线程私有的资源
+    using Task = std::function<void(size_t workerIndex)>;
+
+    // threadCount为0时使用CPU核心数
+    explicit WorkStealingThreadPool(size_t threadCount = 0);
+    ~WorkStealingThreadPool();
+
+    WorkStealingThreadPool(const WorkStealingThreadPool &) = delete;
+    WorkStealingThreadPool &operator=(const WorkStealingThreadPool &) = delete;
+
+    // 提交任务，按轮转分配到各工作线程的队列
+    void submit(Task task);
+    // 阻塞直到所有已提交的任务执行完毕
+    void wait();
+
+    size_t getThreadCount() const { return workers.size(); }
+
+   private:
+    struct WorkerQueue {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    void workerLoop(size_t index);
+    bool popLocal(size_t index, Task &task);
+    bool steal(size_t thief, Task &task);
+
+    std::vector<std::unique_ptr<WorkerQueue>> queues;
+    std::vector<std::thread> workers;
+
+    std::mutex wakeMutex;
+    std::condition_variable wakeCondition;  // 有新任务或线程池停止
+    std::condition_variable idleCondition;  // 所有任务执行完毕
+    std::atomic<size_t> queuedTasks{0};     // 队列中尚未被取走的任务数
+    std::atomic<size_t> pendingTasks{0};    // 已提交但尚未完成的任务数
+    std::atomic<size_t> nextQueue{0};
+    bool stopping{false};
+};
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+// 线程优先级
+enum class ThreadPriority {
+    NORMAL,   // 不修改
+    HIGH,     // 普通调度下的最高优先级（Linux的nice -10、Windows的HIGHEST）
+    REALTIME  // 实时调度：POSIX的SCHED_FIFO/SCHED_RR，Windows的MMCSS
+};
+
+// 线程调度策略。实时优先级通常需要权限（Linux的CAP_SYS_NICE或
+// RLIMIT_RTPRIO），没有权限时记录警告并保持原来的调度，不影响播放
+struct ThreadSchedulingPolicy {
+    ThreadPriority priority = ThreadPriority::NORMAL;
+    int realtimePriority = 0;  // SCHED_FIFO/RR的优先级，0为策略范围的中间值
+    bool roundRobin = false;   // 使用SCHED_RR而不是SCHED_FIFO
+    // MMCSS任务名，"Pro Audio"或"Audio"
+    std::string mmcssTask = "Pro Audio";
+    std::vector<int> cpuAffinity;  // 绑定的CPU编号，为空时不绑定
+
+    bool isDefault() const {
+        return priority == ThreadPriority::NORMAL && cpuAffinity.empty();
+    }
+};
+
+// 在构造时对当前线程应用调度策略，析构时撤销需要撤销的部分（MMCSS）。
+// 在线程函数开头创建，生命周期覆盖整个线程
+class ScopedThreadScheduling {
+   public:
+    // name只用于日志
+    ScopedThreadScheduling(const ThreadSchedulingPolicy &policy,
+                           const char *name);
+    ~ScopedThreadScheduling();
+
+    ScopedThreadScheduling(const ScopedThreadScheduling &) = delete;
+    ScopedThreadScheduling &operator=(const ScopedThreadScheduling &) = delete;
+
+    bool isAffinityApplied() const { return affinityApplied; }
+    bool isPriorityApplied() const { return priorityApplied; }
+
+   private:
+    bool affinityApplied{false};
+    bool priorityApplied{false};
+    void *mmcssHandle{nullptr};
+};
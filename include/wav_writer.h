@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+
+// 最简单的WAV文件写入器，支持整数PCM和32位浮点
+class WavWriter {
+   public:
+    WavWriter() = default;
+    ~WavWriter();
+
+    WavWriter(const WavWriter &) = delete;
+    WavWriter &operator=(const WavWriter &) = delete;
+
+    bool open(const std::string &filename, int sampleRate, int channels,
+              int bitsPerSample, bool isFloat = false);
+    bool write(const uint8_t *data, size_t size);
+    // 回填文件头中的长度字段并关闭文件
+    bool close();
+
+    bool isOpen() const { return file != nullptr; }
+    uint64_t getDataSize() const { return dataSize; }
+
+   private:
+    bool writeHeader();
+
+    std::FILE *file{nullptr};
+    int sampleRate{0};
+    int channels{0};
+    int bitsPerSample{0};
+    bool isFloat{false};
+    uint64_t dataSize{0};
+};
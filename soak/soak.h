@@ -0,0 +1,145 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "audio_mixer.h"
+#include "audio_player.h"
+#include "latency_histogram.h"
+#include "pcm_cache.h"
+
+// 浸泡测试配置，对应的命令行参数见soak_main.cpp
+struct SoakConfig {
+    int players = 4;                 // 同时运行的播放器数
+    int mixers = 1;                  // 同时运行的混音器数
+    double durationSeconds = 3600.0;
+    double reportSeconds = 60.0;     // 采样和输出的间隔
+    double warmupSeconds = 60.0;     // 预热结束时的RSS作为内存增长的基线
+    int contentionThreads = 0;       // 制造CPU争用的忙循环线程数
+    int contentionDuty = 100;        // 忙循环线程每10ms中忙碌的百分比
+    int stormIntervalMs = 500;       // 每个实例两次随机操作的平均间隔
+    int targetLatencyMs = 0;         // 见AudioPlayerConfig::targetLatencyMs
+    PipelineMode pipelineMode = PipelineMode::DIRECT;
+    // SDL音频驱动，为空时使用环境变量SDL_AUDIODRIVER，都没有时用不需要
+    // 声卡的dummy（按实时速度调用回调）；disk驱动输出到文件
+    std::string driver;
+    std::vector<std::string> files;  // 为空时使用生成的测试信号
+    std::string outputFile;          // 每次采样追加一行JSON
+    uint64_t seed = 1;
+
+    // SLO：播放器的欠载预算为每小时的基础额度加上每次清空缓冲区的操作
+    // （定位、连续定位、切换、停止后重新开始）的额度，重新填满之前的欠载
+    // 是预期的；音量、暂停等操作不清空缓冲区，不增加额度
+    double maxUnderrunsPerHour = 60.0;
+    double maxUnderrunsPerFlush = 2.0;
+    double maxVoiceUnderrunsPerHour = 60.0;  // 混音器声部欠载的单独预算
+    double maxCallbackP99Us = 2000.0;  // 所有实例中最差的回调p99
+    double maxCallbackMaxUs = 0.0;     // 单次回调最长耗时，0为不检查
+    double maxRssGrowthMb = 32.0;      // 预热之后的常驻内存增长
+};
+
+// 一个负载实例的累计统计
+struct LoadStats {
+    uint64_t callbacks{0};
+    uint64_t underruns{0};   // 混音器为声部欠载次数
+    uint64_t operations{0};  // 执行的随机操作数
+    uint64_t flushes{0};     // 其中清空缓冲区的操作数，混音器为0
+    uint64_t failures{0};    // 加载、切换或播放请求失败的次数
+    LatencySummary callback;
+};
+
+// 受压的播放器：控制线程按随机间隔定位、切换曲目、暂停恢复和调节音量，
+// 偶尔连续定位。播放列表始终保留一首待播曲目，曲目之间经过无缝切换
+class PlayerLoad {
+   public:
+    PlayerLoad(const SoakConfig &config, int index);
+    ~PlayerLoad();
+
+    PlayerLoad(const PlayerLoad &) = delete;
+    PlayerLoad &operator=(const PlayerLoad &) = delete;
+
+    bool start();
+    void stop();
+    LoadStats getStats() const;
+
+   private:
+    void controlLoop();
+    void storm();
+    bool restart();
+    const std::string &randomFile();
+    // 休眠期间被stop()打断时返回false
+    bool sleepFor(std::chrono::milliseconds duration);
+
+    const SoakConfig &config;
+    AudioPlayer player;
+    std::mt19937_64 rng;
+
+    std::mutex stopMutex;
+    std::condition_variable stopWakeup;
+    bool isRunning{false};
+    std::thread controlThread;
+
+    std::atomic<uint64_t> operations{0};
+    std::atomic<uint64_t> flushes{0};
+    std::atomic<uint64_t> failures{0};
+};
+
+// 受压的混音器：控制线程随机播放、停止声部和调节增益。偶数编号的混音器
+// 把文件整个缓存后按片段播放，奇数编号的占用流式解码槽位，两条路径都受压
+class MixerLoad {
+   public:
+    MixerLoad(const SoakConfig &config, int index);
+    ~MixerLoad();
+
+    MixerLoad(const MixerLoad &) = delete;
+    MixerLoad &operator=(const MixerLoad &) = delete;
+
+    bool start();
+    void stop();
+    LoadStats getStats() const;
+
+   private:
+    static constexpr size_t MAX_TRACKED_VOICES = 64;
+
+    void controlLoop();
+    void storm();
+    bool sleepFor(std::chrono::milliseconds duration);
+
+    const SoakConfig &config;
+    std::unique_ptr<AudioMixer> mixer;
+    std::mt19937_64 rng;
+    std::vector<VoiceId> voices;  // 最近启动的声部，只由控制线程访问
+
+    std::mutex stopMutex;
+    std::condition_variable stopWakeup;
+    bool isRunning{false};
+    std::thread controlThread;
+
+    std::atomic<uint64_t> operations{0};
+    std::atomic<uint64_t> failures{0};
+};
+
+// 制造CPU争用：每个线程在每10ms中忙循环duty%的时间
+class CpuContention {
+   public:
+    ~CpuContention();
+
+    void start(int threads, int duty);
+    void stop();
+
+   private:
+    std::atomic<bool> isRunning{false};
+    std::vector<std::thread> workers;
+};
+
+// 当前进程的常驻内存（字节），平台不支持时返回0
+size_t currentRssBytes();
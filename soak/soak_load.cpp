@@ -0,0 +1,313 @@
+#include "soak.h"
+
+#include <algorithm>
+#include <fstream>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#include <psapi.h>
+#elif defined(__APPLE__)
+#include <mach/mach.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace {
+
+constexpr int CONTENTION_PERIOD_MS = 10;
+constexpr int SEEK_BURST = 20;  // 连续定位的次数
+
+AudioPlayerConfig playerConfig(const SoakConfig &config) {
+    AudioPlayerConfig pconfig;
+    pconfig.targetLatencyMs = config.targetLatencyMs;
+    pconfig.pipelineMode = config.pipelineMode;
+    return pconfig;
+}
+
+AudioMixerConfig mixerConfig(int index) {
+    AudioMixerConfig mconfig;
+    if (index % 2 == 0) {
+        PcmCacheConfig cconfig;
+        cconfig.memoryBudgetBytes = 256 * 1024 * 1024;
+        cconfig.maxClipSeconds = 60.0;
+        mconfig.pcmCache = std::make_shared<PcmCache>(cconfig);
+    }
+    return mconfig;
+}
+
+// 平均间隔为meanMs的指数分布，模拟彼此独立的用户操作
+std::chrono::milliseconds nextInterval(std::mt19937_64 &rng, int meanMs) {
+    std::exponential_distribution<double> dist(1.0 / std::max(1, meanMs));
+    return std::chrono::milliseconds(static_cast<int64_t>(dist(rng)) + 1);
+}
+
+}  // namespace
+
+PlayerLoad::PlayerLoad(const SoakConfig &config, int index)
+    : config(config), player(playerConfig(config)), rng(config.seed + index) {
+}
+
+PlayerLoad::~PlayerLoad() { stop(); }
+
+bool PlayerLoad::start() {
+    if (!restart()) {
+        return false;
+    }
+    isRunning = true;
+    controlThread = std::thread(&PlayerLoad::controlLoop, this);
+    return true;
+}
+
+void PlayerLoad::stop() {
+    {
+        std::lock_guard<std::mutex> lock(stopMutex);
+        isRunning = false;
+    }
+    stopWakeup.notify_all();
+    if (controlThread.joinable()) {
+        controlThread.join();
+    }
+    player.stop();
+}
+
+LoadStats PlayerLoad::getStats() const {
+    PlayerStats stats = player.getStats();
+    LoadStats load;
+    load.callbacks = stats.callbacks;
+    load.underruns = stats.underruns;
+    load.operations = operations.load();
+    load.flushes = flushes.load();
+    load.failures = failures.load();
+    load.callback = stats.callback;
+    return load;
+}
+
+void PlayerLoad::controlLoop() {
+    while (sleepFor(nextInterval(rng, config.stormIntervalMs))) {
+        storm();
+        // 播放列表只留一首，播完前一直有下一曲可以无缝接续
+        if (player.getPlaylistSize() == 0) {
+            player.enqueue(randomFile());
+        }
+        // 加载或切换失败后播放器可能停下，重新开始
+        if (player.getState() == AudioPlayer::State::STOPPED) {
+            flushes++;
+            if (!restart()) {
+                failures++;
+            }
+        }
+    }
+}
+
+void PlayerLoad::storm() {
+    operations++;
+    std::uniform_int_distribution<int> choice(0, 99);
+    int roll = choice(rng);
+    double duration = std::max(1.0, player.getDuration());
+    std::uniform_real_distribution<double> position(0.0, duration);
+
+    // 连续定位只有最后一次之后需要重新填满缓冲区，按一次计
+    if (roll < 45) {
+        flushes++;
+        player.seek(position(rng));
+    } else if (roll < 50) {
+        flushes++;
+        for (int i = 0; i < SEEK_BURST; ++i) {
+            player.seek(position(rng));
+        }
+    } else if (roll < 65) {
+        flushes++;
+        if (!player.switchFile(randomFile())) {
+            failures++;
+        }
+    } else if (roll < 75) {
+        player.pause();
+        std::uniform_int_distribution<int> pauseMs(1, 200);
+        sleepFor(std::chrono::milliseconds(pauseMs(rng)));
+        player.resume();
+    } else if (roll < 95) {
+        std::uniform_int_distribution<int> volume(0, SDL_MIX_MAXVOLUME);
+        player.setVolume(volume(rng));
+    } else {
+        flushes++;
+        player.stop();
+        if (!restart()) {
+            failures++;
+        }
+    }
+}
+
+bool PlayerLoad::restart() {
+    if (!player.loadFile(randomFile())) {
+        return false;
+    }
+    player.play();
+    return player.getState() == AudioPlayer::State::PLAYING;
+}
+
+const std::string &PlayerLoad::randomFile() {
+    std::uniform_int_distribution<size_t> index(0, config.files.size() - 1);
+    return config.files[index(rng)];
+}
+
+bool PlayerLoad::sleepFor(std::chrono::milliseconds duration) {
+    std::unique_lock<std::mutex> lock(stopMutex);
+    return !stopWakeup.wait_for(lock, duration,
+                                [this]() { return !isRunning; });
+}
+
+MixerLoad::MixerLoad(const SoakConfig &config, int index)
+    : config(config),
+      mixer(std::make_unique<AudioMixer>(mixerConfig(index))),
+      rng(config.seed + 1000 + index) {}
+
+MixerLoad::~MixerLoad() { stop(); }
+
+bool MixerLoad::start() {
+    if (!mixer->open()) {
+        return false;
+    }
+    isRunning = true;
+    controlThread = std::thread(&MixerLoad::controlLoop, this);
+    return true;
+}
+
+void MixerLoad::stop() {
+    {
+        std::lock_guard<std::mutex> lock(stopMutex);
+        isRunning = false;
+    }
+    stopWakeup.notify_all();
+    if (controlThread.joinable()) {
+        controlThread.join();
+    }
+    mixer->close();
+}
+
+LoadStats MixerLoad::getStats() const {
+    MixerStats stats = mixer->getStats();
+    LoadStats load;
+    load.callbacks = stats.callbacks;
+    load.underruns = stats.voiceUnderruns;
+    load.operations = operations.load();
+    load.failures = failures.load();
+    load.callback = stats.callback;
+    return load;
+}
+
+void MixerLoad::controlLoop() {
+    // 声部的启动和停止比播放器的操作轻，按四倍频率进行
+    int interval = std::max(1, config.stormIntervalMs / 4);
+    while (sleepFor(nextInterval(rng, interval))) {
+        storm();
+    }
+}
+
+void MixerLoad::storm() {
+    operations++;
+    std::uniform_int_distribution<int> choice(0, 99);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    int roll = choice(rng);
+    auto pick = [this]() {
+        std::uniform_int_distribution<size_t> index(0, voices.size() - 1);
+        return voices[index(rng)];
+    };
+
+    if (roll < 50 || voices.empty()) {
+        std::uniform_int_distribution<size_t> index(0, config.files.size() - 1);
+        VoiceParams params;
+        params.gain = unit(rng);
+        params.pan = unit(rng) * 2.0f - 1.0f;
+        VoiceId voice = mixer->play(config.files[index(rng)], params);
+        if (voice == INVALID_VOICE) {
+            failures++;
+            return;
+        }
+        if (voices.size() >= MAX_TRACKED_VOICES) {
+            voices.erase(voices.begin());
+        }
+        voices.push_back(voice);
+    } else if (roll < 75) {
+        mixer->stop(pick());
+    } else if (roll < 97) {
+        VoiceId voice = pick();
+        mixer->setGain(voice, unit(rng));
+        mixer->setPan(voice, unit(rng) * 2.0f - 1.0f);
+    } else {
+        mixer->stopAll();
+        voices.clear();
+    }
+}
+
+bool MixerLoad::sleepFor(std::chrono::milliseconds duration) {
+    std::unique_lock<std::mutex> lock(stopMutex);
+    return !stopWakeup.wait_for(lock, duration,
+                                [this]() { return !isRunning; });
+}
+
+CpuContention::~CpuContention() { stop(); }
+
+void CpuContention::start(int threads, int duty) {
+    stop();
+    isRunning = true;
+    auto busy = std::chrono::microseconds(
+        std::clamp(duty, 0, 100) * CONTENTION_PERIOD_MS * 10);
+    auto period = std::chrono::milliseconds(CONTENTION_PERIOD_MS);
+    for (int i = 0; i < threads; ++i) {
+        workers.emplace_back([this, busy, period]() {
+            volatile uint64_t sink = 0;
+            while (isRunning.load(std::memory_order_relaxed)) {
+                auto start = std::chrono::steady_clock::now();
+                while (std::chrono::steady_clock::now() - start < busy) {
+                    for (int k = 0; k < 1000; ++k) {
+                        sink = sink * 6364136223846793005ULL + 1;
+                    }
+                }
+                std::this_thread::sleep_until(start + period);
+            }
+        });
+    }
+}
+
+void CpuContention::stop() {
+    isRunning = false;
+    for (auto &worker : workers) {
+        worker.join();
+    }
+    workers.clear();
+}
+
+size_t currentRssBytes() {
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS counters;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &counters,
+                             sizeof(counters))) {
+        return counters.WorkingSetSize;
+    }
+    return 0;
+#elif defined(__APPLE__)
+    mach_task_basic_info_data_t info;
+    mach_msg_type_number_t count = MACH_TASK_BASIC_INFO_COUNT;
+    if (task_info(mach_task_self(), MACH_TASK_BASIC_INFO,
+                  reinterpret_cast<task_info_t>(&info),
+                  &count) == KERN_SUCCESS) {
+        return info.resident_size;
+    }
+    return 0;
+#else
+    // statm的第二项为常驻页数
+    std::ifstream statm("/proc/self/statm");
+    size_t pages = 0;
+    size_t resident = 0;
+    if (statm >> pages >> resident) {
+        return resident * static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    }
+    return 0;
+#endif
+}
@@ -0,0 +1,383 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "bench_signals.h"
+#include "logger.h"
+#include "soak.h"
+
+// 浸泡测试：多个播放器和混音器在不需要声卡的SDL驱动上长时间运行，同时
+// 制造CPU争用和随机的定位、切换操作。定期记录欠载次数、回调耗时分位数
+// 和常驻内存，结束时按SLO判定，未达标时返回1
+//
+//   texas_soak [选项] [文件...]    不指定文件时使用生成的各编码格式测试信号
+
+namespace {
+
+std::atomic<bool> interrupted{false};
+
+void onSignal(int) { interrupted = true; }
+
+// 所有实例汇总后的一次采样
+struct SoakSample {
+    double elapsedSeconds{0.0};
+    uint64_t callbacks{0};
+    uint64_t underruns{0};       // 播放器
+    uint64_t voiceUnderruns{0};  // 混音器声部
+    uint64_t operations{0};
+    uint64_t flushes{0};
+    uint64_t failures{0};
+    // 所有实例中最差的回调耗时（微秒），直方图从启动开始累计
+    double callbackP50Us{0.0};
+    double callbackP99Us{0.0};
+    double callbackP999Us{0.0};
+    double callbackMaxUs{0.0};
+    double rssMb{0.0};
+};
+
+void printUsage() {
+    std::cerr
+        << "用法: texas_soak [选项] [文件...]\n"
+           "  --players N            播放器数（默认4）\n"
+           "  --mixers N             混音器数（默认1）\n"
+           "  --duration 秒          运行时长（默认3600）\n"
+           "  --report 秒            采样间隔（默认60）\n"
+           "  --warmup 秒            内存增长基线的采样时间（默认60）\n"
+           "  --contention N         CPU争用线程数（默认0）\n"
+           "  --duty 百分比          争用线程的忙碌比例（默认100）\n"
+           "  --storm 毫秒           随机操作的平均间隔（默认500）\n"
+           "  --latency 毫秒         播放器目标延迟（默认0）\n"
+           "  --pipeline 模式        threaded、direct或on_demand\n"
+           "  --driver 名称          SDL音频驱动（默认SDL_AUDIODRIVER或dummy）\n"
+           "  --seed N               随机种子（默认1）\n"
+           "  --out 文件             每次采样追加一行JSON\n"
+           "  --max-underruns-per-hour N  （默认60）\n"
+           "  --max-underruns-per-flush N （默认2）\n"
+           "  --max-voice-underruns-per-hour N （默认60）\n"
+           "  --max-callback-p99-us N     （默认2000）\n"
+           "  --max-callback-max-us N     （默认0，不检查）\n"
+           "  --max-rss-growth-mb N       （默认32）\n";
+}
+
+bool parsePipeline(const std::string &name, PipelineMode &mode) {
+    if (name == "threaded") {
+        mode = PipelineMode::THREADED;
+    } else if (name == "direct") {
+        mode = PipelineMode::DIRECT;
+    } else if (name == "on_demand") {
+        mode = PipelineMode::ON_DEMAND;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+bool parseArgs(int argc, char **argv, SoakConfig &config) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg.rfind("--", 0) != 0) {
+            config.files.push_back(arg);
+            continue;
+        }
+        if (i + 1 >= argc) {
+            return false;
+        }
+        std::string value = argv[++i];
+        if (arg == "--players") {
+            config.players = std::stoi(value);
+        } else if (arg == "--mixers") {
+            config.mixers = std::stoi(value);
+        } else if (arg == "--duration") {
+            config.durationSeconds = std::stod(value);
+        } else if (arg == "--report") {
+            config.reportSeconds = std::stod(value);
+        } else if (arg == "--warmup") {
+            config.warmupSeconds = std::stod(value);
+        } else if (arg == "--contention") {
+            config.contentionThreads = std::stoi(value);
+        } else if (arg == "--duty") {
+            config.contentionDuty = std::stoi(value);
+        } else if (arg == "--storm") {
+            config.stormIntervalMs = std::stoi(value);
+        } else if (arg == "--latency") {
+            config.targetLatencyMs = std::stoi(value);
+        } else if (arg == "--pipeline") {
+            if (!parsePipeline(value, config.pipelineMode)) {
+                return false;
+            }
+        } else if (arg == "--driver") {
+            config.driver = value;
+        } else if (arg == "--seed") {
+            config.seed = std::stoull(value);
+        } else if (arg == "--out") {
+            config.outputFile = value;
+        } else if (arg == "--max-underruns-per-hour") {
+            config.maxUnderrunsPerHour = std::stod(value);
+        } else if (arg == "--max-underruns-per-flush") {
+            config.maxUnderrunsPerFlush = std::stod(value);
+        } else if (arg == "--max-voice-underruns-per-hour") {
+            config.maxVoiceUnderrunsPerHour = std::stod(value);
+        } else if (arg == "--max-callback-p99-us") {
+            config.maxCallbackP99Us = std::stod(value);
+        } else if (arg == "--max-callback-max-us") {
+            config.maxCallbackMaxUs = std::stod(value);
+        } else if (arg == "--max-rss-growth-mb") {
+            config.maxRssGrowthMb = std::stod(value);
+        } else {
+            return false;
+        }
+    }
+    return config.players >= 0 && config.mixers >= 0 &&
+           config.players + config.mixers > 0 && config.reportSeconds > 0;
+}
+
+// 没有指定文件时生成测试信号，缺少编码器的格式跳过
+bool prepareFiles(SoakConfig &config) {
+    if (!config.files.empty()) {
+        return true;
+    }
+    for (const auto &codec : benchCodecs()) {
+        std::string error;
+        std::string path = benchSignalFile(codec, error);
+        if (path.empty()) {
+            std::cerr << "跳过" << codec.name << ": " << error << "\n";
+            continue;
+        }
+        config.files.push_back(path);
+    }
+    return !config.files.empty();
+}
+
+SoakSample collect(const std::vector<std::unique_ptr<PlayerLoad>> &players,
+                   const std::vector<std::unique_ptr<MixerLoad>> &mixers,
+                   double elapsed) {
+    SoakSample sample;
+    sample.elapsedSeconds = elapsed;
+    auto add = [&sample](const LoadStats &stats) {
+        sample.callbacks += stats.callbacks;
+        sample.operations += stats.operations;
+        sample.flushes += stats.flushes;
+        sample.failures += stats.failures;
+        sample.callbackP50Us =
+            std::max(sample.callbackP50Us, stats.callback.p50 / 1000.0);
+        sample.callbackP99Us =
+            std::max(sample.callbackP99Us, stats.callback.p99 / 1000.0);
+        sample.callbackP999Us =
+            std::max(sample.callbackP999Us, stats.callback.p999 / 1000.0);
+        sample.callbackMaxUs =
+            std::max(sample.callbackMaxUs, stats.callback.max / 1000.0);
+    };
+    for (const auto &player : players) {
+        LoadStats stats = player->getStats();
+        sample.underruns += stats.underruns;
+        add(stats);
+    }
+    for (const auto &mixer : mixers) {
+        LoadStats stats = mixer->getStats();
+        sample.voiceUnderruns += stats.underruns;
+        add(stats);
+    }
+    sample.rssMb = currentRssBytes() / (1024.0 * 1024.0);
+    return sample;
+}
+
+std::string toJson(const SoakSample &sample) {
+    std::ostringstream out;
+    out << "{\"elapsed\":" << sample.elapsedSeconds
+        << ",\"callbacks\":" << sample.callbacks
+        << ",\"underruns\":" << sample.underruns
+        << ",\"voice_underruns\":" << sample.voiceUnderruns
+        << ",\"operations\":" << sample.operations
+        << ",\"flushes\":" << sample.flushes
+        << ",\"failures\":" << sample.failures
+        << ",\"callback_p50_us\":" << sample.callbackP50Us
+        << ",\"callback_p99_us\":" << sample.callbackP99Us
+        << ",\"callback_p999_us\":" << sample.callbackP999Us
+        << ",\"callback_max_us\":" << sample.callbackMaxUs
+        << ",\"rss_mb\":" << sample.rssMb << "}";
+    return out.str();
+}
+
+void printSample(const SoakSample &sample) {
+    char line[256];
+    std::snprintf(line, sizeof(line),
+                  "[%8.0fs] callbacks %llu underruns %llu/%llu ops %llu "
+                  "flushes %llu failures %llu | callback p99 %.0fus "
+                  "p999 %.0fus max %.0fus | rss %.1fMB",
+                  sample.elapsedSeconds,
+                  static_cast<unsigned long long>(sample.callbacks),
+                  static_cast<unsigned long long>(sample.underruns),
+                  static_cast<unsigned long long>(sample.voiceUnderruns),
+                  static_cast<unsigned long long>(sample.operations),
+                  static_cast<unsigned long long>(sample.flushes),
+                  static_cast<unsigned long long>(sample.failures),
+                  sample.callbackP99Us, sample.callbackP999Us,
+                  sample.callbackMaxUs, sample.rssMb);
+    std::cout << line << std::endl;
+}
+
+// 按SLO判定最后一次采样，baseline为预热结束时的采样（没有时为nullptr）
+bool checkSlos(const SoakConfig &config, const SoakSample &last,
+               const SoakSample *baseline) {
+    bool passed = true;
+    auto report = [&passed](const char *name, double value, double limit,
+                            bool ok) {
+        std::cout << (ok ? "PASS " : "FAIL ") << name << ": " << value
+                  << " (limit " << limit << ")" << std::endl;
+        passed = passed && ok;
+    };
+
+    double hours = last.elapsedSeconds / 3600.0;
+    double underrunBudget = config.maxUnderrunsPerHour * hours +
+                            config.maxUnderrunsPerFlush * last.flushes;
+    report("underruns", static_cast<double>(last.underruns), underrunBudget,
+           last.underruns <= underrunBudget);
+    double voiceBudget = config.maxVoiceUnderrunsPerHour * hours;
+    report("voice underruns", static_cast<double>(last.voiceUnderruns),
+           voiceBudget, last.voiceUnderruns <= voiceBudget);
+    report("callback p99 us", last.callbackP99Us, config.maxCallbackP99Us,
+           last.callbackP99Us <= config.maxCallbackP99Us);
+    if (config.maxCallbackMaxUs > 0) {
+        report("callback max us", last.callbackMaxUs, config.maxCallbackMaxUs,
+               last.callbackMaxUs <= config.maxCallbackMaxUs);
+    }
+    if (baseline && baseline->rssMb > 0) {
+        double growth = last.rssMb - baseline->rssMb;
+        report("rss growth MB", growth, config.maxRssGrowthMb,
+               growth <= config.maxRssGrowthMb);
+    } else {
+        std::cout << "SKIP rss growth: 运行时间短于预热时间或平台不支持"
+                  << std::endl;
+    }
+    return passed;
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+    SoakConfig config;
+    try {
+        if (!parseArgs(argc, argv, config)) {
+            printUsage();
+            return 2;
+        }
+    } catch (const std::exception &) {
+        printUsage();
+        return 2;
+    }
+
+    // 日志只写文件且只保留警告，欠载等异常仍然有记录
+    Logger::LoggerConfig lconfig;
+    lconfig.filename = "logs/soak.log";
+    lconfig.level = Logger::Level::WARN;
+    lconfig.console_output = false;
+    lconfig.async_mode = true;
+    Logger::getInstance().initialize(lconfig);
+
+    if (!config.driver.empty()) {
+        SDL_setenv("SDL_AUDIODRIVER", config.driver.c_str(), 1);
+    } else {
+        SDL_setenv("SDL_AUDIODRIVER", "dummy", 0);
+    }
+    std::signal(SIGINT, onSignal);
+    std::signal(SIGTERM, onSignal);
+
+    if (!prepareFiles(config)) {
+        std::cerr << "没有可用的测试文件" << std::endl;
+        return 2;
+    }
+
+    std::ofstream output;
+    if (!config.outputFile.empty()) {
+        output.open(config.outputFile, std::ios::app);
+        if (!output) {
+            std::cerr << "无法打开输出文件: " << config.outputFile << std::endl;
+            return 2;
+        }
+    }
+
+    std::vector<std::unique_ptr<PlayerLoad>> players;
+    std::vector<std::unique_ptr<MixerLoad>> mixers;
+    for (int i = 0; i < config.players; ++i) {
+        players.push_back(std::make_unique<PlayerLoad>(config, i));
+        if (!players.back()->start()) {
+            std::cerr << "播放器" << i << "启动失败" << std::endl;
+            return 2;
+        }
+    }
+    for (int i = 0; i < config.mixers; ++i) {
+        mixers.push_back(std::make_unique<MixerLoad>(config, i));
+        if (!mixers.back()->start()) {
+            std::cerr << "混音器" << i << "启动失败" << std::endl;
+            return 2;
+        }
+    }
+    CpuContention contention;
+    contention.start(config.contentionThreads, config.contentionDuty);
+
+    std::cout << "soak: " << config.players << " players, " << config.mixers
+              << " mixers, " << config.files.size() << " files, "
+              << config.contentionThreads << " contention threads, "
+              << config.durationSeconds << "s" << std::endl;
+
+    auto start = std::chrono::steady_clock::now();
+    auto elapsed = [start]() {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                             start)
+            .count();
+    };
+    auto deadline = std::chrono::duration<double>(config.durationSeconds);
+    auto interval = std::chrono::duration<double>(config.reportSeconds);
+    auto nextReport = start + interval;
+
+    SoakSample last;
+    SoakSample baseline;
+    bool hasBaseline = false;
+    bool finished = false;
+    while (!finished) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        auto now = std::chrono::steady_clock::now();
+        finished = interrupted || now - start >= deadline;
+        if (now < nextReport && !finished) {
+            continue;
+        }
+        nextReport += interval;
+
+        last = collect(players, mixers, elapsed());
+        if (!hasBaseline && last.elapsedSeconds >= config.warmupSeconds) {
+            baseline = last;
+            hasBaseline = true;
+        }
+        printSample(last);
+        if (output) {
+            output << toJson(last) << std::endl;
+        }
+    }
+
+    contention.stop();
+    for (auto &player : players) {
+        player->stop();
+    }
+    for (auto &mixer : mixers) {
+        mixer->stop();
+    }
+
+    // 基线就是最后一次采样时不判定内存增长
+    bool baselineUsable =
+        hasBaseline && baseline.elapsedSeconds < last.elapsedSeconds;
+    bool passed = checkSlos(config, last, baselineUsable ? &baseline : nullptr);
+
+    players.clear();
+    mixers.clear();
+    Logger::getInstance().shutdown();
+    return passed ? 0 : 1;
+}
@@ -1,3 +1,8 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+
 #include "audio_decoder.h"
 #include "logger.h"
 
@@ -9,66 +14,280 @@ std::string getErrorString(int error) {
     av_strerror(error, errbuf, ERROR_BUFFER_SIZE);
     return std::string(errbuf);
 }
+
+// 帧中解码后PCM数据的字节数
+size_t getFrameBytes(const AVFrame *frame) {
+    int size = av_samples_get_buffer_size(
+        nullptr, frame->ch_layout.nb_channels, frame->nb_samples,
+        static_cast<AVSampleFormat>(frame->format), 1);
+    return size > 0 ? static_cast<size_t>(size) : 0;
+}
+
+// 第一个音频流的序号，没有时返回-1
+int findAudioStream(const AVFormatContext *formatCtx) {
+    for (unsigned int i = 0; i < formatCtx->nb_streams; i++) {
+        if (formatCtx->streams[i]->codecpar->codec_type == AVMEDIA_TYPE_AUDIO) {
+            return static_cast<int>(i);
+        }
+    }
+    return -1;
+}
+
+// 封面和其他流的数据包在解复用时直接跳过
+void discardOtherStreams(AVFormatContext *formatCtx, int audioStream) {
+    for (unsigned int i = 0; i < formatCtx->nb_streams; i++) {
+        if (static_cast<int>(i) != audioStream) {
+            formatCtx->streams[i]->discard = AVDISCARD_ALL;
+        }
+    }
+}
+
+const char *findTag(const AVFormatContext *formatCtx, const AVStream *stream,
+                    const char *key) {
+    const AVDictionaryEntry *entry = av_dict_get(stream->metadata, key,
+                                                 nullptr, 0);
+    if (!entry) {
+        entry = av_dict_get(formatCtx->metadata, key, nullptr, 0);
+    }
+    return entry ? entry->value : nullptr;
+}
+
+// 曲目增益标签，换算到ReplayGain的参考响度（-18 LUFS），没有时为NaN。
+// R128_TRACK_GAIN（Opus）是相对-23 LUFS的Q7.8定点数
+double readTrackGain(const AVFormatContext *formatCtx, const AVStream *stream) {
+    const char *value = findTag(formatCtx, stream, "REPLAYGAIN_TRACK_GAIN");
+    char *end = nullptr;
+    if (value) {
+        double gain = std::strtod(value, &end);
+        if (end != value && std::isfinite(gain)) {
+            return gain;
+        }
+    }
+    value = findTag(formatCtx, stream, "R128_TRACK_GAIN");
+    if (value) {
+        long q78 = std::strtol(value, &end, 10);
+        if (end != value) {
+            return q78 / 256.0 + 5.0;
+        }
+    }
+    return NAN;
+}
+
+// 缓存命中时跳过了探测，头部没有给出的参数按上次打开时解码器报告的补上
+void applyCachedParameters(AVCodecParameters *params, const MediaInfo &info) {
+    if (params->sample_rate <= 0) {
+        params->sample_rate = info.sampleRate;
+    }
+    if (params->ch_layout.nb_channels <= 0 && info.channels > 0) {
+        av_channel_layout_uninit(&params->ch_layout);
+        if (info.channelLayout == 0 ||
+            av_channel_layout_from_mask(&params->ch_layout,
+                                        info.channelLayout) < 0) {
+            av_channel_layout_default(&params->ch_layout, info.channels);
+        }
+    }
+    if (params->format < 0) {
+        params->format = info.sampleFormat;
+    }
+}
 }  // namespace
 
+const char *audioDecoderErrorString(AudioDecoderError error) {
+    switch (error) {
+        case AudioDecoderError::SUCCESS:
+            return "success";
+        case AudioDecoderError::FILE_OPEN_ERROR:
+            return "could not open file";
+        case AudioDecoderError::STREAM_INFO_ERROR:
+            return "could not find stream information";
+        case AudioDecoderError::NO_AUDIO_STREAM:
+            return "no audio stream";
+        case AudioDecoderError::CODEC_NOT_FOUND:
+            return "codec not found";
+        case AudioDecoderError::CODEC_CONTEXT_ALLOC_ERROR:
+            return "could not allocate codec context";
+        case AudioDecoderError::CODEC_PARAMS_ERROR:
+            return "could not copy codec parameters";
+        case AudioDecoderError::CODEC_OPEN_ERROR:
+            return "could not open codec";
+    }
+    return "unknown error";
+}
+
 AudioDecoder::AudioDecoder(const AudioDecoderConfig &config)
     : config(config),
       formatContext(nullptr),
       codecContext(nullptr),
-      isDecoding(false),
-      currentPts(0.0) {
+      frameQueue(config.maxQueueSize),
+      framePool(config.maxQueueSize + 2),
+      packet(av_packet_alloc()) {
     _logger = Logger::getInstance().getLogger("AudioDecoder");
 }
 
 AudioDecoder::~AudioDecoder() {
     stop();
+    cancelSeekIndexBuild();
     cleanup();
 }
 
 void AudioDecoder::close() {
     stop();
+    cancelSeekIndexBuild();
     cleanup();
+    prefetcher.flush();
     formatContext.reset();
     codecContext.reset();
+    input.reset();
     audioStreamIndex = -1;
 }
 
 void AudioDecoder::cleanup() {
-    // 清理帧队列
+    // 清理帧队列，帧归还到帧池
     std::lock_guard<std::mutex> lock(frameQueueMutex);
-    while (!frameQueue.empty()) {
-        av_frame_free(&frameQueue.front());
-        frameQueue.pop();
+    clearQueue();
+}
+
+// 关闭当前输入并重置解码状态，自定义IO的formatContext先于input释放
+void AudioDecoder::resetInput() {
+    cancelSeekIndexBuild();
+    prefetcher.stop();
+    prefetcher.flush();
+    formatContext.reset();
+    codecContext.reset();
+    input.reset();
+    draining = false;
+    lastPacketPts = AV_NOPTS_VALUE;
+    resumePts = AV_NOPTS_VALUE;
+    streamTimeBase = AVRational{0, 1};
+    streamDuration = 0.0;
+    trackGainDb = NAN;
+    hasFileIdentity = false;
+    sampleClock = -1;
+    seekTargetSamples = -1;
+    queueHighWater = 0;
+    {
+        std::lock_guard<std::mutex> lock(seekIndexMutex);
+        seekIndex.reset();
     }
 }
 
 AudioDecoderError AudioDecoder::open(const std::string &filename) {
     // 确保之前的资源被释放
-    formatContext.reset();
-    codecContext.reset();
+    resetInput();
+    currentFile = filename;
+    if (!isNetworkInput()) {
+        hasFileIdentity = FileIdentity::get(filename, fileIdentity);
+    }
+
+    // 网络流等URL仍交给FFmpeg的协议层
+    if (config.memoryMapInput && !isNetworkInput()) {
+        input = MediaInput::mapFile(filename);
+        if (!input) {
+            _logger->debug("Memory mapping unavailable, using file IO: {}",
+                           filename);
+        }
+    }
+    return openInput(filename);
+}
+
+AudioDecoderError AudioDecoder::open(const uint8_t *data, size_t size,
+                                     const std::string &name) {
+    resetInput();
+    currentFile.clear();
+
+    input = MediaInput::fromMemory(data, size);
+    if (!input) {
+        _logger->error("Could not open memory input: {} ({} bytes)", name,
+                       size);
+        return AudioDecoderError::FILE_OPEN_ERROR;
+    }
+    return openInput(name);
+}
+
+// 打开解复用器：内存输入使用自定义IO，网络输入设置读写超时，
+// 阻塞的读取可以被预读线程的stop()中断
+int AudioDecoder::openFormat(const std::string &url,
+                             AVFormatContext **formatCtx) {
+    AVFormatContext *ctx = avformat_alloc_context();
+    if (!ctx) {
+        return AVERROR(ENOMEM);
+    }
+    ctx->interrupt_callback.callback = &AudioDecoder::interruptCallback;
+    ctx->interrupt_callback.opaque = this;
+    if (input) {
+        ctx->pb = input->getIOContext();
+        ctx->flags |= AVFMT_FLAG_CUSTOM_IO;
+    }
+
+    AVDictionary *opts = nullptr;
+    if (isNetworkInput()) {
+        static std::once_flag networkInit;
+        std::call_once(networkInit, []() { avformat_network_init(); });
+    }
+    if (config.probeSizeBytes > 0) {
+        av_dict_set_int(&opts, "probesize", config.probeSizeBytes, 0);
+    }
+    if (config.analyzeDurationMs > 0) {
+        av_dict_set_int(&opts, "analyzeduration",
+                        static_cast<int64_t>(config.analyzeDurationMs) * 1000,
+                        0);
+    }
+    if (isNetworkInput() && config.prefetch.ioTimeoutMs > 0) {
+        av_dict_set_int(&opts, "rw_timeout",
+                        static_cast<int64_t>(config.prefetch.ioTimeoutMs) *
+                            1000,
+                        0);
+    }
+    // 打开失败时avformat_open_input会释放ctx
+    int ret = avformat_open_input(&ctx, url.c_str(), nullptr, &opts);
+    av_dict_free(&opts);
+    if (ret >= 0) {
+        *formatCtx = ctx;
+    }
+    return ret;
+}
 
+int AudioDecoder::interruptCallback(void *opaque) {
+    return static_cast<AudioDecoder *>(opaque)->prefetcher.isStopping();
+}
+
+AudioDecoderError AudioDecoder::openInput(const std::string &url) {
+    auto startTime = std::chrono::steady_clock::now();
     AVFormatContext *formatCtx = nullptr;
-    int ret =
-        avformat_open_input(&formatCtx, filename.c_str(), nullptr, nullptr);
+    int ret = openFormat(url, &formatCtx);
     if (ret < 0) {
-        _logger->error("Could not open file: {} - {}", filename,
+        _logger->error("Could not open file: {} - {}", url,
                        getErrorString(ret));
         return AudioDecoderError::FILE_OPEN_ERROR;
     }
     formatContext.reset(formatCtx);
 
-    if (avformat_find_stream_info(formatCtx, nullptr) < 0) {
-        _logger->error("Could not find stream information");
-        return AudioDecoderError::STREAM_INFO_ERROR;
+    // 缓存中有同一文件的探测结果时同样跳过探测
+    MediaInfo cached;
+    bool cacheHit = config.mediaInfoCache && hasFileIdentity &&
+                    config.mediaInfoCache->find(currentFile, fileIdentity,
+                                                 cached);
+    audioStreamIndex = findAudioStream(formatCtx);
+    if (cacheHit) {
+        cacheHit = cached.streamIndex == audioStreamIndex &&
+                   formatCtx->streams[audioStreamIndex]->codecpar->codec_id ==
+                       cached.codecId;
+    }
+    if (cacheHit) {
+        applyCachedParameters(formatCtx->streams[audioStreamIndex]->codecpar,
+                              cached);
     }
 
-    // 查找音频流
-    audioStreamIndex = -1;
-    for (unsigned int i = 0; i < formatCtx->nb_streams; i++) {
-        if (formatCtx->streams[i]->codecpar->codec_type == AVMEDIA_TYPE_AUDIO) {
-            audioStreamIndex = i;
-            break;
+    // 头部信息可信时直接使用，跳过解码各个流开头的探测；
+    // 打开解码器后参数仍不完整时再探测一次
+    bool probed = !cacheHit && (config.probeMode == ProbeMode::FULL ||
+                                !isHeaderTrusted());
+    if (probed) {
+        if (avformat_find_stream_info(formatCtx, nullptr) < 0) {
+            _logger->error("Could not find stream information");
+            return AudioDecoderError::STREAM_INFO_ERROR;
         }
+        audioStreamIndex = findAudioStream(formatCtx);
     }
 
     if (audioStreamIndex == -1) {
@@ -76,9 +295,97 @@ AudioDecoderError AudioDecoder::open(const std::string &filename) {
         return AudioDecoderError::NO_AUDIO_STREAM;
     }
 
-    // 获取解码器
+    AudioDecoderError error = openCodec();
+    if (error == AudioDecoderError::SUCCESS && !probed &&
+        (codecContext->sample_fmt == AV_SAMPLE_FMT_NONE ||
+         codecContext->sample_rate <= 0 ||
+         codecContext->ch_layout.nb_channels <= 0)) {
+        _logger->debug("Header parameters incomplete, probing streams");
+        cacheHit = false;
+        if (avformat_find_stream_info(formatCtx, nullptr) < 0) {
+            _logger->error("Could not find stream information");
+            return AudioDecoderError::STREAM_INFO_ERROR;
+        }
+        probed = true;
+        error = openCodec();
+    }
+    if (error != AudioDecoderError::SUCCESS) {
+        return error;
+    }
+
+    AVStream *stream = formatCtx->streams[audioStreamIndex];
+    streamTimeBase = stream->time_base;
+    if (stream->duration != AV_NOPTS_VALUE) {
+        streamDuration = stream->duration * av_q2d(stream->time_base);
+    } else if (formatCtx->duration != AV_NOPTS_VALUE) {
+        streamDuration = formatCtx->duration / (double)AV_TIME_BASE;
+    } else {
+        streamDuration = 0.0;  // 直播流
+    }
+    if (cacheHit) {
+        // 没有头部时长的格式（如没有Xing头的MP3）用上次探测的结果
+        streamDuration = cached.duration;
+    }
+    trackGainDb = readTrackGain(formatCtx, stream);
+    if (!cacheHit && config.mediaInfoCache && hasFileIdentity) {
+        config.mediaInfoCache->insert(currentFile, fileIdentity,
+                                      getMediaInfo());
+    }
+
+    discardOtherStreams(formatCtx, audioStreamIndex);
+
+    auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - startTime);
+    _logger->debug("Opened {} in {} us ({})", url, elapsed.count(),
+                   probed     ? "probed"
+                   : cacheHit ? "cached"
+                              : "header only");
+
+    if (config.seekIndexMode == SeekIndexMode::ON_OPEN) {
+        seekIndexThread = std::thread([this]() {
+            auto index = readSeekIndex();
+            std::lock_guard<std::mutex> lock(seekIndexMutex);
+            seekIndex = index;
+        });
+    }
+
+    return AudioDecoderError::SUCCESS;
+}
+
+// 容器头部给出了完整的音频参数和时长，且编码格式的头部参数就是解码输出参数。
+// AAC等格式的头部可能只描述核心层（如HE-AAC的SBR使采样率翻倍），需要解码确认
+bool AudioDecoder::isHeaderTrusted() const {
+    if (audioStreamIndex < 0 ||
+        (formatContext->ctx_flags & AVFMTCTX_NOHEADER)) {
+        return false;
+    }
+    const AVStream *stream = formatContext->streams[audioStreamIndex];
+    const AVCodecParameters *params = stream->codecpar;
+    if (params->sample_rate <= 0 || params->ch_layout.nb_channels <= 0) {
+        return false;
+    }
+
+    AVCodecID id = params->codec_id;
+    bool exactHeader = (id >= AV_CODEC_ID_PCM_S16LE &&
+                        id < AV_CODEC_ID_ADPCM_IMA_QT) ||
+                       id == AV_CODEC_ID_FLAC || id == AV_CODEC_ID_ALAC ||
+                       id == AV_CODEC_ID_VORBIS || id == AV_CODEC_ID_OPUS ||
+                       id == AV_CODEC_ID_MP3 || id == AV_CODEC_ID_MP2 ||
+                       id == AV_CODEC_ID_WAVPACK || id == AV_CODEC_ID_TTA;
+    if (!exactHeader) {
+        return false;
+    }
+
+    // 直播流本来就没有时长，其他输入缺少时长说明需要探测来估算
+    bool hasDuration = stream->duration != AV_NOPTS_VALUE ||
+                       formatContext->duration != AV_NOPTS_VALUE;
+    return hasDuration || isNetworkInput();
+}
+
+// 按当前流参数创建并打开解码器，探测后可以再次调用
+AudioDecoderError AudioDecoder::openCodec() {
     AVCodecParameters *codecParams =
-        formatCtx->streams[audioStreamIndex]->codecpar;
+        formatContext->streams[audioStreamIndex]->codecpar;
     codec = avcodec_find_decoder(codecParams->codec_id);
     if (!codec) {
         _logger->error("Codec not found");
@@ -98,35 +405,74 @@ AudioDecoderError AudioDecoder::open(const std::string &filename) {
         return AudioDecoderError::CODEC_PARAMS_ERROR;
     }
 
+    // 设置时间基准，解码出的帧时间戳与流时间基准一致
+    codecCtx->pkt_timebase =
+        formatContext->streams[audioStreamIndex]->time_base;
+
+    // 解码器内部线程，FFmpeg只启用解码器支持的方式
+    codecCtx->thread_count = std::max(0, config.codecThreads);
+    switch (config.codecThreading) {
+        case CodecThreading::FRAME:
+            codecCtx->thread_type = FF_THREAD_FRAME;
+            break;
+        case CodecThreading::SLICE:
+            codecCtx->thread_type = FF_THREAD_SLICE;
+            break;
+        case CodecThreading::FRAME_AND_SLICE:
+            codecCtx->thread_type = FF_THREAD_FRAME | FF_THREAD_SLICE;
+            break;
+    }
+
     // 设置解码器选项
     AVDictionary *opts = nullptr;
     av_dict_set(&opts, "strict", "experimental", 0);  // 使用实验性功能
 
     // 打开解码器
-    ret = avcodec_open2(codecCtx, codec, &opts);
+    int ret = avcodec_open2(codecCtx, codec, &opts);
     av_dict_free(&opts);  // 释放字典，无论是否成功都需要释放
 
     if (ret < 0) {
         _logger->error("Could not open codec");
         return AudioDecoderError::CODEC_OPEN_ERROR;
     }
-
-    // 设置时间基准
-    codecCtx->pkt_timebase = formatCtx->streams[audioStreamIndex]->time_base;
-
+    if (config.codecThreads != 1) {
+        _logger->debug("{} decoder: {} threads, {}", codec->name,
+                       codecCtx->thread_count,
+                       codecCtx->active_thread_type == FF_THREAD_FRAME
+                           ? "frame threading"
+                       : codecCtx->active_thread_type == FF_THREAD_SLICE
+                           ? "slice threading"
+                           : "single-threaded");
+    }
     return AudioDecoderError::SUCCESS;
 }
 
 void AudioDecoder::start() {
-    if (!isDecoding) {
-        isDecoding = true;
+    if (!isDecoding.load(std::memory_order_acquire)) {
+        {
+            std::lock_guard<std::mutex> lock(frameQueueMutex);
+            endOfStream = false;
+        }
+        isDecoding.store(true, std::memory_order_release);
+        if (shouldPrefetch()) {
+            prefetcher.start(
+                config.prefetch, streamTimeBase,
+                [this](AVPacket *pkt) { return readAudioPacket(pkt); },
+                [this]() { return reconnectInput(); });
+        }
         decoderThread = std::thread(&AudioDecoder::decodeLoop, this);
     }
 }
 
 void AudioDecoder::stop() {
-    if (isDecoding) {
-        isDecoding = false;
+    if (isDecoding.load(std::memory_order_acquire)) {
+        {
+            // 在锁内清除，避免等待方检查谓词后、进入等待前错过通知
+            std::lock_guard<std::mutex> lock(frameQueueMutex);
+            isDecoding.store(false, std::memory_order_release);
+        }
+        // 先停预读线程，解码线程会从pop()返回AVERROR_EXIT
+        prefetcher.stop();
         frameAvailable.notify_all();
         queueNotFull.notify_all();
         if (decoderThread.joinable()) {
@@ -135,26 +481,49 @@ void AudioDecoder::stop() {
     }
 }
 
+// 按帧数、字节数和时长三种上限判断队列是否已满，调用方需持有frameQueueMutex
+bool AudioDecoder::isQueueFull() const {
+    // 空队列总能放入一帧，避免单帧超过字节或时长上限时死锁
+    if (frameQueue.empty()) {
+        return false;
+    }
+    if (config.maxQueueSize > 0 && frameQueue.size() >= config.maxQueueSize) {
+        return true;
+    }
+    if (config.maxQueueBytes > 0 && queuedBytes >= config.maxQueueBytes) {
+        return true;
+    }
+    if (config.maxQueueDurationMs > 0 && codecContext &&
+        codecContext->sample_rate > 0) {
+        int64_t limit = static_cast<int64_t>(config.maxQueueDurationMs) *
+                        codecContext->sample_rate / 1000;
+        if (queuedSamples >= limit) {
+            return true;
+        }
+    }
+    return false;
+}
+
 bool AudioDecoder::pushFrame(AVFrame *frame) {
     std::unique_lock<std::mutex> lock(frameQueueMutex);
-    if (frameQueue.size() >= config.maxQueueSize) {
+    if (isQueueFull()) {
         if (config.dropFramesWhenFull) {
             _logger->warn("Frame queue full, dropping frame");
-            av_frame_free(&frame);
+            framePool.release(frame);
             return false;
         }
         queueNotFull.wait(lock, [this]() {
-            return frameQueue.size() < config.maxQueueSize || !isDecoding;
+            return !isQueueFull() ||
+                   !isDecoding.load(std::memory_order_acquire);
         });
     }
 
-    if (!isDecoding) {
-        av_frame_free(&frame);
+    if (!isDecoding.load(std::memory_order_acquire)) {
+        framePool.release(frame);
         return false;
     }
 
-    frameQueue.push(frame);
-    frameAvailable.notify_one();
+    enqueueFrame(frame);
     return true;
 }
 
@@ -164,91 +533,187 @@ bool AudioDecoder::getAudioFrame(AVFrame **frame, int timeout_ms) {
     bool success;
     if (timeout_ms < 0) {
         // 无限等待
-        frameAvailable.wait(
-            lock, [this]() { return !frameQueue.empty() || !isDecoding; });
+        frameAvailable.wait(lock, [this]() {
+            return !frameQueue.empty() ||
+                   !isDecoding.load(std::memory_order_acquire) ||
+                   endOfStream;
+        });
         success = !frameQueue.empty();
     } else {
-        // 带超时的等待
+        // 带超时的等待，解码结束后不再等待
         success = frameAvailable.wait_for(
-            lock, std::chrono::milliseconds(timeout_ms),
-            [this]() { return !frameQueue.empty() || !isDecoding; });
+            lock, std::chrono::milliseconds(timeout_ms), [this]() {
+                return !frameQueue.empty() ||
+                       !isDecoding.load(std::memory_order_acquire) ||
+                       endOfStream;
+            });
     }
 
     if (!success || frameQueue.empty()) {
         return false;
     }
 
-    *frame = frameQueue.front();
-    frameQueue.pop();
+    *frame = dequeueFrame();
     queueNotFull.notify_one();
     return true;
 }
 
-void AudioDecoder::decodeLoop() {
-    AVPacket *packet = av_packet_alloc();
-    AVFrame *frame = av_frame_alloc();
+bool AudioDecoder::waitForFrame(int timeout_ms) {
+    std::unique_lock<std::mutex> lock(frameQueueMutex);
+    frameAvailable.wait_for(
+        lock, std::chrono::milliseconds(timeout_ms), [this]() {
+            return !frameQueue.empty() ||
+                   !isDecoding.load(std::memory_order_acquire) ||
+                   endOfStream;
+        });
+    return !frameQueue.empty();
+}
 
-    while (isDecoding) {
-        int ret = av_read_frame(formatContext.get(), packet);
+int AudioDecoder::decodeNextFrame(AVFrame *frame) {
+    // 预读线程重连时会替换formatContext，这里只检查codecContext
+    if (!codecContext) {
+        return AVERROR(EINVAL);
+    }
+
+    while (true) {
+        int ret = avcodec_receive_frame(codecContext.get(), frame);
+        if (ret == 0) {
+            // 确保时间戳有效
+            if (frame->pts == AV_NOPTS_VALUE) {
+                frame->pts = frame->best_effort_timestamp;
+            }
+            if (sampleClock >= 0) {
+                frame->pts = samplesToPts(sampleClock);
+                sampleClock += frame->nb_samples;
+            }
+            // 定位后整帧都在目标之前时丢弃，继续解码下一帧
+            if (seekTargetSamples >= 0 && !trimToSeekTarget(frame)) {
+                av_frame_unref(frame);
+                continue;
+            }
+            return 0;
+        }
+        if (ret == AVERROR_EOF) {
+            return AVERROR_EOF;
+        }
+        if (ret != AVERROR(EAGAIN)) {
+            _logger->error("Error during decoding: {}", getErrorString(ret));
+        }
+
+        // 解码器需要更多数据，读取下一个数据包
+        ret = prefetcher.isRunning()
+                  ? prefetcher.pop(packet.get())
+                  : av_read_frame(formatContext.get(), packet.get());
         if (ret < 0) {
-            if (ret == AVERROR_EOF) {
+            if (ret == AVERROR_EOF && !draining) {
                 // 处理文件结束
-                // 刷新解码器缓冲
+                // 刷新解码器缓冲，之后继续取出缓存的帧
                 avcodec_send_packet(codecContext.get(), nullptr);
+                draining = true;
                 _logger->info("End of file reached");
-            } else {
+                continue;
+            }
+            if (ret != AVERROR_EOF && ret != AVERROR_EXIT) {
                 _logger->error("Error reading frame: {}", getErrorString(ret));
             }
-            break;
+            return ret;
         }
 
         if (packet->stream_index == audioStreamIndex) {
-            // 添加时间戳处理
-            if (packet->pts != AV_NOPTS_VALUE) {
-                packet->pts = av_rescale_q(
-                    packet->pts,
-                    formatContext->streams[audioStreamIndex]->time_base,
-                    codecContext->time_base);
+            // 数据包时间戳保持流时间基准，解码器通过pkt_timebase换算
+            ret = avcodec_send_packet(codecContext.get(), packet.get());
+            if (ret < 0) {
+                _logger->error("Error sending packet: {}",
+                               getErrorString(ret));
             }
+        }
+        av_packet_unref(packet.get());
+    }
+}
 
-            if (packet->dts != AV_NOPTS_VALUE) {
-                packet->dts = av_rescale_q(
-                    packet->dts,
-                    formatContext->streams[audioStreamIndex]->time_base,
-                    codecContext->time_base);
-            }
+void AudioDecoder::decodeLoop() {
+    ScopedThreadScheduling scheduling(config.decodeScheduling, "decoder");
+    AVFrame *frame = av_frame_alloc();
 
-            if (avcodec_send_packet(codecContext.get(), packet) == 0) {
-                while (true) {
-                    ret = avcodec_receive_frame(codecContext.get(), frame);
-                    if (ret == AVERROR(EAGAIN) || ret == AVERROR_EOF) {
-                        break;
-                    } else if (ret < 0) {
-                        _logger->error("Error during decoding");
-                        break;
-                    }
-
-                    // 确保时间戳有效
-                    if (frame->pts == AV_NOPTS_VALUE) {
-                        frame->pts = frame->best_effort_timestamp;
-                    }
-
-                    // 克隆帧并加入队列
-                    AVFrame *clone = av_frame_clone(frame);
-                    if (clone) {
-                        std::lock_guard<std::mutex> lock(frameQueueMutex);
-                        frameQueue.push(clone);
-                        frameAvailable.notify_one();
-                    }
-                }
-            }
+    bool reachedEnd = false;
+    while (isDecoding.load(std::memory_order_acquire)) {
+        auto start = std::chrono::steady_clock::now();
+        int ret = decodeNextFrame(frame);
+        if (ret < 0) {
+            // AVERROR_EXIT表示预读被stop()打断，不算结束
+            reachedEnd = ret != AVERROR_EXIT;
+            break;
+        }
+        if (decodeHistogram) {
+            auto elapsed = std::chrono::steady_clock::now() - start;
+            decodeHistogram->record(
+                std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed)
+                    .count());
+        }
+
+        // 把帧数据的引用转移到池中的帧再加入有界队列，不复制数据
+        // 队列满时在这里阻塞，解码进度不会超前播放太多
+        AVFrame *pooled = framePool.acquire();
+        if (pooled) {
+            av_frame_move_ref(pooled, frame);
+            pushFrame(pooled);
+        } else {
+            av_frame_unref(frame);
         }
-        av_packet_unref(packet);
+    }
+
+    // 通知消费者不会再有新帧；被stop()打断时不算结束
+    if (reachedEnd) {
+        {
+            std::lock_guard<std::mutex> lock(frameQueueMutex);
+            endOfStream = true;
+        }
+        frameAvailable.notify_all();
     }
 
     // 清理资源
     av_frame_free(&frame);
-    av_packet_free(&packet);
+}
+
+// 调用方需持有frameQueueMutex
+void AudioDecoder::enqueueFrame(AVFrame *frame) {
+    if (frameQueue.full()) {
+        frameQueue.reserve(std::max<size_t>(frameQueue.capacity() * 2, 16));
+        queueAllocations++;
+    }
+    frameQueue.push(frame);
+    queuedBytes += getFrameBytes(frame);
+    queuedSamples += frame->nb_samples;
+    if (frameQueue.size() > queueHighWater.load(std::memory_order_relaxed)) {
+        queueHighWater.store(frameQueue.size(), std::memory_order_relaxed);
+    }
+    frameAvailable.notify_one();
+}
+
+// 调用方需持有frameQueueMutex，且队列不为空
+AVFrame *AudioDecoder::dequeueFrame() {
+    AVFrame *frame = frameQueue.front();
+    frameQueue.pop();
+    queuedBytes -= std::min(queuedBytes, getFrameBytes(frame));
+    queuedSamples -= std::min<int64_t>(queuedSamples, frame->nb_samples);
+    return frame;
+}
+
+// 调用方需持有frameQueueMutex
+void AudioDecoder::clearQueue() {
+    while (!frameQueue.empty()) {
+        framePool.release(frameQueue.front());
+        frameQueue.pop();
+    }
+    queuedBytes = 0;
+    queuedSamples = 0;
+    queueNotFull.notify_all();
+}
+
+void AudioDecoder::releaseFrame(AVFrame *frame) { framePool.release(frame); }
+
+uint64_t AudioDecoder::getAllocationCount() const {
+    return framePool.getAllocationCount() + queueAllocations.load();
 }
 
 size_t AudioDecoder::getQueueSize() {
@@ -256,17 +721,44 @@ size_t AudioDecoder::getQueueSize() {
     return frameQueue.size();
 }
 
+bool AudioDecoder::isFinished() {
+    std::lock_guard<std::mutex> lock(frameQueueMutex);
+    return endOfStream && frameQueue.empty();
+}
+
+size_t AudioDecoder::getQueuedBytes() {
+    std::lock_guard<std::mutex> lock(frameQueueMutex);
+    return queuedBytes;
+}
+
+double AudioDecoder::getQueuedDurationMs() {
+    std::lock_guard<std::mutex> lock(frameQueueMutex);
+    int sampleRate = codecContext ? codecContext->sample_rate : 0;
+    return sampleRate > 0 ? queuedSamples * 1000.0 / sampleRate : 0.0;
+}
+
+size_t AudioDecoder::getQueueHighWater() const {
+    return queueHighWater.load(std::memory_order_relaxed);
+}
+
+void AudioDecoder::setDecodeHistogram(LatencyHistogram *histogram) {
+    decodeHistogram = histogram;
+}
+
 void AudioDecoder::flush() {
     std::lock_guard<std::mutex> lock(frameQueueMutex);
-    while (!frameQueue.empty()) {
-        av_frame_free(&frameQueue.front());
-        frameQueue.pop();
-    }
+    clearQueue();
 }
 
 void AudioDecoder::setConfig(const AudioDecoderConfig &newConfig) {
     std::lock_guard<std::mutex> lock(frameQueueMutex);
     config = newConfig;
+    if (frameQueue.capacity() < config.maxQueueSize) {
+        frameQueue.reserve(config.maxQueueSize);
+        queueAllocations++;
+    }
+    // 上限可能被放宽，唤醒等待中的解码线程
+    queueNotFull.notify_all();
 }
 
 int AudioDecoder::getSampleRate() const {
@@ -289,50 +781,317 @@ uint64_t AudioDecoder::getChannelLayout() const {
     return codecContext->ch_layout.u.mask;
 }
 
+const AVChannelLayout *AudioDecoder::getChannelLayoutInfo() const {
+    return codecContext ? &codecContext->ch_layout : nullptr;
+}
+
 AVSampleFormat AudioDecoder::getSampleFormat() const {
     return codecContext ? codecContext->sample_fmt : AV_SAMPLE_FMT_NONE;
 }
 
 // 添加获取音频时长的方法
-double AudioDecoder::getDuration() const {
-    if (!formatContext || audioStreamIndex < 0) {
-        return 0.0;
-    }
+double AudioDecoder::getDuration() const { return streamDuration; }
 
-    AVStream *stream = formatContext->streams[audioStreamIndex];
-    if (stream->duration != AV_NOPTS_VALUE) {
-        return stream->duration * av_q2d(stream->time_base);
-    }
+double AudioDecoder::getTrackGainDb() const { return trackGainDb; }
 
-    return formatContext->duration / (double)AV_TIME_BASE;
+MediaInfo AudioDecoder::getMediaInfo() const {
+    MediaInfo info;
+    if (!codecContext) {
+        return info;
+    }
+    info.sampleRate = getSampleRate();
+    info.channels = getChannels();
+    info.channelLayout =
+        codecContext->ch_layout.order == AV_CHANNEL_ORDER_NATIVE
+            ? codecContext->ch_layout.u.mask
+            : 0;
+    info.sampleFormat = getSampleFormat();
+    info.codecId = codecContext->codec_id;
+    info.streamIndex = audioStreamIndex;
+    info.timeBase = streamTimeBase;
+    info.duration = streamDuration;
+    info.bitRate = formatContext ? formatContext->bit_rate : 0;
+    info.trackGainDb = trackGainDb;
+    return info;
 }
 
 bool AudioDecoder::seek(double seconds) {
     if (!formatContext || audioStreamIndex < 0) return false;
 
+    // 解码线程正在读取数据包，先停下再移动读取位置，并丢弃旧位置的帧
+    bool wasDecoding = isDecoding.load(std::memory_order_acquire);
+    stop();
+    flush();
+    prefetcher.flush();
+    resumePts = AV_NOPTS_VALUE;
+
     AVStream *stream = formatContext->streams[audioStreamIndex];
     int64_t timestamp = seconds / av_q2d(stream->time_base);
 
-    // 执行seek操作
-    int ret = av_seek_frame(formatContext.get(), audioStreamIndex, timestamp,
-                            AVSEEK_FLAG_BACKWARD);
-    if (ret < 0) {
-        _logger->error("Seek失败: {}", getErrorString(ret));
-        return false;
+    // 有索引时按字节偏移直接跳到目标之前最近的数据包，不需要扫描
+    bool indexed = false;
+    std::shared_ptr<const SeekIndex> index = loadOrBuildSeekIndex();
+    bool byteSeekable =
+        !(formatContext->iformat->flags & AVFMT_NO_BYTE_SEEK);
+    if (index && byteSeekable) {
+        int64_t preroll = SEEK_PREROLL / av_q2d(stream->time_base);
+        const SeekIndex::Entry *entry = index->find(timestamp - preroll);
+        if (!entry) {
+            entry = index->find(timestamp);
+        }
+        if (entry && av_seek_frame(formatContext.get(), audioStreamIndex,
+                                   entry->pos, AVSEEK_FLAG_BYTE) >= 0) {
+            sampleClock = ptsToSamples(entry->pts);
+            indexed = true;
+        }
+    }
+
+    if (!indexed) {
+        // 执行seek操作
+        int ret = av_seek_frame(formatContext.get(), audioStreamIndex,
+                                timestamp, AVSEEK_FLAG_BACKWARD);
+        if (ret < 0) {
+            _logger->error("Seek失败: {}", getErrorString(ret));
+            if (wasDecoding) {
+                start();
+            }
+            return false;
+        }
+        sampleClock = -1;
     }
 
     // 刷新解码器缓冲
     avcodec_flush_buffers(codecContext.get());
-    currentPts = seconds;
+    draining = false;
+    seekTargetSamples =
+        config.accurateSeek ? std::max<int64_t>(0, ptsToSamples(timestamp))
+                            : -1;
+    currentPts.store(seconds, std::memory_order_relaxed);
 
+    if (wasDecoding) {
+        start();
+    }
     return true;
 }
 
-double AudioDecoder::getCurrentTimestamp() const { return currentPts; }
+bool AudioDecoder::hasSeekIndex() {
+    std::lock_guard<std::mutex> lock(seekIndexMutex);
+    return seekIndex != nullptr;
+}
+
+// 获取定位索引：已建立则直接返回；ON_FIRST_SEEK模式下在这里同步建立
+std::shared_ptr<const SeekIndex> AudioDecoder::loadOrBuildSeekIndex() {
+    {
+        std::lock_guard<std::mutex> lock(seekIndexMutex);
+        // 后台线程还在建立索引时不等待，本次按时间戳定位
+        if (seekIndex || config.seekIndexMode != SeekIndexMode::ON_FIRST_SEEK) {
+            return seekIndex;
+        }
+    }
+
+    auto index = readSeekIndex();
+    std::lock_guard<std::mutex> lock(seekIndexMutex);
+    seekIndex = index;
+    return index;
+}
+
+// 优先从缓存文件加载索引，没有可用缓存时扫描文件建立并写回缓存
+std::shared_ptr<const SeekIndex> AudioDecoder::readSeekIndex() {
+    // 内存输入没有可供重新扫描的文件，网络输入扫描一遍代价太高
+    if (currentFile.empty() || isNetworkInput()) {
+        return nullptr;
+    }
+    FileIdentity identity;
+    bool hasIdentity = FileIdentity::get(currentFile, identity);
+    std::string cachePath = SeekIndex::cachePathFor(currentFile);
+    MediaInfoCache *mediaCache =
+        hasIdentity ? config.mediaInfoCache.get() : nullptr;
+
+    std::shared_ptr<const SeekIndex> index;
+    if (mediaCache) {
+        index =
+            mediaCache->findSeekIndex(currentFile, identity, audioStreamIndex);
+        if (index) {
+            _logger->debug("Seek index loaded from media info cache: {} "
+                           "entries",
+                           index->size());
+        }
+    }
+    if (!index && config.cacheSeekIndex && hasIdentity) {
+        index = SeekIndex::load(cachePath, identity, audioStreamIndex);
+        if (index) {
+            _logger->debug("Seek index loaded from cache: {} entries",
+                           index->size());
+        }
+    }
+
+    if (!index) {
+        auto start = std::chrono::steady_clock::now();
+        auto built = SeekIndex::build(currentFile, audioStreamIndex,
+                                      SEEK_INDEX_INTERVAL, cancelIndexBuild);
+        if (!built) {
+            return nullptr;
+        }
+        auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - start);
+        _logger->info("Seek index built: {} entries in {} ms", built->size(),
+                      elapsed.count());
+        if (mediaCache) {
+            mediaCache->insertSeekIndex(currentFile, identity, built);
+        } else if (config.cacheSeekIndex && hasIdentity &&
+                   !built->save(cachePath, identity)) {
+            _logger->debug("Could not write seek index cache: {}", cachePath);
+        }
+        index = built;
+    }
+    return index;
+}
+
+void AudioDecoder::cancelSeekIndexBuild() {
+    if (seekIndexThread.joinable()) {
+        cancelIndexBuild = true;
+        seekIndexThread.join();
+    }
+    cancelIndexBuild = false;
+}
+
+// 定位后裁掉帧中目标时间之前的样本；整帧都在目标之前时返回false
+bool AudioDecoder::trimToSeekTarget(AVFrame *frame) {
+    if (frame->pts == AV_NOPTS_VALUE) {
+        // 没有时间戳无法精确定位，放弃裁剪
+        seekTargetSamples = -1;
+        return true;
+    }
+
+    int64_t start = ptsToSamples(frame->pts);
+    int64_t end = start + frame->nb_samples;
+    if (end <= seekTargetSamples) {
+        return false;
+    }
+
+    if (start < seekTargetSamples) {
+        int skip = static_cast<int>(seekTargetSamples - start);
+        AVSampleFormat format = static_cast<AVSampleFormat>(frame->format);
+        int bytesPerSample = av_get_bytes_per_sample(format);
+        int channels = frame->ch_layout.nb_channels;
+
+        // 只移动数据指针，数据本身仍由frame->buf引用计数管理
+        int planes = av_sample_fmt_is_planar(format) ? channels : 1;
+        int offset = av_sample_fmt_is_planar(format)
+                         ? skip * bytesPerSample
+                         : skip * bytesPerSample * channels;
+        for (int i = 0; i < planes; i++) {
+            frame->extended_data[i] += offset;
+            if (i < AV_NUM_DATA_POINTERS) {
+                frame->data[i] = frame->extended_data[i];
+            }
+        }
+        frame->nb_samples -= skip;
+        frame->pts = samplesToPts(seekTargetSamples);
+    }
+
+    seekTargetSamples = -1;
+    return true;
+}
+
+int64_t AudioDecoder::ptsToSamples(int64_t pts) const {
+    AVRational sampleBase{1, codecContext->sample_rate};
+    return av_rescale_q(pts, streamTimeBase, sampleBase);
+}
+
+int64_t AudioDecoder::samplesToPts(int64_t samples) const {
+    return av_rescale_q(samples, AVRational{1, codecContext->sample_rate},
+                        streamTimeBase);
+}
+
+double AudioDecoder::getCurrentTimestamp() const {
+    return currentPts.load(std::memory_order_relaxed);
+}
+
+AVRational AudioDecoder::getTimeBase() const { return streamTimeBase; }
+
+bool AudioDecoder::isNetworkInput() const {
+    return !input && currentFile.find("://") != std::string::npos &&
+           currentFile.rfind("file:", 0) != 0;
+}
+
+bool AudioDecoder::shouldPrefetch() const {
+    switch (config.prefetch.mode) {
+        case PrefetchMode::ENABLED:
+            return true;
+        case PrefetchMode::DISABLED:
+            return false;
+        case PrefetchMode::AUTO:
+            break;
+    }
+    return isNetworkInput();
+}
+
+PrefetchStats AudioDecoder::getPrefetchStats() { return prefetcher.getStats(); }
+
+// 在预读线程上读取下一个音频数据包
+int AudioDecoder::readAudioPacket(AVPacket *pkt) {
+    while (true) {
+        int ret = av_read_frame(formatContext.get(), pkt);
+        if (ret == AVERROR_EOF && isNetworkInput()) {
+            // 直播流没有结尾；点播流在时长之前结束说明连接中途被关闭
+            double position = lastPacketPts == AV_NOPTS_VALUE
+                                  ? 0.0
+                                  : lastPacketPts * av_q2d(streamTimeBase);
+            if (streamDuration <= 0.0 || position < streamDuration - 1.0) {
+                return AVERROR(EIO);
+            }
+        }
+        if (ret < 0) {
+            return ret;
+        }
+        if (pkt->stream_index == audioStreamIndex) {
+            // 重连后从断开处之前的关键帧开始读，跳过已经交给解码器的部分
+            bool duplicate = resumePts != AV_NOPTS_VALUE &&
+                             pkt->pts != AV_NOPTS_VALUE &&
+                             pkt->pts <= resumePts;
+            if (!duplicate) {
+                resumePts = AV_NOPTS_VALUE;
+                if (pkt->pts != AV_NOPTS_VALUE) {
+                    lastPacketPts = pkt->pts;
+                }
+                return 0;
+            }
+        }
+        av_packet_unref(pkt);
+    }
+}
+
+// 在预读线程上重新打开输入，解码器上下文保持不变
+int AudioDecoder::reconnectInput() {
+    AVFormatContext *rawCtx = nullptr;
+    int ret = openFormat(currentFile, &rawCtx);
+    if (ret < 0) {
+        return ret;
+    }
+    FormatContextPtr reopened(rawCtx);
+    ret = avformat_find_stream_info(rawCtx, nullptr);
+    if (ret < 0) {
+        return ret;
+    }
+
+    // 重连后流的结构必须不变，否则解码器上下文和时间戳都不再适用
+    if (audioStreamIndex >= static_cast<int>(rawCtx->nb_streams)) {
+        return AVERROR_STREAM_NOT_FOUND;
+    }
+    AVStream *stream = rawCtx->streams[audioStreamIndex];
+    if (stream->codecpar->codec_id != codecContext->codec_id ||
+        av_cmp_q(stream->time_base, streamTimeBase) != 0) {
+        return AVERROR_STREAM_NOT_FOUND;
+    }
 
-AVRational AudioDecoder::getTimeBase() const {
-    if (!formatContext || audioStreamIndex < 0) {
-        return AVRational{0, 1};
+    // 点播流从断开处继续，直播流从当前的直播位置继续
+    if (streamDuration > 0.0 && lastPacketPts != AV_NOPTS_VALUE &&
+        av_seek_frame(rawCtx, audioStreamIndex, lastPacketPts,
+                      AVSEEK_FLAG_BACKWARD) >= 0) {
+        resumePts = lastPacketPts;
     }
-    return formatContext->streams[audioStreamIndex]->time_base;
+    discardOtherStreams(rawCtx, audioStreamIndex);
+    formatContext = std::move(reopened);
+    return 0;
 }
@@ -0,0 +1,529 @@
+#include "audio_mixer.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+#include "logger.h"
+
+namespace {
+constexpr float QUARTER_PI = 0.78539816f;
+constexpr size_t MAX_VOICES = 0xFFFF;  // 句柄低16位为槽位序号加1
+
+// 等功率声像：中间位置左右各为-3dB，移动声像时总功率不变
+void panGains(float gain, float pan, float &left, float &right) {
+    float angle = (std::clamp(pan, -1.0f, 1.0f) + 1.0f) * QUARTER_PI;
+    left = gain * std::cos(angle);
+    right = gain * std::sin(angle);
+}
+}  // namespace
+
+AudioMixer::AudioMixer(const AudioMixerConfig &config)
+    : config(config), kernels(AudioKernels::get()) {
+    _logger = Logger::getInstance().getLogger("AudioMixer");
+
+    size_t voiceCount = std::clamp<size_t>(config.maxVoices, 1, MAX_VOICES);
+    size_t streamCount = std::min(config.maxStreams, voiceCount);
+    this->config.maxVoices = voiceCount;
+    this->config.maxStreams = streamCount;
+
+    // 声部和解码槽位一次性分配，之后开始和结束声部只在空闲列表间移动序号
+    voices = std::make_unique<Voice[]>(voiceCount);
+    freeVoices.reserve(voiceCount);
+    for (size_t i = voiceCount; i > 0; i--) {
+        freeVoices.push_back(i - 1);
+    }
+
+    size_t frameBytes = CHANNELS * sizeof(float);
+    size_t ringBytes = std::max<size_t>(
+        static_cast<size_t>(config.sampleRate) * config.streamBufferMs / 1000,
+        std::max(config.deviceBufferSamples, STREAM_CHUNK_SAMPLES) * 2);
+    ringBytes *= frameBytes;
+
+    AudioDecoderConfig decoderConfig;
+    decoderConfig.prefetch.mode = PrefetchMode::DISABLED;
+    decoderConfig.cacheSeekIndex = false;
+    streams = std::make_unique<StreamSlot[]>(streamCount);
+    freeStreams.reserve(streamCount);
+    for (size_t i = streamCount; i > 0; i--) {
+        StreamSlot &slot = streams[i - 1];
+        slot.decoder.setConfig(decoderConfig);
+        slot.ring.reset(ringBytes);
+        slot.scratch.resize(STREAM_CHUNK_SAMPLES * frameBytes);
+        slot.frame.reset(av_frame_alloc());
+        freeStreams.push_back(i - 1);
+    }
+
+    _logger->debug("Mixer created: {} voices, {} streams, kernels {}",
+                   voiceCount, streamCount, kernels.name);
+}
+
+AudioMixer::~AudioMixer() {
+    close();
+    if (sdlInitialized) {
+        SDL_QuitSubSystem(SDL_INIT_AUDIO);
+    }
+}
+
+bool AudioMixer::open() {
+    if (audioDevice) {
+        return true;
+    }
+    if (!sdlInitialized) {
+        if (SDL_InitSubSystem(SDL_INIT_AUDIO) < 0) {
+            _logger->error("SDL初始化失败: {}", SDL_GetError());
+            return false;
+        }
+        sdlInitialized = true;
+    }
+
+    // 不允许设备改变参数，格式不同时由SDL转换，回调始终收到双声道F32
+    SDL_AudioSpec wanted_spec, obtained_spec;
+    SDL_zero(wanted_spec);
+    wanted_spec.freq = config.sampleRate;
+    wanted_spec.format = AUDIO_F32SYS;
+    wanted_spec.channels = CHANNELS;
+    wanted_spec.samples = static_cast<Uint16>(config.deviceBufferSamples);
+    wanted_spec.callback = audioCallback;
+    wanted_spec.userdata = this;
+
+    audioDevice =
+        SDL_OpenAudioDevice(nullptr, 0, &wanted_spec, &obtained_spec, 0);
+    if (audioDevice == 0) {
+        _logger->error("无法打开音频设备: {}", SDL_GetError());
+        return false;
+    }
+
+    // 每个设备周期至少填充两次
+    feederIntervalMs =
+        std::max(1, config.deviceBufferSamples * 1000 / config.sampleRate / 2);
+    {
+        std::lock_guard<std::mutex> lock(feederMutex);
+        isFeederRunning = true;
+    }
+    feederThread = std::thread(&AudioMixer::feederLoop, this);
+
+    SDL_PauseAudioDevice(audioDevice, 0);
+    _logger->info("Mixer opened: {} Hz, {} samples per callback",
+                  obtained_spec.freq, obtained_spec.samples);
+    return true;
+}
+
+void AudioMixer::close() {
+    if (audioDevice) {
+        // 关闭设备会等待正在执行的回调返回
+        SDL_CloseAudioDevice(audioDevice);
+        audioDevice = 0;
+    }
+    {
+        std::lock_guard<std::mutex> lock(feederMutex);
+        isFeederRunning = false;
+    }
+    feederWakeup.notify_all();
+    if (feederThread.joinable()) {
+        feederThread.join();
+    }
+
+    // 回调已停止，直接结束所有声部并回收
+    for (size_t i = 0; i < config.maxVoices; i++) {
+        int state = voices[i].state.load();
+        if (state == PLAYING || state == STOPPING) {
+            voices[i].state.store(FINISHED);
+        }
+    }
+    reclaimVoices();
+}
+
+AudioOutputFormat AudioMixer::getOutputFormat() const {
+    AudioOutputFormat format;
+    format.sampleRate = config.sampleRate;
+    format.channels = CHANNELS;
+    format.sampleFormat = AV_SAMPLE_FMT_FLT;
+    return format;
+}
+
+VoiceId AudioMixer::play(std::shared_ptr<const PcmClip> clip,
+                         const VoiceParams &params) {
+    if (!clip) {
+        return INVALID_VOICE;
+    }
+    AudioOutputFormat format = getOutputFormat();
+    if (clip->format.sampleRate != format.sampleRate ||
+        clip->format.channels != format.channels ||
+        clip->format.sampleFormat != format.sampleFormat) {
+        _logger->warn("Clip format {} Hz/{} ch does not match mixer output",
+                      clip->format.sampleRate, clip->format.channels);
+        return INVALID_VOICE;
+    }
+    return startVoice(std::move(clip), nullptr, params);
+}
+
+VoiceId AudioMixer::play(const std::string &filename,
+                         const VoiceParams &params) {
+    AudioOutputFormat format = getOutputFormat();
+    if (config.pcmCache) {
+        std::shared_ptr<const PcmClip> clip = config.pcmCache->find(filename);
+        if (clip && clip->format.sampleRate == format.sampleRate &&
+            clip->format.channels == format.channels &&
+            clip->format.sampleFormat == format.sampleFormat) {
+            return startVoice(std::move(clip), nullptr, params);
+        }
+    }
+
+    size_t index;
+    {
+        std::lock_guard<std::mutex> lock(voiceMutex);
+        if (freeStreams.empty()) {
+            rejectedVoices++;
+            _logger->warn("No free stream slot for {}", filename);
+            return INVALID_VOICE;
+        }
+        index = freeStreams.back();
+        freeStreams.pop_back();
+    }
+    StreamSlot &slot = streams[index];
+    auto releaseSlot = [&]() {
+        slot.decoder.close();
+        slot.resampler.reset();
+        std::lock_guard<std::mutex> lock(voiceMutex);
+        freeStreams.push_back(index);
+    };
+
+    AudioDecoderError error = slot.decoder.open(filename);
+    if (error != AudioDecoderError::SUCCESS) {
+        _logger->error("Failed to open {}: {}", filename,
+                       audioDecoderErrorString(error));
+        releaseSlot();
+        return INVALID_VOICE;
+    }
+
+    // 短文件解码一次放入缓存，之后按片段播放，不再占用解码槽位
+    if (config.pcmCache && config.pcmCache->isCacheable(slot.decoder)) {
+        std::shared_ptr<const PcmClip> clip =
+            config.pcmCache->insert(filename, slot.decoder, format);
+        releaseSlot();
+        return clip ? startVoice(std::move(clip), nullptr, params)
+                    : INVALID_VOICE;
+    }
+
+    if (!slot.resampler.init(slot.decoder, format)) {
+        releaseSlot();
+        return INVALID_VOICE;
+    }
+
+    // 发布给回调之前先填满缓冲，声部开始时不会欠载
+    slot.hasFrame = false;
+    slot.draining = false;
+    slot.finished.store(false);
+    slot.ring.clear();
+    fillStream(slot);
+
+    VoiceId id = startVoice(nullptr, &slot, params);
+    if (id == INVALID_VOICE) {
+        releaseSlot();
+        return INVALID_VOICE;
+    }
+    slot.active.store(true, std::memory_order_release);
+    return id;
+}
+
+VoiceId AudioMixer::startVoice(std::shared_ptr<const PcmClip> clip,
+                               StreamSlot *stream, const VoiceParams &params) {
+    std::lock_guard<std::mutex> lock(voiceMutex);
+    if (freeVoices.empty()) {
+        rejectedVoices++;
+        return INVALID_VOICE;
+    }
+    size_t index = freeVoices.back();
+    freeVoices.pop_back();
+
+    Voice &voice = voices[index];
+    voice.clipData =
+        clip ? reinterpret_cast<const float *>(clip->data.data()) : nullptr;
+    voice.clipFrames = clip ? clip->frames() : 0;
+    voice.clipRef = std::move(clip);
+    voice.stream = stream;
+    voice.position = 0;
+    voice.gain.store(params.gain, std::memory_order_relaxed);
+    voice.pan.store(params.pan, std::memory_order_relaxed);
+    // 从目标增益直接开始，第一次回调不做渐变
+    panGains(params.gain, params.pan, voice.leftGain, voice.rightGain);
+    voice.state.store(PLAYING, std::memory_order_release);
+
+    size_t active = ++activeVoices;
+    size_t peak = peakVoices.load(std::memory_order_relaxed);
+    while (active > peak && !peakVoices.compare_exchange_weak(peak, active)) {
+    }
+    return (static_cast<VoiceId>(voice.generation) << 16) |
+           static_cast<VoiceId>(index + 1);
+}
+
+AudioMixer::Voice *AudioMixer::findVoice(VoiceId voice) {
+    size_t index = (voice & 0xFFFF);
+    if (index == 0 || index > config.maxVoices) {
+        return nullptr;
+    }
+    Voice &slot = voices[index - 1];
+    if (slot.generation != (voice >> 16) ||
+        slot.state.load(std::memory_order_acquire) == FREE) {
+        return nullptr;
+    }
+    return &slot;
+}
+
+void AudioMixer::stop(VoiceId voice) {
+    std::lock_guard<std::mutex> lock(voiceMutex);
+    Voice *slot = findVoice(voice);
+    if (slot) {
+        int expected = PLAYING;
+        slot->state.compare_exchange_strong(expected, STOPPING);
+    }
+}
+
+void AudioMixer::stopAll() {
+    std::lock_guard<std::mutex> lock(voiceMutex);
+    for (size_t i = 0; i < config.maxVoices; i++) {
+        int expected = PLAYING;
+        voices[i].state.compare_exchange_strong(expected, STOPPING);
+    }
+}
+
+bool AudioMixer::setGain(VoiceId voice, float gain) {
+    std::lock_guard<std::mutex> lock(voiceMutex);
+    Voice *slot = findVoice(voice);
+    if (!slot) {
+        return false;
+    }
+    slot->gain.store(std::max(0.0f, gain), std::memory_order_relaxed);
+    return true;
+}
+
+bool AudioMixer::setPan(VoiceId voice, float pan) {
+    std::lock_guard<std::mutex> lock(voiceMutex);
+    Voice *slot = findVoice(voice);
+    if (!slot) {
+        return false;
+    }
+    slot->pan.store(std::clamp(pan, -1.0f, 1.0f), std::memory_order_relaxed);
+    return true;
+}
+
+bool AudioMixer::isPlaying(VoiceId voice) {
+    std::lock_guard<std::mutex> lock(voiceMutex);
+    Voice *slot = findVoice(voice);
+    return slot && slot->state.load(std::memory_order_acquire) == PLAYING;
+}
+
+void AudioMixer::setMasterGain(float gain) {
+    masterGain.store(std::max(0.0f, gain), std::memory_order_relaxed);
+}
+
+void AudioMixer::audioCallback(void *userdata, Uint8 *stream, int len) {
+    auto *mixer = static_cast<AudioMixer *>(userdata);
+    mixer->mix(reinterpret_cast<float *>(stream),
+               static_cast<size_t>(len) / (CHANNELS * sizeof(float)));
+}
+
+void AudioMixer::mix(float *out, size_t frames) {
+    auto start = std::chrono::steady_clock::now();
+    std::fill(out, out + frames * CHANNELS, 0.0f);
+
+    for (size_t i = 0; i < config.maxVoices; i++) {
+        Voice &voice = voices[i];
+        int state = voice.state.load(std::memory_order_acquire);
+        if (state != PLAYING && state != STOPPING) {
+            continue;
+        }
+
+        // 增益和声像的变化在本次回调内渐变，停止的声部渐变到0后结束
+        float left = 0.0f;
+        float right = 0.0f;
+        if (state == PLAYING) {
+            panGains(voice.gain.load(std::memory_order_relaxed),
+                     voice.pan.load(std::memory_order_relaxed), left, right);
+        }
+        bool alive = voice.stream ? mixStream(voice, out, frames, left, right)
+                                  : mixClip(voice, out, frames, left, right);
+        voice.leftGain = left;
+        voice.rightGain = right;
+        if (!alive || state == STOPPING) {
+            // 由填充线程回收，与stop()同时发生时以结束为准
+            voice.state.store(FINISHED, std::memory_order_release);
+        }
+    }
+
+    // 主增益并限幅到[-1, 1]
+    kernels.gainF32(out, out, frames * CHANNELS,
+                    masterGain.load(std::memory_order_relaxed));
+
+    callbackCount.fetch_add(1, std::memory_order_relaxed);
+    callbackHistogram.record(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - start)
+            .count());
+}
+
+// 返回false表示片段已播放完毕
+bool AudioMixer::mixClip(Voice &voice, float *out, size_t frames, float left,
+                         float right) {
+    size_t count = std::min(frames, voice.clipFrames - voice.position);
+    kernels.mixStereoF32(voice.clipData + voice.position * CHANNELS, out,
+                         count, voice.leftGain, voice.rightGain, left, right);
+    voice.position += count;
+    return voice.position < voice.clipFrames;
+}
+
+// 环绕的两段分别累加，渐变按帧数在两段间连续分配
+bool AudioMixer::mixStream(Voice &voice, float *out, size_t frames,
+                           float left, float right) {
+    StreamSlot &slot = *voice.stream;
+    const size_t frameBytes = CHANNELS * sizeof(float);
+    bool finished = slot.finished.load(std::memory_order_acquire);
+
+    SpscRingBuffer::Span first, second;
+    size_t bytes = slot.ring.peek(frames * frameBytes, first, second);
+    size_t available = bytes / frameBytes;
+    if (available < frames && !finished) {
+        voiceUnderruns.fetch_add(1, std::memory_order_relaxed);
+    }
+    if (available == 0) {
+        return !finished;
+    }
+
+    size_t firstFrames = first.size / frameBytes;
+    size_t secondFrames = available - firstFrames;
+    float t = static_cast<float>(firstFrames) / available;
+    float leftMid = voice.leftGain + (left - voice.leftGain) * t;
+    float rightMid = voice.rightGain + (right - voice.rightGain) * t;
+    kernels.mixStereoF32(reinterpret_cast<const float *>(first.data), out,
+                         firstFrames, voice.leftGain, voice.rightGain, leftMid,
+                         rightMid);
+    if (secondFrames > 0) {
+        kernels.mixStereoF32(reinterpret_cast<const float *>(second.data),
+                             out + firstFrames * CHANNELS, secondFrames,
+                             leftMid, rightMid, left, right);
+    }
+    slot.ring.consume(available * frameBytes);
+    return !(finished && slot.ring.readAvailable() == 0);
+}
+
+// 解码并转换，直到缓冲剩余空间不足一块或流结束；只在填充线程上调用，
+// 或在声部开始前由控制线程调用
+void AudioMixer::fillStream(StreamSlot &slot) {
+    const size_t frameBytes = CHANNELS * sizeof(float);
+    const size_t chunkBytes = STREAM_CHUNK_SAMPLES * frameBytes;
+    AVFrame *frame = slot.frame.get();
+
+    while (!slot.finished.load(std::memory_order_relaxed) &&
+           slot.ring.writeAvailable() >= chunkBytes) {
+        int converted;
+        if (slot.hasFrame) {
+            // 继续取出上一帧剩余的样本
+            converted = slot.resampler.convert(
+                const_cast<const uint8_t **>(frame->extended_data), 0,
+                slot.scratch.data(), STREAM_CHUNK_SAMPLES);
+        } else if (slot.draining) {
+            converted = slot.resampler.convert(
+                nullptr, 0, slot.scratch.data(), STREAM_CHUNK_SAMPLES);
+            if (converted >= 0 && converted < STREAM_CHUNK_SAMPLES) {
+                slot.ring.write(slot.scratch.data(), converted * frameBytes);
+                slot.finished.store(true, std::memory_order_release);
+                break;
+            }
+        } else {
+            int ret = slot.decoder.decodeNextFrame(frame);
+            if (ret == AVERROR_EOF) {
+                slot.draining = true;
+                continue;
+            }
+            if (ret < 0) {
+                _logger->warn("Stream decode failed, ending voice");
+                slot.finished.store(true, std::memory_order_release);
+                break;
+            }
+            slot.hasFrame = true;
+            converted = slot.resampler.convert(
+                const_cast<const uint8_t **>(frame->extended_data),
+                frame->nb_samples, slot.scratch.data(), STREAM_CHUNK_SAMPLES);
+        }
+
+        if (converted < 0) {
+            _logger->warn("Stream resampling failed, ending voice");
+            av_frame_unref(frame);
+            slot.hasFrame = false;
+            slot.finished.store(true, std::memory_order_release);
+            break;
+        }
+        if (slot.hasFrame && converted < STREAM_CHUNK_SAMPLES) {
+            // 输出未填满说明这一帧已全部取出
+            av_frame_unref(frame);
+            slot.hasFrame = false;
+        }
+        slot.ring.write(slot.scratch.data(), converted * frameBytes);
+    }
+}
+
+// 回收回调标记为结束的声部，释放片段引用并归还解码槽位
+void AudioMixer::reclaimVoices() {
+    std::lock_guard<std::mutex> lock(voiceMutex);
+    for (size_t i = 0; i < config.maxVoices; i++) {
+        Voice &voice = voices[i];
+        if (voice.state.load(std::memory_order_acquire) != FINISHED) {
+            continue;
+        }
+        if (voice.stream) {
+            StreamSlot &slot = *voice.stream;
+            slot.active.store(false, std::memory_order_relaxed);
+            slot.decoder.close();
+            slot.resampler.reset();
+            av_frame_unref(slot.frame.get());
+            slot.hasFrame = false;
+            slot.ring.clear();
+            freeStreams.push_back(static_cast<size_t>(&slot - streams.get()));
+        }
+        voice.clipRef.reset();
+        voice.clipData = nullptr;
+        voice.clipFrames = 0;
+        voice.stream = nullptr;
+        // 旧句柄从此失效
+        voice.generation++;
+        voice.state.store(FREE, std::memory_order_release);
+        freeVoices.push_back(i);
+        activeVoices--;
+    }
+}
+
+void AudioMixer::service() {
+    reclaimVoices();
+    for (size_t i = 0; i < config.maxStreams; i++) {
+        if (streams[i].active.load(std::memory_order_acquire)) {
+            fillStream(streams[i]);
+        }
+    }
+}
+
+void AudioMixer::feederLoop() {
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(feederMutex);
+            feederWakeup.wait_for(lock,
+                                  std::chrono::milliseconds(feederIntervalMs),
+                                  [this]() { return !isFeederRunning; });
+            if (!isFeederRunning) {
+                break;
+            }
+        }
+        service();
+    }
+}
+
+MixerStats AudioMixer::getStats() const {
+    MixerStats stats;
+    stats.activeVoices = activeVoices.load();
+    stats.peakVoices = peakVoices.load();
+    stats.callbacks = callbackCount.load();
+    stats.voiceUnderruns = voiceUnderruns.load();
+    stats.rejectedVoices = rejectedVoices.load();
+    stats.callback = callbackHistogram.summarize();
+    return stats;
+}
@@ -1,29 +1,47 @@
 #include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
 
 #include "audio_player.h"
 #include "logger.h"
 
-AudioPlayer::AudioPlayer()
-    : audioDevice(0),
+AudioPlayer::AudioPlayer(const AudioPlayerConfig &config)
+    : config(config),
+      audioDevice(0),
       playerState(State::STOPPED),
-      isPlaying(false),
-      isPaused(false),
       volume(SDL_MIX_MAXVOLUME),
       currentPosition(0.0),
-      isDecodingThreadRunning(false) {
+      isDecodingThreadRunning(false),
+      kernels(AudioKernels::get()) {
     _logger = Logger::getInstance().getLogger("AudioPlayer");
+    _logger->debug("Audio kernels: {}", kernels.name);
 
-    // 初始化SDL音频系统
-    if (SDL_Init(SDL_INIT_AUDIO) < 0) {
-        _logger->error("SDL初始化失败: {}", SDL_GetError());
-        return;
+    // 初始化SDL音频系统，无设备模式完全不使用SDL
+    if (!config.headless) {
+        if (SDL_Init(SDL_INIT_AUDIO) < 0) {
+            _logger->error("SDL初始化失败: {}", SDL_GetError());
+            return;
+        }
+        sdlInitialized = true;
     }
 
-    // 创建解码器实例
-    AudioDecoderConfig config;
-    config.maxQueueSize = 50;
-    config.dropFramesWhenFull = false;
-    decoder = std::make_unique<AudioDecoder>(config);
+    // 创建解码器实例，低延迟模式下减少预读，定位和切换时丢弃的数据更少。
+    // 队列深度按时长限制，与编码格式的帧长无关
+    decoderConfig.maxQueueDurationMs =
+        isLowLatency() ? std::max(config.targetLatencyMs * 4, MIN_PREFETCH_MS)
+                       : 1000;
+    decoderConfig.maxQueueSize =
+        decoderConfig.maxQueueDurationMs * 1000 / MIN_CODEC_FRAME_US + 1;
+    decoderConfig.dropFramesWhenFull = false;
+    decoderConfig.codecThreads = config.codecThreads;
+    decoderConfig.decodeScheduling = config.decodeScheduling;
+    decoderConfig.mediaInfoCache = config.mediaInfoCache;
+    decoderConfig.seekIndexMode = config.seekIndexMode;
+    decoderConfig.cacheSeekIndex = config.cacheSeekIndex;
+    decoderConfig.accurateSeek = config.accurateSeek;
+    decoder = std::make_unique<AudioDecoder>(decoderConfig);
+    decoder->setDecodeHistogram(&decodeHistogram);
 }
 
 AudioPlayer::~AudioPlayer() {
@@ -31,90 +49,219 @@ AudioPlayer::~AudioPlayer() {
     if (audioDevice) {
         SDL_CloseAudioDevice(audioDevice);
     }
-    if (swrContext) {
-        swr_free(&swrContext);
+    // 只释放自己的引用，同一进程中的其他播放器和混音器继续使用音频子系统
+    if (sdlInitialized) {
+        SDL_QuitSubSystem(SDL_INIT_AUDIO);
     }
-    SDL_Quit();
 }
 
 bool AudioPlayer::loadFile(const std::string &filename) {
+    auto loadStart = std::chrono::steady_clock::now();
+    auto finishLoad = [&]() {
+        lastLoadNanos = static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - loadStart)
+                .count());
+        openHistogram.record(lastLoadNanos);
+        prepareTrack();
+        return true;
+    };
+
     stop();  // 停止当前播放
+    useClip(nullptr);
+
+    // 命中缓存时不打开文件
+    if (config.pcmCache && loadFromCache(filename)) {
+        return finishLoad();
+    }
+
+    // 打开新文件并初始化音频设备
+    if (!openDeviceForLoad(filename)) {
+        return false;
+    }
+
+    // 初始化重采样器
+    if (!initResampler()) {
+        _logger->error("无法初始化重采样器");
+        return false;
+    }
+
+    // 短音频一次解码为设备格式放入缓存，本次播放也直接使用缓存的PCM
+    if (config.pcmCache && config.pcmCache->isCacheable(*decoder)) {
+        auto decoded =
+            config.pcmCache->insert(filename, *decoder, deviceOutputFormat());
+        if (decoded) {
+            useClip(decoded);
+            decoder->close();
+        } else if (decoder->open(filename) != AudioDecoderError::SUCCESS) {
+            // 解码失败后解码器位置已改变，重新打开按原方式播放
+            _logger->error("无法打开音频文件: {}", filename);
+            return false;
+        }
+    }
+
+    return finishLoad();
+}
+
+// 打开解码器并初始化输出。还没有设备时，在探测文件的同时按上一次的参数
+// （首次为48kHz立体声）打开设备，文件参数相同时随后的init()直接复用
+bool AudioPlayer::openDeviceForLoad(const std::string &filename) {
+    std::thread deviceOpener;
+    if (!config.headless && config.parallelDeviceOpen && audioDevice == 0) {
+        int sampleRate = requestedSpec.freq > 0 ? requestedSpec.freq
+                                                : PREDICTED_SAMPLE_RATE;
+        int channels = requestedSpec.channels > 0 ? requestedSpec.channels
+                                                  : PREDICTED_CHANNELS;
+        // 多数有损格式解码为浮点，AUTO时预测F32
+        outputSampleFormat = config.sampleFormat == OutputSampleFormat::S16
+                                 ? AV_SAMPLE_FMT_S16
+                                 : AV_SAMPLE_FMT_FLT;
+        deviceOpener = std::thread(
+            [this, sampleRate, channels]() { init(sampleRate, channels); });
+    }
 
-    // 打开新文件
     auto result = decoder->open(filename);
+    if (deviceOpener.joinable()) {
+        deviceOpener.join();
+    }
     if (result != AudioDecoderError::SUCCESS) {
         _logger->error("无法打开音频文件: {}", filename);
         return false;
     }
 
-    // 初始化音频设备
-    if (!init(decoder->getSampleRate(), decoder->getChannels())) {
+    // 初始化音频设备，无设备模式只确定输出格式
+    selectSampleFormat(decoder->getSampleFormat());
+    if (config.headless) {
+        initHeadless(decoder->getSampleRate(), decoder->getChannels());
+    } else if (!init(decoder->getSampleRate(), decoder->getChannels())) {
         _logger->error("无法初始化音频设备");
         return false;
     }
+    return true;
+}
 
-    // 初始化重采样器
-    if (!initResampler()) {
-        _logger->error("无法初始化重采样器");
+// 按解码时的源参数打开设备，实际得到的格式与缓存的PCM一致才使用缓存
+bool AudioPlayer::loadFromCache(const std::string &filename) {
+    std::shared_ptr<const PcmClip> cached = config.pcmCache->find(filename);
+    if (!cached) {
+        return false;
+    }
+
+    selectSampleFormat(cached->sourceFormat);
+    if (config.headless) {
+        initHeadless(cached->sourceSampleRate, cached->sourceChannels);
+    } else if (!init(cached->sourceSampleRate, cached->sourceChannels)) {
+        _logger->error("无法初始化音频设备");
+        return false;
+    }
+
+    AudioOutputFormat output = deviceOutputFormat();
+    if (output.sampleRate != cached->format.sampleRate ||
+        output.channels != cached->format.channels ||
+        output.sampleFormat != cached->format.sampleFormat) {
+        _logger->debug("Cached clip format differs from device: {}", filename);
         return false;
     }
 
+    // 播放列表的下一曲仍由解码器解码，需要数据块池
+    pcmPool.reset(PCM_BLOCK_SAMPLES * frameBytes, PCM_POOL_BLOCKS);
+    resampler.reset();
+    decoder->close();
+    useClip(cached);
+    _logger->debug("Playing cached clip: {}", filename);
     return true;
 }
 
+void AudioPlayer::useClip(std::shared_ptr<const PcmClip> cached) {
+    std::lock_guard<std::mutex> lock(decoderMutex);
+    clip = std::move(cached);
+    clipPosition = 0;
+}
+
 bool AudioPlayer::switchFile(const std::string &filename) {
     return loadFile(filename);
 }
 
 void AudioPlayer::play() {
-    if (playerState == State::STOPPED) {
+    if (config.headless) {
+        _logger->error("无设备模式请使用render()");
+        return;
+    }
+
+    State state = playerState.load(std::memory_order_acquire);
+    if (state == State::STOPPED) {
         if (!decoder) {
             _logger->error("没有加载音频文件");
             return;
         }
 
-        isPlaying = true;
-        playerState = State::PLAYING;
+        // 解码线程启动前发布状态，写入环形缓冲区时检查
+        playerState.store(State::PLAYING, std::memory_order_release);
 
         // 启动解码线程
-        isDecodingThreadRunning = true;
+        isDecodingThreadRunning.store(true, std::memory_order_release);
         decodingThread = std::thread(&AudioPlayer::decodingLoop, this);
 
-        // 启动SDL音频设备
+        // 首次出声的时间从加载开始计算，不包括加载完成到play()之间的空闲
+        int64_t now = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                          std::chrono::steady_clock::now().time_since_epoch())
+                          .count();
+        firstAudioStartNs.store(now - static_cast<int64_t>(lastLoadNanos),
+                                std::memory_order_relaxed);
+        lastLoadNanos = 0;
+        awaitingFirstAudio.store(true, std::memory_order_release);
+
+        // 启动回调监控线程和SDL音频设备
+        startMonitor();
         SDL_PauseAudioDevice(audioDevice, 0);
 
-        decoder->start();
-    } else if (playerState == State::PAUSED) {
+        if (!clip && !isDirectDecode(*decoder)) {
+            decoder->start();
+        }
+    } else if (state == State::PAUSED) {
         resume();
     }
 }
 
 void AudioPlayer::pause() {
-    if (playerState == State::PLAYING) {
+    State expected = State::PLAYING;
+    if (playerState.compare_exchange_strong(expected, State::PAUSED,
+                                            std::memory_order_acq_rel)) {
         SDL_PauseAudioDevice(audioDevice, 1);
-        playerState = State::PAUSED;
-        isPaused = true;
+        // 时钟停在暂停时的位置，恢复后由回调继续推进
+        SDL_LockAudioDevice(audioDevice);
+        playbackClock.freeze(playbackClock.read().frame);
+        SDL_UnlockAudioDevice(audioDevice);
     }
 }
 
 void AudioPlayer::resume() {
-    if (playerState == State::PAUSED) {
+    State expected = State::PAUSED;
+    if (playerState.compare_exchange_strong(expected, State::PLAYING,
+                                            std::memory_order_acq_rel)) {
         SDL_PauseAudioDevice(audioDevice, 0);
-        playerState = State::PLAYING;
-        isPaused = false;
     }
 }
 
+bool AudioPlayer::isActive() const {
+    return playerState.load(std::memory_order_acquire) != State::STOPPED;
+}
+
 void AudioPlayer::stop() {
-    if (playerState != State::STOPPED) {
-        // 停止解码线程
-        isDecodingThreadRunning = false;
+    if (isActive()) {
+        // 停止解码线程，正在等待缓冲区空间时立即返回
+        isDecodingThreadRunning.store(false, std::memory_order_release);
+        wakeProducer();
         if (decodingThread.joinable()) {
             decodingThread.join();
         }
 
-        // 停止音频设备
+        // 丢弃预加载的下一曲，播放列表保留
+        cancelPreload();
+
+        // 停止音频设备，之后回调不再产生事件
         SDL_PauseAudioDevice(audioDevice, 1);
+        stopMonitor();
 
         // 停止解码器
         if (decoder) {
@@ -122,204 +269,709 @@ void AudioPlayer::stop() {
         }
 
         // 清理重采样器
-        if (swrContext) {
-            swr_free(&swrContext);
-            swrContext = nullptr;
-        }
+        resampler.reset();
 
-        // 清空音频队列
-        std::lock_guard<std::mutex> lock(queueMutex);
-        std::queue<std::vector<uint8_t>> empty;
-        audioQueue.swap(empty);
+        // 清空音频缓冲区，此时解码线程已退出且设备已暂停
+        ringBuffer.clear();
+        resetClock(0);
+        if (loudnessMeter) {
+            loudnessMeter->reset();  // 再次play()时从头测量
+        }
 
-        playerState = State::STOPPED;
-        isPlaying = false;
-        isPaused = false;
         currentPosition = 0.0;
+        playerState.store(State::STOPPED, std::memory_order_release);
+        clipPosition = 0;  // 缓存的片段再次play()时从头播放
     }
 }
 
 void AudioPlayer::seek(double seconds) {
+    std::lock_guard<std::mutex> decoderLock(decoderMutex);
     if (!decoder) return;
 
     // 暂停音频输出
     SDL_PauseAudioDevice(audioDevice, 1);
 
-    // 清空音频队列
+    // 解码线程写到一半的旧位置数据不再写入，等待空间时立即返回。
+    // 递增序号和清空缓冲区在ringWriteMutex内完成，解码线程检查序号后的
+    // 写入不会落在清空之后；锁定设备保证回调不在运行
     {
-        std::lock_guard<std::mutex> lock(queueMutex);
-        std::queue<std::vector<uint8_t>> empty;
-        audioQueue.swap(empty);
+        std::lock_guard<std::mutex> writeLock(ringWriteMutex);
+        seekSerial.fetch_add(1);
+        SDL_LockAudioDevice(audioDevice);
+        ringBuffer.clear();
+        SDL_UnlockAudioDevice(audioDevice);
     }
+    wakeProducer();
 
-    // 执行seek操作
-    if (decoder->seek(seconds)) {
+    // 执行seek操作，缓存的片段只需移动读取位置
+    if (clip) {
+        size_t frame = static_cast<size_t>(
+            std::max(0.0, seconds) * clip->format.sampleRate);
+        clipPosition = std::min(frame, clip->frames());
+        currentPosition = seconds;
+    } else if (decoder->seek(seconds)) {
         currentPosition = seconds;
     }
+    if (loudnessMeter) {
+        loudnessMeter->markDiscontinuity();
+    }
+
+    // 时钟从新位置开始，下一次回调消费的第一个字节就是新位置的数据
+    SDL_LockAudioDevice(audioDevice);
+    resetClock(static_cast<int64_t>(currentPosition * deviceSampleRate));
+    SDL_UnlockAudioDevice(audioDevice);
 
     // 如果之前在播放，恢复播放
-    if (playerState == State::PLAYING) {
+    if (playerState.load(std::memory_order_acquire) == State::PLAYING) {
         SDL_PauseAudioDevice(audioDevice, 0);
     }
 }
 
+// 回调在下一块内从当前增益渐变到新音量
 void AudioPlayer::setVolume(int vol) {
-    volume = std::clamp(vol, 0, SDL_MIX_MAXVOLUME);
+    volume.store(std::clamp(vol, 0, SDL_MIX_MAXVOLUME),
+                 std::memory_order_relaxed);
+}
+
+int AudioPlayer::getVolume() const {
+    return volume.load(std::memory_order_relaxed);
 }
 
-int AudioPlayer::getVolume() const { return volume; }
+AudioPlayer::State AudioPlayer::getState() const {
+    return playerState.load(std::memory_order_acquire);
+}
 
-AudioPlayer::State AudioPlayer::getState() const { return playerState; }
+// 无设备模式没有回调推进时钟，返回解码位置
+double AudioPlayer::getCurrentPosition() const {
+    if (config.headless) {
+        return currentPosition;
+    }
+    return playbackClock.read().seconds;
+}
 
-double AudioPlayer::getCurrentPosition() const { return currentPosition; }
+ClockReading AudioPlayer::getPlaybackClock() const {
+    return playbackClock.read();
+}
+
+// 环形缓冲区中的数据加上设备缓冲区即为新写入的样本到达声卡前的延迟
+OutputLatency AudioPlayer::getOutputLatency() const {
+    OutputLatency latency;
+    if (deviceSampleRate <= 0 || frameBytes == 0) {
+        return latency;
+    }
+    double buffered =
+        static_cast<double>(ringBuffer.readAvailable() / frameBytes);
+    latency.bufferedMs = buffered * 1000.0 / deviceSampleRate;
+    latency.deviceMs =
+        static_cast<double>(deviceBufferSamples) * 1000.0 / deviceSampleRate;
+    latency.totalMs = latency.bufferedMs + latency.deviceMs;
+    return latency;
+}
 
 int AudioPlayer::getSampleRate() const {
+    std::lock_guard<std::mutex> lock(decoderMutex);
+    if (clip) {
+        return clip->sourceSampleRate;
+    }
     return decoder ? decoder->getSampleRate() : 0;
 }
 
 double AudioPlayer::getDuration() const {
+    std::lock_guard<std::mutex> lock(decoderMutex);
+    if (clip) {
+        return clip->duration();
+    }
     return decoder ? decoder->getDuration() : 0.0;
 }
 
 int AudioPlayer::getChannels() const {
+    std::lock_guard<std::mutex> lock(decoderMutex);
+    if (clip) {
+        return clip->sourceChannels;
+    }
     return decoder ? decoder->getChannels() : 0;
 }
 
+uint64_t AudioPlayer::getAllocationCount() const {
+    std::lock_guard<std::mutex> lock(decoderMutex);
+    uint64_t count = pcmPool.getAllocationCount();
+    if (decoder) {
+        count += decoder->getAllocationCount();
+    }
+    return count;
+}
+
+// 预读的输入在decodeNextFrame中可能长时间阻塞，持有decoderMutex时会卡住
+// seek()，这类输入仍由解码器线程解码
+bool AudioPlayer::isDirectDecode(const AudioDecoder &source) const {
+    return config.pipelineMode != PipelineMode::THREADED &&
+           !source.isPrefetched();
+}
+
 void AudioPlayer::decodingLoop() {
+    ScopedThreadScheduling scheduling(config.decodeScheduling, "playback");
     AVFrame *frame = nullptr;
+    AudioDecoder::FramePtr directFrame(av_frame_alloc());
 
-    while (isDecodingThreadRunning) {
-        if (decoder->getAudioFrame(&frame, 100)) {  // 100ms超时
+    while (isDecodingThreadRunning.load(std::memory_order_acquire)) {
+        if (clip) {
+            // 片段写完后与解码完毕相同，接续播放列表的下一曲
+            if (!feedClip() && !advanceToNextTrack()) {
+                waitForProducer(IDLE_WAIT_MS);
+            }
+            continue;
+        }
+        if (isDirectDecode(*decoder)) {
+            int ret = decodeDirect(directFrame.get());
+            if (ret == 0) {
+                processDecodedFrame(directFrame.get());
+                av_frame_unref(directFrame.get());
+                checkPreload();
+            } else if (!advanceToNextTrack()) {
+                // 解码完毕或读取出错，没有下一曲时保持空闲
+                waitForProducer(IDLE_WAIT_MS);
+            }
+            continue;
+        }
+        // 等待时不持锁，取序号和取帧在decoderMutex内完成：seek()持有该锁
+        // 直到解码器丢弃旧位置的帧，取到的帧总属于序号对应的位置，
+        // 取帧之后发生的定位能被写入检测到
+        bool gotFrame = false;
+        if (decoder->waitForFrame(100)) {  // 100ms超时
+            std::lock_guard<std::mutex> lock(decoderMutex);
+            emitSerial = seekSerial.load();
+            gotFrame = decoder->getAudioFrame(&frame, 0);
+        }
+        if (gotFrame) {
             if (frame) {
                 processDecodedFrame(frame);
-                av_frame_free(&frame);
+                decoder->releaseFrame(frame);
+            }
+            checkPreload();
+        } else if (decoder->isFinished()) {
+            // 当前曲目解码完毕，没有下一曲时保持空闲
+            if (!advanceToNextTrack()) {
+                waitForProducer(IDLE_WAIT_MS);
             }
         }
     }
 }
 
-void AudioPlayer::processDecodedFrame(AVFrame *frame) {
-    if (!frame) {
-        _logger->error("Null frame received");
-        return;
+// 在解码线程上直接解码一帧，定位与解码由decoderMutex互斥
+int AudioPlayer::decodeDirect(AVFrame *frame) {
+    std::lock_guard<std::mutex> lock(decoderMutex);
+    auto start = std::chrono::steady_clock::now();
+    int ret = decoder->decodeNextFrame(frame);
+    if (ret == 0) {
+        auto nanoseconds =
+            std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - start)
+                .count();
+        decodeHistogram.record(nanoseconds);
+        noteProduceTime(nanoseconds);
     }
+    emitSerial = seekSerial.load();
+    return ret;
+}
 
-    if (!swrContext) {
-        _logger->error("Resampler not initialized");
-        return;
+// 接近曲目末尾时在后台打开下一曲
+void AudioPlayer::checkPreload() {
+    double duration = decoder->getDuration();
+    if (!preloadStarted && duration > 0.0 &&
+        currentPosition >= duration - PRELOAD_AHEAD_SECONDS) {
+        startPreload();
     }
+}
 
-    auto start = std::chrono::high_resolution_clock::now();
+// 由解码线程调用：把缓存片段的下一块写入环形缓冲区，片段已写完时返回false
+bool AudioPlayer::feedClip() {
+    emitSerial = seekSerial.load();
+    size_t frames = clip->frames();
+    size_t position = clipPosition.load();
+    if (position >= frames) {
+        return false;
+    }
+    size_t count = std::min<size_t>(PCM_BLOCK_SAMPLES, frames - position);
+    if (!emitPcm(clip->data.data() + position * frameBytes,
+                 count * frameBytes)) {
+        return true;  // 解码线程正在停止
+    }
+    // 写入期间被seek()移动过位置时以新位置为准
+    clipPosition.compare_exchange_strong(position, position + count);
+    currentPosition =
+        static_cast<double>(clipPosition.load()) / clip->format.sampleRate;
+
+    if (!preloadStarted &&
+        currentPosition >= clip->duration() - PRELOAD_AHEAD_SECONDS) {
+        startPreload();
+    }
+    return true;
+}
 
-    try {
-        // 计算输出样本数，考虑重采样延迟
-        int64_t delay = swr_get_delay(swrContext, frame->sample_rate);
-        int out_samples =
-            av_rescale_rnd(delay + frame->nb_samples, deviceSampleRate,
-                           frame->sample_rate, AV_ROUND_UP);
-
-        // 检查输出样本数是否合理
-        if (out_samples <= 0) {
-            _logger->error("Invalid output samples count: {}", out_samples);
+void AudioPlayer::enqueue(const std::string &filename) {
+    std::lock_guard<std::mutex> lock(playlistMutex);
+    playlist.push_back(filename);
+}
+
+void AudioPlayer::clearPlaylist() {
+    std::lock_guard<std::mutex> lock(playlistMutex);
+    playlist.clear();
+}
+
+size_t AudioPlayer::getPlaylistSize() const {
+    std::lock_guard<std::mutex> lock(playlistMutex);
+    return playlist.size();
+}
+
+// 由解码线程调用，只在播放列表不为空时启动预加载线程
+void AudioPlayer::startPreload() {
+    {
+        std::lock_guard<std::mutex> lock(playlistMutex);
+        if (playlist.empty()) {
             return;
         }
+    }
+    preloadStarted = true;
+    preloadThread = std::thread(&AudioPlayer::preloadNext, this);
+}
 
-        // 分配输出缓冲区，添加额外的安全空间
-        size_t bytesPerSample = sizeof(int16_t);
-        size_t bufferSize = out_samples * deviceChannels * bytesPerSample;
-        std::vector<uint8_t> buffer(bufferSize);
-
-        if (buffer.empty()) {
-            _logger->error("Failed to allocate buffer of size: {}", bufferSize);
+// 预加载线程：打开下一曲，按线程模式解码时启动其解码线程在后台填满帧队列
+void AudioPlayer::preloadNext() {
+    std::string filename;
+    {
+        std::lock_guard<std::mutex> lock(playlistMutex);
+        if (playlist.empty()) {
             return;
         }
+        filename = playlist.front();
+        playlist.pop_front();
+    }
 
-        uint8_t *output_buffer[1] = {buffer.data()};
+    auto next = std::make_unique<AudioDecoder>(decoderConfig);
+    if (next->open(filename) != AudioDecoderError::SUCCESS) {
+        _logger->error("无法预加载下一曲: {}", filename);
+        return;
+    }
+    next->setDecodeHistogram(&decodeHistogram);
+    if (!isDirectDecode(*next)) {
+        next->start();
+    }
+    _logger->info("Preloaded next track: {}", filename);
 
-        // 执行重采样
-        int samples_out = swr_convert(swrContext, output_buffer, out_samples,
-                                      (const uint8_t **)frame->extended_data,
-                                      frame->nb_samples);
+    std::lock_guard<std::mutex> lock(playlistMutex);
+    nextDecoder = std::move(next);
+}
 
-        if (samples_out < 0) {
-            char errbuf[AV_ERROR_MAX_STRING_SIZE];
-            av_strerror(samples_out, errbuf, AV_ERROR_MAX_STRING_SIZE);
-            _logger->error("Resampling error: {}", errbuf);
-            return;
-        }
+// 等待预加载线程结束并丢弃已打开的下一曲
+void AudioPlayer::cancelPreload() {
+    if (preloadThread.joinable()) {
+        preloadThread.join();
+    }
+    std::lock_guard<std::mutex> lock(playlistMutex);
+    nextDecoder.reset();
+    preloadStarted = false;
+}
 
+// 由解码线程调用：把预加载的下一曲接到当前曲目之后
+bool AudioPlayer::advanceToNextTrack() {
+    // 曲目太短来不及提前预加载时，在这里同步等待
+    if (!preloadStarted) {
+        startPreload();
+    }
+    if (preloadThread.joinable()) {
+        preloadThread.join();
+    }
+
+    std::unique_ptr<AudioDecoder> next;
+    {
+        std::lock_guard<std::mutex> lock(playlistMutex);
+        next = std::move(nextDecoder);
+    }
+    preloadStarted = false;
+    if (!next) {
+        return false;
+    }
+
+    // 先取出旧重采样器中延迟的样本，保证两曲首尾样本连续
+    if (!clip) {
+        drainResampler();
+    }
+
+    LoudnessResult finished;
+    if (loudnessMeter) {
+        finished = loudnessMeter->result();
+        loudnessMeter->reset();
+        _logger->info(
+            "Track loudness: {:.1f} LUFS, LRA {:.1f} LU, true peak {:.1f} "
+            "dBTP{}",
+            finished.integratedLufs, finished.loudnessRange,
+            finished.truePeakDb, finished.complete ? "" : " (seeked)");
+    }
+
+    AudioOutputFormat output = deviceOutputFormat();
+    if (next->getSampleRate() != output.sampleRate ||
+        next->getChannels() != output.channels) {
+        _logger->info(
+            "Next track format differs from device ({} Hz/{} ch), "
+            "resampling into the open device",
+            next->getSampleRate(), next->getChannels());
+    }
+
+    // 之后写入的数据属于新曲目，回调播放到这里时时钟归零并换用新曲目的增益
+    float gain = trackGainFor(next.get());
+    pushClockMark(0, gain);
+
+    std::unique_ptr<AudioDecoder> previous;
+    {
+        std::lock_guard<std::mutex> lock(decoderMutex);
+        previous = std::move(decoder);
+        decoder = std::move(next);
+        clip.reset();
+        currentPosition = 0.0;
+        trackGain = gain;
+        lastTrackLoudness = finished;
+    }
+    // 复用已打开的音频设备，只重建重采样器
+    if (!resampler.init(*decoder, output)) {
+        _logger->error("无法为下一曲初始化重采样器");
+    }
+    previous.reset();
+    _logger->info("Gapless transition to next track");
+    return true;
+}
+
+void AudioPlayer::processDecodedFrame(AVFrame *frame) {
+    if (!frame) {
+        _logger->error("Null frame received");
+        return;
+    }
+
+    if (!resampler.isInitialized()) {
+        _logger->error("Resampler not initialized");
+        return;
+    }
+
+    try {
         // 更新播放位置
         if (frame->pts != AV_NOPTS_VALUE) {
             AVRational timeBase = decoder->getTimeBase();
             double newPosition = frame->pts * av_q2d(timeBase);
 
             // 检测是否有大的时间跳变
-            if (std::abs(newPosition - currentPosition) >
-                0.1) {  // 100ms以上的跳变
-                _logger->debug("Time jump detected: {} -> {}", currentPosition,
-                               newPosition);
+            if (Logger::isCompiledIn(Logger::Level::DEBUG) &&
+                std::abs(newPosition - currentPosition) >
+                    0.1) {  // 100ms以上的跳变
+                TEXAS_LOG_DEBUG(_logger, "Time jump detected: {} -> {}",
+                                currentPosition.load(), newPosition);
             }
 
             currentPosition = newPosition;
         }
 
+        // 格式与设备一致时帧数据直接写入输出，不经过重采样器和数据块池
+        if (resampler.isPassThrough()) {
+            size_t size = static_cast<size_t>(frame->nb_samples) * frameBytes;
+            if (!emitPcm(frame->data[0], size)) {
+                TEXAS_LOG_DEBUG(_logger,
+                                "Decoding thread stopped while waiting");
+            }
+            return;
+        }
+
+        // 重采样输出直接写入池中的数据块，一帧的输出超过块容量时分多次取出
+        PcmBlockPool::BlockPtr block = pcmPool.acquire();
+        int blockSamples = static_cast<int>(block->capacity / frameBytes);
+        const uint8_t **input = (const uint8_t **)frame->extended_data;
+        int inputSamples = frame->nb_samples;
+        int samples_out = 0;
+        std::chrono::microseconds convertTime{0};
+
+        while (true) {
+            auto start = std::chrono::steady_clock::now();
+            int converted = resampler.convert(input, inputSamples,
+                                              block->data.get(), blockSamples);
+            auto elapsed = std::chrono::steady_clock::now() - start;
+            convertTime +=
+                std::chrono::duration_cast<std::chrono::microseconds>(elapsed);
+            auto nanoseconds =
+                std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed)
+                    .count();
+            resampleHistogram.record(nanoseconds);
+            noteProduceTime(nanoseconds);
+
+            if (converted < 0) {
+                char errbuf[AV_ERROR_MAX_STRING_SIZE];
+                av_strerror(converted, errbuf, AV_ERROR_MAX_STRING_SIZE);
+                _logger->error("Resampling error: {}", errbuf);
+                return;
+            }
+
+            // 输入已全部交给重采样器，后续调用只取出其内部缓存的样本
+            inputSamples = 0;
+            samples_out += converted;
+            block->size = converted * frameBytes;
+            block->readOffset = 0;
+
+            if (!emitBlock(*block)) {
+                TEXAS_LOG_DEBUG(_logger,
+                                "Decoding thread stopped while waiting");
+                return;
+            }
+            if (converted < blockSamples) {
+                break;
+            }
+        }
+
         // 计算实际输出的字节数
-        size_t actualBufferSize = samples_out * deviceChannels * bytesPerSample;
+        size_t actualBufferSize = samples_out * frameBytes;
 
         // 性能监控
-        auto end = std::chrono::high_resolution_clock::now();
-        auto duration =
-            std::chrono::duration_cast<std::chrono::microseconds>(end - start);
-        if (duration.count() > 1000) {  // 超过1ms的处理时间
+        if (convertTime.count() > 1000) {  // 超过1ms的处理时间
             _logger->warn(
                 "Frame processing took {} us, samples: {}, size: {} bytes",
-                duration.count(), samples_out, actualBufferSize);
+                convertTime.count(), samples_out, actualBufferSize);
         }
 
-        // 监控重采样比率
-        float resampleRatio =
-            static_cast<float>(samples_out) / frame->nb_samples;
-        if (std::abs(resampleRatio - 1.0f) > 0.1f) {  // 重采样比率偏差超过10%
-            _logger->debug("High resample ratio: {:.2f}, in: {}, out: {}",
-                           resampleRatio, frame->nb_samples, samples_out);
+        // 以下监控只输出debug日志，编译期移除debug级别时一起跳过
+        if constexpr (Logger::isCompiledIn(Logger::Level::DEBUG)) {
+            // 监控重采样比率
+            float resampleRatio =
+                static_cast<float>(samples_out) / frame->nb_samples;
+            if (std::abs(resampleRatio - 1.0f) > 0.1f) {  // 偏差超过10%
+                TEXAS_LOG_DEBUG(_logger,
+                                "High resample ratio: {:.2f}, in: {}, out: {}",
+                                resampleRatio, frame->nb_samples, samples_out);
+            }
+
+            // 如果缓冲区之前接近空，记录恢复事件
+            size_t buffered = ringBuffer.readAvailable();
+            if (!config.headless &&
+                buffered <= bytesForDuration(LOW_WATER_MARK_MS)) {
+                TEXAS_LOG_DEBUG(_logger, "Buffer recovering: {} bytes buffered",
+                                buffered);
+            }
         }
 
-        // 将处理后的数据推入播放队列
-        std::unique_lock<std::mutex> lock(queueMutex);
+    } catch (const std::exception &e) {
+        _logger->error("Exception in processDecodedFrame: {}", e.what());
+    } catch (...) {
+        _logger->error("Unknown exception in processDecodedFrame");
+    }
+}
 
-        // 检查队列大小
-        if (audioQueue.size() >= MAX_QUEUE_SIZE) {
-            _logger->warn("Queue full, waiting for space...");
-            dataCondition.wait(lock, [this] {
-                return audioQueue.size() < MAX_QUEUE_SIZE ||
-                       !isDecodingThreadRunning;
-            });
+bool AudioPlayer::emitBlock(PcmBlock &block) {
+    if (!emitPcm(block.readPtr(), block.remaining())) {
+        return false;
+    }
+    block.readOffset = block.size;
+    return true;
+}
 
-            if (!isDecodingThreadRunning) {
-                _logger->debug("Decoding thread stopped while waiting");
-                return;
-            }
+// 把PCM数据交给当前的输出目标：音频设备的环形缓冲区或无设备模式的sink
+bool AudioPlayer::emitPcm(const uint8_t *data, size_t size) {
+    if (loudnessMeter) {
+        analyzePcm(data, size);
+    }
+    if (!config.headless) {
+        return writePcm(data, size);
+    }
+
+    renderedSamples += size / frameBytes;
+    if (wavWriter.isOpen() && !wavWriter.write(data, size)) {
+        _logger->error("写入输出文件失败: {}", config.outputFile);
+        isDecodingThreadRunning.store(false, std::memory_order_release);
+        return false;
+    }
+    if (config.sink && !config.sink(data, size)) {
+        isDecodingThreadRunning.store(false, std::memory_order_release);
+        return false;
+    }
+    return true;
+}
+
+// 由解码线程在输出前调用，测量的是音量和曲目增益之前的信号
+void AudioPlayer::analyzePcm(const uint8_t *data, size_t size) {
+    size_t frames = frameBytes > 0 ? size / frameBytes : 0;
+    if (isFloatOutput()) {
+        loudnessMeter->process(reinterpret_cast<const float *>(data), frames);
+    } else {
+        loudnessMeter->process(reinterpret_cast<const int16_t *>(data),
+                               frames);
+    }
+}
+
+// 加载完成后调用，解码线程未运行：按输出格式准备响度计，按标签设置曲目增益
+void AudioPlayer::prepareTrack() {
+    std::lock_guard<std::mutex> lock(decoderMutex);
+    lastTrackLoudness = LoudnessResult();
+    if (config.analyzeLoudness) {
+        if (!loudnessMeter ||
+            loudnessMeter->getSampleRate() != deviceSampleRate ||
+            loudnessMeter->getChannels() != deviceChannels) {
+            loudnessMeter = std::make_unique<LoudnessMeter>(deviceSampleRate,
+                                                            deviceChannels);
+        } else {
+            loudnessMeter->reset();
         }
+    }
+
+    trackGain = trackGainFor(clip ? nullptr : decoder.get());
+    if (!config.headless && audioDevice) {
+        SDL_LockAudioDevice(audioDevice);
+        clockBase.gain = trackGain;
+        SDL_UnlockAudioDevice(audioDevice);
+    }
+}
 
-        // 创建新的数据块并移动数据
-        std::vector<uint8_t> data;
-        data.reserve(actualBufferSize);  // 预分配内存避免复制
-        data.assign(buffer.data(), buffer.data() + actualBufferSize);
+// 标签中的曲目增益加上前级增益；未开启、没有标签或无设备模式时为1
+float AudioPlayer::trackGainFor(const AudioDecoder *source) const {
+    if (!config.applyReplayGain || config.headless || !source) {
+        return 1.0f;
+    }
+    double db = source->getTrackGainDb();
+    if (std::isnan(db)) {
+        return 1.0f;
+    }
+    return static_cast<float>(
+        std::pow(10.0, (db + config.replayGainPreampDb) / 20.0));
+}
 
-        audioQueue.push(std::move(data));
-        updateBufferSize(actualBufferSize);
+LoudnessResult AudioPlayer::getLoudness() const {
+    std::lock_guard<std::mutex> lock(decoderMutex);
+    return loudnessMeter ? loudnessMeter->result() : LoudnessResult();
+}
 
-        // 如果队列之前接近空，记录恢复事件
-        if (audioQueue.size() <= LOW_WATER_MARK) {
-            _logger->debug("Buffer recovering: {} frames in queue",
-                           audioQueue.size());
+LoudnessResult AudioPlayer::getLastTrackLoudness() const {
+    std::lock_guard<std::mutex> lock(decoderMutex);
+    return lastTrackLoudness;
+}
+
+// 流结束时取出重采样器中延迟的样本
+void AudioPlayer::drainResampler() {
+    PcmBlockPool::BlockPtr block = pcmPool.acquire();
+    int blockSamples = static_cast<int>(block->capacity / frameBytes);
+    while (true) {
+        int converted =
+            resampler.convert(nullptr, 0, block->data.get(), blockSamples);
+        if (converted <= 0) {
+            break;
+        }
+        block->size = converted * frameBytes;
+        block->readOffset = 0;
+        if (!emitBlock(*block) || converted < blockSamples) {
+            break;
         }
+    }
+}
 
-    } catch (const std::exception &e) {
-        _logger->error("Exception in processDecodedFrame: {}", e.what());
-    } catch (...) {
-        _logger->error("Unknown exception in processDecodedFrame");
+RenderStats AudioPlayer::render() {
+    RenderStats stats;
+    if (!config.headless) {
+        _logger->error("render()只能在无设备模式下使用");
+        return stats;
     }
+    if (!decoder || (!clip && !resampler.isInitialized())) {
+        _logger->error("没有加载音频文件");
+        return stats;
+    }
+
+    if (!config.outputFile.empty() &&
+        !wavWriter.open(config.outputFile, deviceSampleRate, deviceChannels,
+                        av_get_bytes_per_sample(outputSampleFormat) * 8,
+                        isFloatOutput())) {
+        _logger->error("无法创建输出文件: {}", config.outputFile);
+        return stats;
+    }
+
+    playerState.store(State::PLAYING, std::memory_order_release);
+    isDecodingThreadRunning.store(true, std::memory_order_release);
+    renderedSamples = 0;
+
+    // 在调用线程上直接拉取解码帧，不经过解码线程、帧队列和环形缓冲区
+    AudioDecoder::FramePtr frame(av_frame_alloc());
+    auto start = std::chrono::steady_clock::now();
+    bool reachedEnd = false;
+
+    if (clip) {
+        // 缓存的片段一次写出
+        size_t position = std::min(clipPosition.load(), clip->frames());
+        reachedEnd =
+            emitPcm(clip->data.data() + position * frameBytes,
+                    (clip->frames() - position) * frameBytes);
+    }
+    while (!clip &&
+           isDecodingThreadRunning.load(std::memory_order_acquire)) {
+        int ret = decoder->decodeNextFrame(frame.get());
+        if (ret == AVERROR_EOF) {
+            reachedEnd = true;
+            break;
+        }
+        if (ret < 0) {
+            break;
+        }
+        processDecodedFrame(frame.get());
+        av_frame_unref(frame.get());
+    }
+    if (reachedEnd && !clip &&
+        isDecodingThreadRunning.load(std::memory_order_acquire)) {
+        drainResampler();
+    }
+
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    bool written = wavWriter.close();
+
+    stats.success = reachedEnd && written &&
+                    isDecodingThreadRunning.load(std::memory_order_acquire);
+    stats.samples = renderedSamples;
+    stats.audioSeconds =
+        deviceSampleRate > 0
+            ? static_cast<double>(renderedSamples) / deviceSampleRate
+            : 0.0;
+    stats.wallSeconds = std::chrono::duration<double>(elapsed).count();
+    stats.realtimeFactor = stats.wallSeconds > 0.0
+                               ? stats.audioSeconds / stats.wallSeconds
+                               : 0.0;
+    if (loudnessMeter) {
+        stats.loudness = loudnessMeter->result();
+    }
+
+    _logger->info("Rendered {:.2f}s of audio in {:.3f}s ({:.1f}x realtime)",
+                  stats.audioSeconds, stats.wallSeconds,
+                  stats.realtimeFactor);
+
+    isDecodingThreadRunning.store(false, std::memory_order_release);
+    playerState.store(State::STOPPED, std::memory_order_release);
+    return stats;
+}
+
+// 将PCM数据写入环形缓冲区，空间不足时等待回调消费后分段写入
+bool AudioPlayer::writePcm(const uint8_t *data, size_t size) {
+    while (size > 0) {
+        size_t wanted =
+            std::min(size, bufferLimit.load(std::memory_order_relaxed) / 2);
+        if (!waitForSpace(wanted, emitSerial)) {
+            return false;
+        }
+        // 等待之后填充深度可能已经收缩，写不下时重新等待
+        size_t written = 0;
+        {
+            std::lock_guard<std::mutex> writeLock(ringWriteMutex);
+            if (seekSerial.load() != emitSerial) {
+                return false;  // 等待之后发生了定位
+            }
+            size_t chunk = std::min(size, fillSpace());
+            chunk -= chunk % frameBytes;
+            written = ringBuffer.write(data, chunk);
+        }
+        data += written;
+        size -= written;
+
+        size_t buffered = ringBuffer.readAvailable();
+        if (buffered > bufferHighWater.load(std::memory_order_relaxed)) {
+            bufferHighWater.store(buffered, std::memory_order_relaxed);
+        }
+    }
+    return true;
 }
 
 bool AudioPlayer::init(int sampleRate, int channels) {
@@ -327,182 +979,651 @@ bool AudioPlayer::init(int sampleRate, int channels) {
 
     SDL_zero(wanted_spec);
     wanted_spec.freq = sampleRate;
-    wanted_spec.format = AUDIO_S16SYS;
-    wanted_spec.channels = channels;
-    wanted_spec.samples = 4096;
+    wanted_spec.format = isFloatOutput() ? AUDIO_F32SYS : AUDIO_S16SYS;
+    wanted_spec.channels = static_cast<Uint8>(std::clamp(channels, 1,
+                                                         MAX_DEVICE_CHANNELS));
+    wanted_spec.samples = static_cast<Uint16>(deviceSamplesFor(sampleRate));
     wanted_spec.callback = audioCallback;
     wanted_spec.userdata = this;
 
-    if (audioDevice) {
-        SDL_CloseAudioDevice(audioDevice);
+    // 参数与当前设备相同时直接复用，切换曲目不再关闭和重新打开设备
+    bool reuse = audioDevice != 0 && wanted_spec.freq == requestedSpec.freq &&
+                 wanted_spec.format == requestedSpec.format &&
+                 wanted_spec.channels == requestedSpec.channels &&
+                 wanted_spec.samples == requestedSpec.samples;
+    if (!reuse) {
+        if (audioDevice) {
+            SDL_CloseAudioDevice(audioDevice);
+            audioDevice = 0;
+        }
+
+        // 允许设备改变声道数：设备的扬声器比源文件少时由重采样器按源文件的
+        // 真实布局一次重混，SDL不再另做一次转换；声道数相同时直接输出
+        audioDevice = SDL_OpenAudioDevice(nullptr, 0, &wanted_spec,
+                                          &obtained_spec,
+                                          SDL_AUDIO_ALLOW_CHANNELS_CHANGE);
+        if (audioDevice == 0) {
+            _logger->error("无法打开音频设备: {}", SDL_GetError());
+            return false;
+        }
+        requestedSpec = wanted_spec;
+
+        // 保存实际获得的音频参数
+        deviceFormat = obtained_spec.format;
+        deviceChannels = obtained_spec.channels;
+        deviceSampleRate = obtained_spec.freq;
+        deviceBufferSamples = obtained_spec.samples;
     }
 
-    audioDevice =
-        SDL_OpenAudioDevice(nullptr, 0, &wanted_spec, &obtained_spec, 0);
-    if (audioDevice == 0) {
-        _logger->error("无法打开音频设备: {}", SDL_GetError());
-        return false;
+    // 按自适应缓冲的上限预分配环形缓冲区，回调路径上不再分配内存；
+    // 至少容纳两个设备周期，保证每次回调都有完整的一段数据可读
+    frameBytes = deviceChannels * av_get_bytes_per_sample(outputSampleFormat);
+    int initialMs = ringBufferMs();
+    int maxMs = maxBufferMs(initialMs);
+    size_t capacity =
+        std::max(bytesForDuration(maxMs),
+                 static_cast<size_t>(deviceBufferSamples) * frameBytes * 2);
+    if (capacity != ringBuffer.capacity()) {
+        ringBuffer.reset(capacity);
+        _logger->debug("Ring buffer allocated: {} bytes ({} ms)", capacity,
+                       maxMs);
+    } else {
+        ringBuffer.clear();
+    }
+    configureBuffer(initialMs, maxMs);
+
+    // 数据交给设备后还要等设备缓冲中已有的一个周期播完才发声
+    playbackClock.configure(
+        deviceSampleRate,
+        deviceBufferSamples +
+            static_cast<int64_t>(deviceSampleRate) *
+                config.extraOutputLatencyMs / 1000);
+    resetClock(0);
+
+    if (reuse) {
+        _logger->debug("Reusing audio device: {} Hz", deviceSampleRate);
+    } else {
+        _logger->info(
+            "Audio device opened: {} Hz, {} ch, {} samples per period ({} ms)",
+            deviceSampleRate, deviceChannels, deviceBufferSamples,
+            deviceBufferSamples * 1000 / deviceSampleRate);
+        if (deviceChannels != wanted_spec.channels) {
+            _logger->info("Device has {} channels, source has {}",
+                          deviceChannels, wanted_spec.channels);
+        }
     }
+    return true;
+}
 
-    // 保存实际获得的音频参数
-    deviceFormat = obtained_spec.format;
-    deviceChannels = obtained_spec.channels;
-    deviceSampleRate = obtained_spec.freq;
+// 按配置和源文件的采样格式确定输出格式，同一设备上的后续曲目沿用这一格式
+void AudioPlayer::selectSampleFormat(AVSampleFormat sourceFormat) {
+    bool useFloat = false;
+    switch (config.sampleFormat) {
+        case OutputSampleFormat::S16:
+            useFloat = false;
+            break;
+        case OutputSampleFormat::F32:
+            useFloat = true;
+            break;
+        case OutputSampleFormat::AUTO: {
+            AVSampleFormat packed = av_get_packed_sample_fmt(sourceFormat);
+            useFloat = packed == AV_SAMPLE_FMT_FLT ||
+                       packed == AV_SAMPLE_FMT_DBL;
+            break;
+        }
+    }
+    outputSampleFormat = useFloat ? AV_SAMPLE_FMT_FLT : AV_SAMPLE_FMT_S16;
+}
 
-    return true;
+bool AudioPlayer::isFloatOutput() const {
+    return outputSampleFormat == AV_SAMPLE_FMT_FLT;
 }
 
-// SDL音频回调函数，当SDL需要更多音频数据时会调用这个函数
-void AudioPlayer::audioCallback(void *userdata, Uint8 *stream, int len) {
-    // 将userdata转换回AudioPlayer实例
-    AudioPlayer *player = static_cast<AudioPlayer *>(userdata);
-    // 调用实例方法填充音频缓冲区
-    player->fillAudioBuffer(stream, len);
+bool AudioPlayer::isLowLatency() const {
+    return config.targetLatencyMs > 0 || config.deviceBufferSamples > 0;
 }
 
-// 填充SDL音频缓冲区
-void AudioPlayer::fillAudioBuffer(Uint8 *stream, int len) {
-    SDL_memset(stream, 0, len);
+// 设备缓冲采样数：显式指定时直接使用，否则取目标延迟一半以内最大的2的幂，
+// 另一半留给环形缓冲区吸收解码线程的调度抖动
+int AudioPlayer::deviceSamplesFor(int sampleRate) const {
+    if (config.deviceBufferSamples > 0) {
+        return std::clamp(config.deviceBufferSamples, MIN_DEVICE_SAMPLES,
+                          DEFAULT_DEVICE_SAMPLES);
+    }
+    if (config.targetLatencyMs <= 0) {
+        return DEFAULT_DEVICE_SAMPLES;
+    }
+    int budget = sampleRate * config.targetLatencyMs / 1000 / 2;
+    int samples = MIN_DEVICE_SAMPLES;
+    while (samples * 2 <= budget && samples * 2 <= DEFAULT_DEVICE_SAMPLES) {
+        samples *= 2;
+    }
+    return samples;
+}
+
+// 环形缓冲区时长：目标延迟扣除设备缓冲部分，只指定采样数时按两个设备周期
+int AudioPlayer::ringBufferMs() const {
+    if (!isLowLatency()) {
+        return AUDIO_BUFFER_MS;
+    }
+    int deviceMs = deviceSampleRate > 0
+                       ? deviceBufferSamples * 1000 / deviceSampleRate
+                       : 0;
+    if (config.targetLatencyMs > 0) {
+        return std::max(config.targetLatencyMs - deviceMs, 1);
+    }
+    return std::max(deviceMs * 2, 1);
+}
+
+// 自适应缓冲的上限，关闭时与初始深度相同
+int AudioPlayer::maxBufferMs(int initialMs) const {
+    if (!config.adaptiveBuffer) {
+        return initialMs;
+    }
+    if (config.maxBufferMs > 0) {
+        return std::max(config.maxBufferMs, initialMs);
+    }
+    return std::max(initialMs * 2, initialMs + BUFFER_HEADROOM_MS);
+}
 
-    std::unique_lock<std::mutex> lock(queueMutex);
+// 设备打开后配置控制器，已经学到的填充深度跨曲目保留
+void AudioPlayer::configureBuffer(int initialMs, int maxMs) {
+    BufferControllerConfig bconfig;
+    bconfig.sampleRate = deviceSampleRate;
+    bconfig.frameBytes = frameBytes;
+    bconfig.periodMs = deviceBufferSamples * 1000 / deviceSampleRate;
+    bconfig.minMs = isLowLatency() ? initialMs : MIN_BUFFER_MS;
+    bconfig.maxMs = maxMs;
+    bconfig.initialMs = initialMs;
+
+    std::lock_guard<std::mutex> lock(bufferControlMutex);
+    bufferController.configure(bconfig);
+    bufferMinBytes = static_cast<size_t>(deviceBufferSamples) * frameBytes * 2;
+    bufferMaxBytes = ringBuffer.capacity();
+    size_t limit = config.adaptiveBuffer ? bufferController.getTargetBytes()
+                                         : bufferMaxBytes;
+    bufferLimit.store(std::clamp(limit, bufferMinBytes, bufferMaxBytes),
+                      std::memory_order_relaxed);
+    windowMinFill.store(SIZE_MAX, std::memory_order_relaxed);
+    windowMaxProduceNs.store(0, std::memory_order_relaxed);
+}
 
-    if (audioQueue.empty()) {
-        underrun = true;
-        _logger->warn("Audio buffer underrun detected");
+// 监控线程每个窗口调用一次。暂停、等待首次出声、定位后和生产者空闲
+// （曲目播完没有下一曲）的窗口不代表系统的抖动，只取走观测值不调整
+void AudioPlayer::adaptBuffer() {
+    uint64_t underruns = underrunCount.load(std::memory_order_relaxed);
+    uint64_t callbacks = callbackCount.load(std::memory_order_relaxed);
+    uint64_t serial = seekSerial.load();
+    BufferObservation observation;
+    observation.underruns = underruns - observedUnderruns;
+    observation.minFillBytes =
+        windowMinFill.exchange(SIZE_MAX, std::memory_order_relaxed);
+    observation.maxProduceNs =
+        windowMaxProduceNs.exchange(0, std::memory_order_relaxed);
+    bool idle = producerIdle.exchange(false, std::memory_order_relaxed);
+    bool called = callbacks != observedCallbacks;
+    observedUnderruns = underruns;
+    observedCallbacks = callbacks;
+    if (serial != observedSeekSerial) {
+        observedSeekSerial = serial;
+        settleWindows = BUFFER_SETTLE_WINDOWS;
+    }
+    if (settleWindows > 0) {
+        settleWindows--;
+        return;
+    }
+    if (!config.adaptiveBuffer || idle || !called ||
+        observation.minFillBytes == SIZE_MAX ||
+        awaitingFirstAudio.load(std::memory_order_acquire) ||
+        playerState.load(std::memory_order_acquire) != State::PLAYING) {
         return;
     }
 
-    size_t totalCopied = 0;
-    while (len > 0 && !audioQueue.empty()) {
-        std::vector<uint8_t> &data = audioQueue.front();
-        int copyLen = std::min(len, static_cast<int>(data.size()));
+    std::lock_guard<std::mutex> lock(bufferControlMutex);
+    int previous = bufferController.getTargetMs();
+    if (!bufferController.update(observation)) {
+        return;
+    }
+    size_t limit = std::clamp(bufferController.getTargetBytes(),
+                              bufferMinBytes, bufferMaxBytes);
+    bufferLimit.store(limit, std::memory_order_relaxed);
+    int target = bufferController.getTargetMs();
+    if (target > previous) {
+        // 等待空间的生产者立即按新的深度继续填充
+        wakeProducer();
+        _logger->info("Buffer target raised to {} ms ({} underruns, {:.1f} "
+                      "ms decode)",
+                      target, observation.underruns,
+                      observation.maxProduceNs / 1e6);
+    } else {
+        TEXAS_LOG_DEBUG(_logger, "Buffer target lowered to {} ms", target);
+    }
+}
 
-        if (underrun && totalCopied == 0) {
-            for (int i = 0; i < copyLen; i++) {
-                float fade = static_cast<float>(i) / copyLen;
-                stream[i] = static_cast<Uint8>(data[i] * fade);
-            }
-        } else {
-            SDL_MixAudioFormat(stream, data.data(), AUDIO_S16SYS, copyLen,
-                               volume);
-        }
+// 生产者还能写入的字节数：缓冲区填充到当前的自适应深度为止
+size_t AudioPlayer::fillSpace() const {
+    size_t limit = bufferLimit.load(std::memory_order_relaxed);
+    size_t buffered = ringBuffer.readAvailable();
+    if (buffered >= limit) {
+        return 0;
+    }
+    return std::min(limit - buffered, ringBuffer.writeAvailable());
+}
 
-        if (copyLen < data.size()) {
-            data.erase(data.begin(), data.begin() + copyLen);
-            updateBufferSize(-copyLen);
-        } else {
-            updateBufferSize(-data.size());
-            audioQueue.pop();
+// 由解码线程调用；与监控线程取走并清零竞争时，最多把一帧计入下个窗口
+void AudioPlayer::noteProduceTime(uint64_t nanoseconds) {
+    if (nanoseconds > windowMaxProduceNs.load(std::memory_order_relaxed)) {
+        windowMaxProduceNs.store(nanoseconds, std::memory_order_relaxed);
+    }
+}
+
+// 无设备模式没有设备参数可协商，输出格式由配置或源文件决定
+void AudioPlayer::initHeadless(int sampleRate, int channels) {
+    deviceFormat = isFloatOutput() ? AUDIO_F32SYS : AUDIO_S16SYS;
+    deviceSampleRate =
+        config.outputSampleRate > 0 ? config.outputSampleRate : sampleRate;
+    deviceChannels =
+        config.outputChannels > 0 ? config.outputChannels : channels;
+    deviceBufferSamples = 0;
+    frameBytes = deviceChannels * av_get_bytes_per_sample(outputSampleFormat);
+}
+
+size_t AudioPlayer::bytesForDuration(int ms) const {
+    size_t frames = static_cast<size_t>(deviceSampleRate) * ms / 1000;
+    return frames * frameBytes;
+}
+
+// 等待环形缓冲区腾出空间。停止或在serial之后发生了定位时返回false。
+// 按需模式下等到缓冲区降到一半，由回调唤醒后一次填满，其他模式按半个
+// 设备周期检查
+bool AudioPlayer::waitForSpace(size_t bytes, uint64_t serial) {
+    bool onDemand = config.pipelineMode == PipelineMode::ON_DEMAND;
+    int periodMs =
+        deviceSampleRate > 0 ? deviceBufferSamples * 1000 / deviceSampleRate
+                             : 10;
+    // 按需模式的超时只是兜底，正常情况下由回调唤醒
+    size_t limit = bufferLimit.load(std::memory_order_relaxed);
+    int limitMs = deviceSampleRate > 0
+                      ? static_cast<int>(limit / frameBytes * 1000 /
+                                         deviceSampleRate)
+                      : 10;
+    auto interval = std::chrono::milliseconds(
+        onDemand ? std::max(1, limitMs / 2) : std::max(1, periodMs / 2));
+    size_t target = onDemand ? std::max(bytes, limit / 2) : bytes;
+
+    auto aborted = [this, serial]() {
+        return !isDecodingThreadRunning.load(std::memory_order_acquire) ||
+               seekSerial.load() != serial;
+    };
+    std::unique_lock<std::mutex> lock(producerMutex);
+    while (fillSpace() < target) {
+        if (aborted()) {
+            return false;
         }
+        producerWaiting.store(onDemand);
+        producerWakeup.wait_for(lock, interval, [&]() {
+            return aborted() || fillSpace() >= target;
+        });
+        producerWaiting.store(false);
+        producerWakeups.fetch_add(1, std::memory_order_relaxed);
+    }
+    return !aborted();
+}
 
-        stream += copyLen;
-        len -= copyLen;
-        totalCopied += copyLen;
+// 加锁后再通知，等待方检查条件与进入等待之间不会漏掉
+void AudioPlayer::wakeProducer() {
+    { std::lock_guard<std::mutex> lock(producerMutex); }
+    producerWakeup.notify_all();
+}
+
+// 没有数据可写时的空闲等待，stop()立即唤醒
+void AudioPlayer::waitForProducer(int ms) {
+    producerIdle.store(true, std::memory_order_relaxed);
+    std::unique_lock<std::mutex> lock(producerMutex);
+    producerWakeup.wait_for(lock, std::chrono::milliseconds(ms), [this]() {
+        return !isDecodingThreadRunning.load(std::memory_order_acquire);
+    });
+}
+
+// 由解码线程调用，标记之后写入环形缓冲区的数据从mediaFrame开始；
+// 标记队列满时丢弃，时钟在下一次定位或停止时恢复
+void AudioPlayer::pushClockMark(int64_t mediaFrame, float gain) {
+    if (config.headless) {
+        return;
+    }
+    ClockMark mark{ringBuffer.totalWritten(), mediaFrame, gain};
+    if (clockMarks.writeAvailable() >= sizeof(mark)) {
+        clockMarks.write(reinterpret_cast<const uint8_t *>(&mark),
+                         sizeof(mark));
     }
+}
 
-    if (audioQueue.size() < LOW_WATER_MARK) {
-        lock.unlock();
-        dataCondition.notify_one();
+// 回调中调用：取出已经播放到的标记，返回环形缓冲区偏移ringBytes处的媒体帧
+int64_t AudioPlayer::playbackFrameAt(size_t ringBytes) {
+    while (true) {
+        if (!hasPendingMark &&
+            clockMarks.readAvailable() >= sizeof(ClockMark)) {
+            clockMarks.read(reinterpret_cast<uint8_t *>(&pendingMark),
+                            sizeof(ClockMark));
+            hasPendingMark = true;
+        }
+        if (!hasPendingMark || pendingMark.ringBytes > ringBytes) {
+            break;
+        }
+        clockBase = pendingMark;
+        hasPendingMark = false;
+    }
+    if (frameBytes == 0) {
+        return clockBase.mediaFrame;
     }
+    return clockBase.mediaFrame +
+           static_cast<int64_t>((ringBytes - clockBase.ringBytes) / frameBytes);
+}
 
-    underrun = false;
+// 回调已停止或设备已锁住时调用：丢弃未播放的标记，时钟停在mediaFrame
+void AudioPlayer::resetClock(int64_t mediaFrame) {
+    clockMarks.clear();
+    hasPendingMark = false;
+    clockBase = {ringBuffer.totalRead(), mediaFrame, trackGain.load()};
+    appliedGain = static_cast<float>(volume.load(std::memory_order_relaxed)) /
+                  SDL_MIX_MAXVOLUME * clockBase.gain;
+    playbackClock.freeze(mediaFrame);
 }
 
-void AudioPlayer::updateBufferSize(int64_t delta) {
-    size_t current = bufferedSize.load();
-    while (!bufferedSize.compare_exchange_weak(
-        current, current + delta));  // 空循环直到成功
+// SDL音频回调函数，当SDL需要更多音频数据时会调用这个函数
+void AudioPlayer::audioCallback(void *userdata, Uint8 *stream, int len) {
+    // 将userdata转换回AudioPlayer实例
+    AudioPlayer *player = static_cast<AudioPlayer *>(userdata);
+    // 调用实例方法填充音频缓冲区
+    player->fillAudioBuffer(stream, len);
 }
 
-// 将解码后的音频数据推入播放队列
-bool AudioPlayer::pushAudioData(const uint8_t *data, int size) {
-    if (!isPlaying || size <= 0) {
-        return false;
+// 填充SDL音频缓冲区（实时线程：只做原子读写、内存拷贝和增益内核，
+// 不加锁、不分配内存、不写日志，事件交给监控线程记录）
+void AudioPlayer::fillAudioBuffer(Uint8 *stream, int len) {
+    auto start = std::chrono::steady_clock::now();
+    uint64_t sequence =
+        callbackCount.fetch_add(1, std::memory_order_relaxed) + 1;
+
+    int64_t nowNs = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                        start.time_since_epoch())
+                        .count();
+
+    size_t wanted = static_cast<size_t>(len);
+    size_t buffered = ringBuffer.readAvailable();
+    // 自适应缓冲的观测：本窗口内回调开始时的最低水位
+    if (buffered < windowMinFill.load(std::memory_order_relaxed)) {
+        windowMinFill.store(buffered, std::memory_order_relaxed);
+    }
+    int64_t frame = playbackFrameAt(ringBuffer.totalRead());
+    size_t copied = mixFromRing(stream, std::min(wanted, buffered));
+    playbackClock.advance(frame, static_cast<int64_t>(copied / frameBytes),
+                          nowNs, clockBase.mediaFrame);
+    if (copied > 0 && awaitingFirstAudio.load(std::memory_order_acquire)) {
+        awaitingFirstAudio.store(false, std::memory_order_relaxed);
+        int64_t startNs = firstAudioStartNs.load(std::memory_order_relaxed);
+        firstAudioHistogram.record(
+            static_cast<uint64_t>(std::max<int64_t>(0, nowNs - startNs)));
     }
 
-    std::unique_lock<std::mutex> lock(queueMutex);
+    // 按需模式下生产者在等待且缓冲区已降到一半时唤醒它；通知丢失时
+    // 标志仍然有效，下一次回调会再次通知。notify_one不加锁
+    if (config.pipelineMode == PipelineMode::ON_DEMAND &&
+        producerWaiting.load(std::memory_order_relaxed) &&
+        fillSpace() >= bufferLimit.load(std::memory_order_relaxed) / 2) {
+        producerWakeup.notify_one();
+    }
 
-    // 如果队列已满，等待队列有空间
-    if (audioQueue.size() >= MAX_QUEUE_SIZE) {
-        dataCondition.wait(lock, [this] {
-            return audioQueue.size() < MAX_QUEUE_SIZE || !isPlaying;
-        });
+    // 数据不足的部分补静音
+    if (copied < wanted) {
+        SDL_memset(stream + copied, 0, wanted - copied);
+        underrunCount.fetch_add(1, std::memory_order_relaxed);
+        underrun.store(true, std::memory_order_relaxed);
+        callbackEvents.push({AudioEvent::Type::UNDERRUN,
+                             static_cast<uint32_t>(wanted - copied),
+                             sequence});
+    } else {
+        underrun.store(false, std::memory_order_relaxed);
+    }
 
-        // 如果在等待过程中播放器停止，返回false
-        if (!isPlaying) {
-            return false;
-        }
+    // 定期报告回调开始时的缓冲区水位
+    if (fillReportInterval > 0 && sequence % fillReportInterval == 0) {
+        callbackEvents.push({AudioEvent::Type::FILL_LEVEL,
+                             static_cast<uint32_t>(buffered), sequence});
     }
 
-    // 创建新的数据块并拷贝数据
-    std::vector<uint8_t> buffer(data, data + size);
-    audioQueue.push(std::move(buffer));
+    // 只有回调线程写入最大耗时，不需要CAS
+    auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                       std::chrono::steady_clock::now() - start)
+                       .count();
+    callbackHistogram.record(static_cast<uint64_t>(elapsed));
+    uint64_t elapsedUs = static_cast<uint64_t>(elapsed) / 1000;
+    if (elapsedUs > maxCallbackUs.load(std::memory_order_relaxed)) {
+        maxCallbackUs.store(elapsedUs, std::memory_order_relaxed);
+    }
+    if (elapsedUs > slowCallbackUs) {
+        callbackEvents.push({AudioEvent::Type::SLOW_CALLBACK,
+                             static_cast<uint32_t>(elapsedUs), sequence});
+    }
+}
 
-    return true;
+// 从环形缓冲区取出最多size字节（按采样帧对齐）写入stream，返回写入的字节数
+size_t AudioPlayer::mixFromRing(Uint8 *stream, size_t size) {
+    if (frameBytes > 0) {
+        size -= size % frameBytes;
+    }
+    SpscRingBuffer::Span spans[2];
+    size_t copied = ringBuffer.peek(size, spans[0], spans[1]);
+    if (copied == 0) {
+        return 0;
+    }
+
+    // 增益在本块内从上一块结束时的值线性变化到目标值，音量和曲目增益的
+    // 改变不会产生阶跃；欠载后的第一段数据从静音淡入。曲目增益在回调开始
+    // 时按时钟标记切换，无缝切换的曲目交界处最多晚一个设备周期
+    float gain = static_cast<float>(volume.load(std::memory_order_relaxed)) /
+                 SDL_MIX_MAXVOLUME * clockBase.gain;
+    float startGain =
+        underrun.load(std::memory_order_relaxed) ? 0.0f : appliedGain;
+    appliedGain = gain;
+    Uint8 *out = stream;
+    for (const auto &span : spans) {
+        if (span.size == 0) {
+            break;
+        }
+        if (startGain != gain) {
+            float delta = gain - startGain;
+            float start = startGain + delta * (out - stream) / copied;
+            float end =
+                startGain + delta * (out - stream + span.size) / copied;
+            mixSpan(span.data, out, span.size, start, end);
+        } else if (gain == 1.0f) {
+            std::memcpy(out, span.data, span.size);
+        } else {
+            mixSpan(span.data, out, span.size, gain, gain);
+        }
+        out += span.size;
+    }
+    ringBuffer.consume(copied);
+    return copied;
 }
 
-bool AudioPlayer::initResampler() {
-    if (!decoder) {
-        _logger->error("Decoder is not initialized");
-        return false;
+// 监控线程：定期取出回调事件写入日志，日志的格式化和文件IO不会阻塞回调
+void AudioPlayer::monitorLoop() {
+    uint64_t reportedDrops = 0;
+    std::unique_lock<std::mutex> lock(monitorMutex);
+    while (isMonitorRunning) {
+        monitorWakeup.wait_for(
+            lock, std::chrono::milliseconds(MONITOR_INTERVAL_MS),
+            [this]() { return !isMonitorRunning; });
+        lock.unlock();
+        drainCallbackEvents();
+        adaptBuffer();
+        uint64_t drops = callbackEvents.getDroppedCount();
+        if (drops != reportedDrops) {
+            _logger->warn("{} audio callback events dropped",
+                          drops - reportedDrops);
+            reportedDrops = drops;
+        }
+        lock.lock();
     }
+}
 
-    if (swrContext) {
-        swr_free(&swrContext);
+void AudioPlayer::drainCallbackEvents() {
+    AudioEvent event;
+    while (callbackEvents.pop(event)) {
+        switch (event.type) {
+            case AudioEvent::Type::UNDERRUN:
+                _logger->warn(
+                    "Audio buffer underrun at callback {}: {} bytes of "
+                    "silence ({} total)",
+                    event.sequence, event.value,
+                    underrunCount.load(std::memory_order_relaxed));
+                break;
+            case AudioEvent::Type::FILL_LEVEL:
+                TEXAS_LOG_DEBUG(
+                    _logger, "Ring buffer fill: {} bytes ({:.1f} ms)",
+                    event.value,
+                    event.value * 1000.0 / frameBytes / deviceSampleRate);
+                break;
+            case AudioEvent::Type::SLOW_CALLBACK:
+                _logger->warn("Audio callback {} took {} us", event.sequence,
+                              event.value);
+                break;
+        }
     }
+}
 
-    // 创建重采样上下文
-    swrContext = swr_alloc();
-    if (!swrContext) {
-        _logger->error("Could not allocate resampler context");
-        return false;
+void AudioPlayer::startMonitor() {
+    if (monitorThread.joinable()) {
+        return;
+    }
+    // 约每秒报告一次水位；回调耗时超过半个设备周期视为过慢
+    fillReportInterval =
+        deviceBufferSamples > 0
+            ? std::max<uint64_t>(1, deviceSampleRate / deviceBufferSamples)
+            : 0;
+    slowCallbackUs =
+        deviceSampleRate > 0
+            ? static_cast<uint64_t>(deviceBufferSamples) * 500000 /
+                  deviceSampleRate
+            : 0;
+    isMonitorRunning = true;
+    monitorThread = std::thread(&AudioPlayer::monitorLoop, this);
+}
+
+void AudioPlayer::stopMonitor() {
+    {
+        std::lock_guard<std::mutex> lock(monitorMutex);
+        isMonitorRunning = false;
     }
+    monitorWakeup.notify_all();
+    if (monitorThread.joinable()) {
+        monitorThread.join();
+    }
+    // 回调已停止，剩余事件在这里补记
+    drainCallbackEvents();
+}
 
-    // 获取输入通道数和采样格式
-    int in_channels = decoder->getChannels();
-    int in_sample_rate = decoder->getSampleRate();
-    AVSampleFormat in_sample_fmt = decoder->getSampleFormat();
+PlayerStats AudioPlayer::getStats() const {
+    PlayerStats stats;
+    stats.decode = decodeHistogram.summarize();
+    stats.resample = resampleHistogram.summarize();
+    stats.callback = callbackHistogram.summarize();
+    stats.open = openHistogram.summarize();
+    stats.firstAudio = firstAudioHistogram.summarize();
 
-    // 创建输入和输出通道布局
-    AVChannelLayout in_ch_layout = AV_CHANNEL_LAYOUT_STEREO;
-    AVChannelLayout out_ch_layout = AV_CHANNEL_LAYOUT_STEREO;
+    AudioCallbackStats callbackStats = getCallbackStats();
+    stats.callbacks = callbackStats.callbacks;
+    stats.underruns = callbackStats.underruns;
+    stats.droppedEvents = callbackStats.droppedEvents;
 
-    if (in_channels == 1) {
-        in_ch_layout = AV_CHANNEL_LAYOUT_MONO;
+    {
+        std::lock_guard<std::mutex> lock(decoderMutex);
+        if (decoder) {
+            stats.decoderQueueFrames = decoder->getQueueSize();
+            stats.decoderQueueHighWater = decoder->getQueueHighWater();
+            PrefetchStats prefetch = decoder->getPrefetchStats();
+            stats.prefetchActive = prefetch.active;
+            stats.prefetchBuffering = prefetch.buffering;
+            stats.prefetchBytes = prefetch.bytes;
+            stats.prefetchMs = prefetch.bufferedMs;
+            stats.prefetchRebuffers = prefetch.rebuffers;
+            stats.prefetchReconnects = prefetch.reconnects;
+        }
     }
 
-    _logger->debug("Initializing resampler:");
-    _logger->debug("Input: channels={}, rate={}, format={}", in_channels,
-                   in_sample_rate, av_get_sample_fmt_name(in_sample_fmt));
+    stats.bufferedBytes = ringBuffer.readAvailable();
+    stats.bufferHighWaterBytes =
+        bufferHighWater.load(std::memory_order_relaxed);
+    stats.bufferCapacityBytes = ringBuffer.capacity();
+    {
+        std::lock_guard<std::mutex> lock(bufferControlMutex);
+        BufferControllerStats control = bufferController.getStats();
+        stats.bufferTargetMs = control.targetMs;
+        stats.bufferGrowths = control.growths;
+        stats.bufferShrinks = control.shrinks;
+    }
+    stats.producerWakeups = producerWakeups.load(std::memory_order_relaxed);
+    stats.bufferedMs = getOutputLatency().bufferedMs;
+    return stats;
+}
 
-    // 设置输入参数 - 注意这里修改了调用方式
-    int ret = swr_alloc_set_opts2(&swrContext,
-                                  &out_ch_layout,     // 输出通道布局
-                                  AV_SAMPLE_FMT_S16,  // 输出采样格式
-                                  deviceSampleRate,   // 输出采样率
-                                  &in_ch_layout,      // 输入通道布局
-                                  in_sample_fmt,      // 输入采样格式
-                                  in_sample_rate,     // 输入采样率
-                                  0,                  // 日志偏移
-                                  nullptr             // 日志上下文
-    );
+AudioCallbackStats AudioPlayer::getCallbackStats() const {
+    AudioCallbackStats stats;
+    stats.callbacks = callbackCount.load(std::memory_order_relaxed);
+    stats.underruns = underrunCount.load(std::memory_order_relaxed);
+    stats.maxCallbackUs = maxCallbackUs.load(std::memory_order_relaxed);
+    stats.droppedEvents = callbackEvents.getDroppedCount();
+    return stats;
+}
+
+// 按输出格式调用增益内核，startGain与endGain不同时按采样帧线性渐变
+void AudioPlayer::mixSpan(const uint8_t *in, uint8_t *out, size_t size,
+                          float startGain, float endGain) {
+    size_t frames = size / frameBytes;
+    if (isFloatOutput()) {
+        const float *src = reinterpret_cast<const float *>(in);
+        float *dst = reinterpret_cast<float *>(out);
+        if (startGain == endGain) {
+            kernels.gainF32(src, dst, frames * deviceChannels, startGain);
+        } else {
+            kernels.rampF32(src, dst, frames, deviceChannels, startGain,
+                            endGain);
+        }
+    } else {
+        const int16_t *src = reinterpret_cast<const int16_t *>(in);
+        int16_t *dst = reinterpret_cast<int16_t *>(out);
+        if (startGain == endGain) {
+            kernels.gainS16(src, dst, frames * deviceChannels, startGain);
+        } else {
+            kernels.rampS16(src, dst, frames, deviceChannels, startGain,
+                            endGain);
+        }
+    }
+}
 
-    if (ret < 0) {
-        char errbuf[AV_ERROR_MAX_STRING_SIZE];
-        av_strerror(ret, errbuf, AV_ERROR_MAX_STRING_SIZE);
-        _logger->error("Could not allocate resampler context: {}", errbuf);
+bool AudioPlayer::initResampler() {
+    if (!decoder) {
+        _logger->error("Decoder is not initialized");
         return false;
     }
 
-    // 初始化重采样器
-    ret = swr_init(swrContext);
-    if (ret < 0) {
-        char errbuf[AV_ERROR_MAX_STRING_SIZE];
-        av_strerror(ret, errbuf, AV_ERROR_MAX_STRING_SIZE);
-        _logger->error("Failed to initialize resampler: {}", errbuf);
+    AudioOutputFormat output = deviceOutputFormat();
+    if (!resampler.init(*decoder, output)) {
         return false;
     }
 
-    _logger->info("Resampler initialized successfully");
+    // 重采样输出块池，整个会话期间复用
+    frameBytes = output.bytesPerFrame();
+    pcmPool.reset(PCM_BLOCK_SAMPLES * frameBytes, PCM_POOL_BLOCKS);
     return true;
 }
+
+AudioOutputFormat AudioPlayer::deviceOutputFormat() const {
+    AudioOutputFormat output;
+    output.sampleRate = deviceSampleRate;
+    output.channels = deviceChannels;
+    output.sampleFormat = outputSampleFormat;
+    return output;
+}
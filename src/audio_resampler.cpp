@@ -0,0 +1,260 @@
+#include "audio_resampler.h"
+
+#include <algorithm>
+#include <cstring>
+#include <string>
+
+#include "audio_decoder.h"
+#include "audio_kernels.h"
+#include "logger.h"
+
+namespace {
+
+// 后环绕和侧环绕在5.1/7.1的不同写法里指同一对扬声器，交换只是改名字
+AVChannel surroundSlot(AVChannel channel) {
+    switch (channel) {
+        case AV_CHAN_BACK_LEFT:
+            return AV_CHAN_SIDE_LEFT;
+        case AV_CHAN_BACK_RIGHT:
+            return AV_CHAN_SIDE_RIGHT;
+        default:
+            return channel;
+    }
+}
+
+// 两个布局的声道一一对应同一位置的扬声器时，数据不需要重混就能直接输出
+bool hasSameSpeakerOrder(const AVChannelLayout &in,
+                         const AVChannelLayout &out) {
+    if (in.nb_channels != out.nb_channels) {
+        return false;
+    }
+    if (av_channel_layout_compare(&in, &out) == 0) {
+        return true;
+    }
+    // 7.1中后环绕与侧环绕同时存在，两者不能互换
+    bool inHasBoth = av_channel_layout_index_from_channel(
+                         &in, AV_CHAN_BACK_LEFT) >= 0 &&
+                     av_channel_layout_index_from_channel(
+                         &in, AV_CHAN_SIDE_LEFT) >= 0;
+    if (inHasBoth) {
+        return false;
+    }
+    for (int i = 0; i < in.nb_channels; i++) {
+        AVChannel a = av_channel_layout_channel_from_index(&in, i);
+        AVChannel b = av_channel_layout_channel_from_index(&out, i);
+        if (a == AV_CHAN_NONE || surroundSlot(a) != surroundSlot(b)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+std::string describeLayout(const AVChannelLayout &layout) {
+    char name[64];
+    if (av_channel_layout_describe(&layout, name, sizeof(name)) < 0) {
+        return std::to_string(layout.nb_channels) + " channels";
+    }
+    return name;
+}
+
+}  // namespace
+
+void sdlChannelLayout(int channels, AVChannelLayout *layout) {
+    static const uint64_t masks[] = {
+        AV_CH_LAYOUT_MONO,
+        AV_CH_LAYOUT_STEREO,
+        AV_CH_LAYOUT_2POINT1,
+        AV_CH_LAYOUT_QUAD,
+        AV_CH_LAYOUT_QUAD | AV_CH_LOW_FREQUENCY,
+        AV_CH_LAYOUT_5POINT1,
+        AV_CH_LAYOUT_6POINT1,
+        AV_CH_LAYOUT_7POINT1,
+    };
+    constexpr int count = static_cast<int>(sizeof(masks) / sizeof(masks[0]));
+    if (channels >= 1 && channels <= count) {
+        av_channel_layout_from_mask(layout, masks[channels - 1]);
+    } else {
+        av_channel_layout_default(layout, channels);
+    }
+}
+
+AudioResampler::AudioResampler() {
+    _logger = Logger::getInstance().getLogger("AudioResampler");
+}
+
+AudioResampler::~AudioResampler() { reset(); }
+
+void AudioResampler::reset() {
+    if (swrContext) {
+        swr_free(&swrContext);
+        swrContext = nullptr;
+    }
+    mode = Mode::RESAMPLE;
+    remixing = false;
+    pendingInput = nullptr;
+    pendingOffset = 0;
+    pendingSamples = 0;
+}
+
+bool AudioResampler::init(const AudioDecoder &decoder,
+                          const AudioOutputFormat &output) {
+    return init(decoder.getSampleRate(), decoder.getChannels(),
+                decoder.getSampleFormat(), output,
+                decoder.getChannelLayoutInfo());
+}
+
+bool AudioResampler::init(int in_sample_rate, int in_channels,
+                          AVSampleFormat in_sample_fmt,
+                          const AudioOutputFormat &output,
+                          const AVChannelLayout *inputLayout) {
+    reset();
+    outputFormat = output;
+
+    // 输入布局缺失或只有声道数时按默认布局理解
+    AVChannelLayout in_ch_layout{};
+    if (inputLayout && inputLayout->order != AV_CHANNEL_ORDER_UNSPEC &&
+        inputLayout->nb_channels == in_channels &&
+        av_channel_layout_check(inputLayout)) {
+        av_channel_layout_copy(&in_ch_layout, inputLayout);
+    } else {
+        av_channel_layout_default(&in_ch_layout, in_channels);
+    }
+    AVChannelLayout out_ch_layout{};
+    sdlChannelLayout(output.channels, &out_ch_layout);
+
+    // 扬声器顺序相同时按输出布局交给SwrContext，只转换采样率和格式
+    remixing = !hasSameSpeakerOrder(in_ch_layout, out_ch_layout);
+    if (!remixing) {
+        av_channel_layout_uninit(&in_ch_layout);
+        av_channel_layout_copy(&in_ch_layout, &out_ch_layout);
+    }
+
+    // 格式完全相同时转换只是一次拷贝，不需要SwrContext
+    bool sameLayout = in_sample_rate == output.sampleRate && !remixing;
+    if (sameLayout && in_sample_fmt == output.sampleFormat) {
+        mode = Mode::PASS_THROUGH;
+        _logger->info("Input matches output ({} Hz, {}, {}), pass-through",
+                      output.sampleRate, describeLayout(out_ch_layout),
+                      av_get_sample_fmt_name(output.sampleFormat));
+        av_channel_layout_uninit(&in_ch_layout);
+        av_channel_layout_uninit(&out_ch_layout);
+        return true;
+    }
+    if (sameLayout && in_sample_fmt == AV_SAMPLE_FMT_FLTP &&
+        output.sampleFormat == AV_SAMPLE_FMT_FLT) {
+        mode = Mode::INTERLEAVE;
+        planes.assign(output.channels, nullptr);
+        _logger->info("Planar float input, interleaving with {} kernels",
+                      AudioKernels::get().name);
+        av_channel_layout_uninit(&in_ch_layout);
+        av_channel_layout_uninit(&out_ch_layout);
+        return true;
+    }
+    if (remixing) {
+        _logger->info("Remixing {} to {}", describeLayout(in_ch_layout),
+                      describeLayout(out_ch_layout));
+    }
+
+    // 创建重采样上下文
+    swrContext = swr_alloc();
+    if (!swrContext) {
+        _logger->error("Could not allocate resampler context");
+        av_channel_layout_uninit(&in_ch_layout);
+        av_channel_layout_uninit(&out_ch_layout);
+        return false;
+    }
+
+    _logger->debug("Initializing resampler:");
+    _logger->debug("Input: channels={}, rate={}, format={}", in_channels,
+                   in_sample_rate, av_get_sample_fmt_name(in_sample_fmt));
+    _logger->debug("Output: channels={}, rate={}, format={}", output.channels,
+                   output.sampleRate,
+                   av_get_sample_fmt_name(output.sampleFormat));
+
+    // 设置输入参数 - 注意这里修改了调用方式
+    int ret = swr_alloc_set_opts2(&swrContext,
+                                  &out_ch_layout,       // 输出通道布局
+                                  output.sampleFormat,  // 输出采样格式
+                                  output.sampleRate,    // 输出采样率
+                                  &in_ch_layout,        // 输入通道布局
+                                  in_sample_fmt,        // 输入采样格式
+                                  in_sample_rate,       // 输入采样率
+                                  0,                    // 日志偏移
+                                  nullptr               // 日志上下文
+    );
+    av_channel_layout_uninit(&in_ch_layout);
+    av_channel_layout_uninit(&out_ch_layout);
+
+    if (ret < 0) {
+        char errbuf[AV_ERROR_MAX_STRING_SIZE];
+        av_strerror(ret, errbuf, AV_ERROR_MAX_STRING_SIZE);
+        _logger->error("Could not allocate resampler context: {}", errbuf);
+        reset();
+        return false;
+    }
+
+    // 初始化重采样器
+    ret = swr_init(swrContext);
+    if (ret < 0) {
+        char errbuf[AV_ERROR_MAX_STRING_SIZE];
+        av_strerror(ret, errbuf, AV_ERROR_MAX_STRING_SIZE);
+        _logger->error("Failed to initialize resampler: {}", errbuf);
+        reset();
+        return false;
+    }
+
+    _logger->info("Resampler initialized successfully");
+    return true;
+}
+
+int AudioResampler::convert(const uint8_t **input, int inputSamples,
+                            uint8_t *output, int outputCapacity) {
+    if (mode != Mode::RESAMPLE) {
+        return copyThrough(input, inputSamples, output, outputCapacity);
+    }
+    if (!swrContext) {
+        return AVERROR(EINVAL);
+    }
+    uint8_t *output_buffer[1] = {output};
+    return swr_convert(swrContext, output_buffer, outputCapacity, input,
+                       inputSamples);
+}
+
+// 直通模式直接拷贝交错数据，交错模式把各声道平面交错写入输出
+int AudioResampler::copyThrough(const uint8_t **input, int inputSamples,
+                                uint8_t *output, int outputCapacity) {
+    if (!input) {
+        pendingInput = nullptr;
+        pendingSamples = 0;
+        return 0;
+    }
+    if (inputSamples > 0) {
+        pendingInput = input;
+        pendingOffset = 0;
+        pendingSamples = inputSamples;
+    }
+
+    int samples = std::min(pendingSamples, outputCapacity);
+    if (samples <= 0) {
+        return 0;
+    }
+    if (mode == Mode::PASS_THROUGH) {
+        size_t frameSize = outputFormat.bytesPerFrame();
+        std::memcpy(output, pendingInput[0] + pendingOffset * frameSize,
+                    samples * frameSize);
+    } else {
+        for (int c = 0; c < outputFormat.channels; c++) {
+            planes[c] = reinterpret_cast<const float *>(pendingInput[c]);
+        }
+        AudioKernels::get().interleaveF32(
+            planes.data(), pendingOffset, outputFormat.channels, samples, 1.0f,
+            reinterpret_cast<float *>(output));
+    }
+    pendingOffset += samples;
+    pendingSamples -= samples;
+    return samples;
+}
+
+int64_t AudioResampler::getDelay(int64_t base) const {
+    return swrContext ? swr_get_delay(swrContext, base) : 0;
+}
@@ -0,0 +1,199 @@
+#include "batch_decoder.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <memory>
+#include <mutex>
+
+#include "audio_decoder.h"
+#include "audio_kernels.h"
+#include "audio_resampler.h"
+#include "logger.h"
+#include "thread_pool.h"
+
+namespace {
+constexpr int OUTPUT_BLOCK_SAMPLES = 4096;  // 每次重采样输出的采样帧数
+
+// 工作线程私有的解码资源，在线程池生命周期内复用
+struct WorkerContext {
+    AudioDecoder decoder;
+    AudioResampler resampler;
+    AudioDecoder::FramePtr frame{av_frame_alloc()};
+    std::vector<float> output;
+
+    explicit WorkerContext(const AudioDecoderConfig &decoderConfig)
+        : decoder(decoderConfig) {}
+};
+
+// 重采样一批输入并统计峰值和响度，返回输出的采样帧数，负值为错误
+int64_t resampleAndMeasure(WorkerContext &ctx, const uint8_t **input,
+                           int inputSamples, int channels,
+                           LoudnessMeter *meter, BatchFileResult &result) {
+    const AudioKernels &kernels = AudioKernels::get();
+    int blockSamples = OUTPUT_BLOCK_SAMPLES;
+    int64_t total = 0;
+    uint8_t *out = reinterpret_cast<uint8_t *>(ctx.output.data());
+
+    while (true) {
+        int converted =
+            ctx.resampler.convert(input, inputSamples, out, blockSamples);
+        if (converted < 0) {
+            return converted;
+        }
+        // 输入已交给重采样器，后续调用只取出缓存的样本
+        inputSamples = 0;
+        total += converted;
+        // 响度计本身统计采样峰值，有响度计时结束后从它的结果中取
+        if (meter) {
+            meter->process(ctx.output.data(), converted);
+        } else {
+            double sumSquares = 0.0;
+            kernels.peakF32(ctx.output.data(),
+                            static_cast<size_t>(converted) * channels,
+                            &result.peak, &sumSquares);
+        }
+        if (converted < blockSamples) {
+            return total;
+        }
+    }
+}
+
+void decodeFile(WorkerContext &ctx, const BatchDecoderConfig &config,
+                BatchFileResult &result) {
+    auto error = ctx.decoder.open(result.filename);
+    if (error != AudioDecoderError::SUCCESS) {
+        result.error = audioDecoderErrorString(error);
+        return;
+    }
+    result.containerDuration = ctx.decoder.getDuration();
+
+    AudioOutputFormat output;
+    output.sampleRate = config.outputSampleRate > 0
+                            ? config.outputSampleRate
+                            : ctx.decoder.getSampleRate();
+    output.channels = config.outputChannels > 0 ? config.outputChannels
+                                                : ctx.decoder.getChannels();
+    output.sampleFormat = AV_SAMPLE_FMT_FLT;
+    if (!ctx.resampler.init(ctx.decoder, output)) {
+        result.error = "could not initialize resampler";
+        return;
+    }
+    result.sampleRate = output.sampleRate;
+    result.channels = output.channels;
+
+    // 分析与解码在同一遍完成，不需要为响度再解码一次
+    std::unique_ptr<LoudnessMeter> meter;
+    if (config.analyzeLoudness) {
+        meter = std::make_unique<LoudnessMeter>(output.sampleRate,
+                                                output.channels);
+    }
+
+    size_t needed = static_cast<size_t>(OUTPUT_BLOCK_SAMPLES) * output.channels;
+    if (ctx.output.size() < needed) {
+        ctx.output.resize(needed);
+    }
+
+    while (true) {
+        int ret = ctx.decoder.decodeNextFrame(ctx.frame.get());
+        if (ret == AVERROR_EOF) {
+            break;
+        }
+        if (ret < 0) {
+            result.error = "decode error";
+            break;
+        }
+
+        int64_t out = resampleAndMeasure(
+            ctx, (const uint8_t **)ctx.frame->extended_data,
+            ctx.frame->nb_samples, output.channels, meter.get(), result);
+        av_frame_unref(ctx.frame.get());
+        if (out < 0) {
+            result.error = "resample error";
+            break;
+        }
+        result.samples += out;
+    }
+
+    if (result.error.empty()) {
+        int64_t out = resampleAndMeasure(ctx, nullptr, 0, output.channels,
+                                         meter.get(), result);
+        if (out > 0) {
+            result.samples += out;
+        }
+        result.success = true;
+    }
+    result.duration = static_cast<double>(result.samples) / output.sampleRate;
+    if (meter) {
+        result.loudness = meter->result();
+        if (std::isfinite(result.loudness.samplePeakDb)) {
+            result.peak = static_cast<float>(
+                std::pow(10.0, result.loudness.samplePeakDb / 20.0));
+        }
+    }
+    ctx.decoder.close();
+}
+}  // namespace
+
+BatchDecoder::BatchDecoder(const BatchDecoderConfig &config)
+    : config(config) {}
+
+BatchSummary BatchDecoder::run(const std::vector<std::string> &files,
+                               const ResultCallback &onResult) {
+    auto logger = Logger::getInstance().getLogger("BatchDecoder");
+    BatchSummary summary;
+    summary.files = files.size();
+
+    WorkStealingThreadPool pool(config.threadCount);
+
+    // 在调用线程上创建各工作线程的解码资源，工作线程之间不共享
+    AudioDecoderConfig decoderConfig;
+    decoderConfig.maxQueueSize = 1;  // 同步解码不使用帧队列
+    std::vector<std::unique_ptr<WorkerContext>> contexts;
+    for (size_t i = 0; i < pool.getThreadCount(); i++) {
+        contexts.push_back(std::make_unique<WorkerContext>(decoderConfig));
+    }
+
+    std::mutex resultMutex;
+    auto start = std::chrono::steady_clock::now();
+
+    for (const auto &file : files) {
+        pool.submit([&, file](size_t workerIndex) {
+            BatchFileResult result;
+            result.filename = file;
+
+            auto fileStart = std::chrono::steady_clock::now();
+            decodeFile(*contexts[workerIndex], config, result);
+            result.decodeSeconds = std::chrono::duration<double>(
+                                       std::chrono::steady_clock::now() -
+                                       fileStart)
+                                       .count();
+
+            std::lock_guard<std::mutex> lock(resultMutex);
+            if (!result.success) {
+                summary.failed++;
+                logger->warn("Batch decode failed: {} - {}", result.filename,
+                             result.error);
+            }
+            summary.audioSeconds += result.duration;
+            if (onResult) {
+                onResult(result);
+            }
+        });
+    }
+    pool.wait();
+
+    summary.wallSeconds = std::chrono::duration<double>(
+                              std::chrono::steady_clock::now() - start)
+                              .count();
+    summary.realtimeFactor = summary.wallSeconds > 0.0
+                                 ? summary.audioSeconds / summary.wallSeconds
+                                 : 0.0;
+
+    logger->info(
+        "Batch decoded {} files ({} failed) with {} threads: {:.1f}s of "
+        "audio in {:.2f}s ({:.1f}x realtime)",
+        summary.files, summary.failed, pool.getThreadCount(),
+        summary.audioSeconds, summary.wallSeconds, summary.realtimeFactor);
+    return summary;
+}
@@ -0,0 +1,113 @@
+#include "frame_pool.h"
+
+AVFramePool::AVFramePool(size_t initialFrames) {
+    idleFrames.reserve(initialFrames);
+    for (size_t i = 0; i < initialFrames; i++) {
+        AVFrame *frame = av_frame_alloc();
+        if (!frame) {
+            break;
+        }
+        idleFrames.push_back(frame);
+        totalFrames++;
+    }
+    allocations += totalFrames;
+}
+
+AVFramePool::~AVFramePool() {
+    std::lock_guard<std::mutex> lock(poolMutex);
+    for (AVFrame *frame : idleFrames) {
+        av_frame_free(&frame);
+    }
+    idleFrames.clear();
+}
+
+AVFrame *AVFramePool::acquire() {
+    {
+        std::lock_guard<std::mutex> lock(poolMutex);
+        if (!idleFrames.empty()) {
+            AVFrame *frame = idleFrames.back();
+            idleFrames.pop_back();
+            return frame;
+        }
+    }
+
+    AVFrame *frame = av_frame_alloc();
+    if (frame) {
+        std::lock_guard<std::mutex> lock(poolMutex);
+        totalFrames++;
+        // 提前扩容空闲列表，保证release时不再分配内存
+        idleFrames.reserve(totalFrames);
+        allocations++;
+    }
+    return frame;
+}
+
+void AVFramePool::release(AVFrame *frame) {
+    if (!frame) {
+        return;
+    }
+    av_frame_unref(frame);
+    std::lock_guard<std::mutex> lock(poolMutex);
+    idleFrames.push_back(frame);
+}
+
+size_t AVFramePool::getIdleCount() {
+    std::lock_guard<std::mutex> lock(poolMutex);
+    return idleFrames.size();
+}
+
+void PcmBlockReleaser::operator()(PcmBlock *block) const {
+    if (pool && block) {
+        pool->release(block);
+    }
+}
+
+PcmBlockPool::PcmBlockPool(size_t blockCapacity, size_t initialBlocks) {
+    reset(blockCapacity, initialBlocks);
+}
+
+void PcmBlockPool::reset(size_t capacity, size_t initialBlocks) {
+    std::lock_guard<std::mutex> lock(poolMutex);
+    if (capacity == blockCapacity && blocks.size() >= initialBlocks) {
+        return;
+    }
+
+    blocks.clear();
+    idleBlocks.clear();
+    blockCapacity = capacity;
+    blocks.reserve(initialBlocks);
+    idleBlocks.reserve(initialBlocks);
+    for (size_t i = 0; i < initialBlocks; i++) {
+        idleBlocks.push_back(allocateBlock());
+    }
+}
+
+PcmBlock *PcmBlockPool::allocateBlock() {
+    auto block = std::make_unique<PcmBlock>();
+    block->data.reset(new uint8_t[blockCapacity]);
+    block->capacity = blockCapacity;
+    blocks.push_back(std::move(block));
+    allocations++;
+    return blocks.back().get();
+}
+
+PcmBlockPool::BlockPtr PcmBlockPool::acquire() {
+    std::lock_guard<std::mutex> lock(poolMutex);
+    PcmBlock *block;
+    if (!idleBlocks.empty()) {
+        block = idleBlocks.back();
+        idleBlocks.pop_back();
+    } else {
+        block = allocateBlock();
+        idleBlocks.reserve(blocks.size());
+    }
+
+    block->size = 0;
+    block->readOffset = 0;
+    return BlockPtr(block, PcmBlockReleaser{this});
+}
+
+void PcmBlockPool::release(PcmBlock *block) {
+    std::lock_guard<std::mutex> lock(poolMutex);
+    idleBlocks.push_back(block);
+}
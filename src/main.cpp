@@ -1,9 +1,19 @@
+#include <cerrno>
+#include <cmath>
+#include <cstdlib>
 #include <iostream>
+#include <limits>
+#include <mutex>
+#include <sstream>
 #include <string>
 #include <thread>
 #include <chrono>
+#include <vector>
 
 #include "audio_player.h"
+#include "batch_decoder.h"
+#include "media_info_cache.h"
+#include "player_controller.h"
 #include "logger.h"
 
 // 显示菜单选项
@@ -48,16 +58,231 @@ void showPlayerStatus(AudioPlayer &player)
     std::cout << "音量: " << player.getVolume() << " (0-128)" << std::endl;
     std::cout << "采样率: " << player.getSampleRate() << " Hz" << std::endl;
     std::cout << "声道数: " << player.getChannels() << std::endl;
+    OutputLatency latency = player.getOutputLatency();
+    std::cout << "输出延迟: " << latency.totalMs << " ms (缓冲 "
+              << latency.bufferedMs << " ms + 设备 " << latency.deviceMs
+              << " ms)" << std::endl;
     std::cout << "----------------------\n";
 }
 
-int main()
+// 命令行参数格式不对时显示用法
+void printUsage()
+{
+    std::cerr << "用法: texas [--latency 毫秒]\n"
+                 "      texas --render <输入文件> [输出WAV文件]\n"
+                 "      texas --batch <线程数，0为CPU核心数> <文件...>\n"
+                 "      texas --scan <缓存文件> <文件...>\n"
+                 "      texas --daemon [目标延迟毫秒]\n";
+}
+
+// 把整个字符串解析为不小于minValue的int，有多余字符或越界时返回false
+bool parseInteger(const std::string &text, int minValue, int &value)
+{
+    errno = 0;
+    char *end = nullptr;
+    long parsed = std::strtol(text.c_str(), &end, 10);
+    if (text.empty() || *end != '\0' || errno == ERANGE ||
+        parsed < minValue || parsed > std::numeric_limits<int>::max())
+    {
+        return false;
+    }
+    value = static_cast<int>(parsed);
+    return true;
+}
+
+// 把整个字符串解析为有限的非负浮点数
+bool parseSeconds(const std::string &text, double &value)
+{
+    errno = 0;
+    char *end = nullptr;
+    double parsed = std::strtod(text.c_str(), &end);
+    if (text.empty() || *end != '\0' || errno == ERANGE ||
+        !std::isfinite(parsed) || parsed < 0.0)
+    {
+        return false;
+    }
+    value = parsed;
+    return true;
+}
+
+// 无设备模式：尽可能快地解码并重采样，可选写入WAV文件
+int runRender(const std::string &inputFile, const std::string &outputFile)
+{
+    AudioPlayerConfig pconfig;
+    pconfig.headless = true;
+    pconfig.outputFile = outputFile;
+    pconfig.analyzeLoudness = true;
+
+    AudioPlayer player(pconfig);
+    if (!player.loadFile(inputFile))
+    {
+        std::cerr << "文件加载失败: " << inputFile << std::endl;
+        return 1;
+    }
+
+    RenderStats stats = player.render();
+    std::cout << "音频时长: " << stats.audioSeconds << " 秒, 耗时: "
+              << stats.wallSeconds << " 秒, 倍速: " << stats.realtimeFactor
+              << "x" << std::endl;
+    std::cout << "响度: " << stats.loudness.integratedLufs
+              << " LUFS, 响度范围: " << stats.loudness.loudnessRange
+              << " LU, 真峰值: " << stats.loudness.truePeakDb << " dBTP"
+              << std::endl;
+    return stats.success ? 0 : 1;
+}
+
+// 批量模式：多线程并行解码多个文件，每个文件完成时输出结果
+int runBatch(size_t threads, const std::vector<std::string> &files)
+{
+    BatchDecoderConfig bconfig;
+    bconfig.threadCount = threads;
+    bconfig.analyzeLoudness = true;
+
+    auto printResult = [](const BatchFileResult &result)
+    {
+        if (result.success)
+        {
+            std::cout << "[OK] " << result.filename << " 时长: "
+                      << result.duration << " 秒, 峰值: " << result.peak
+                      << ", 响度: " << result.loudness.integratedLufs
+                      << " LUFS, 真峰值: " << result.loudness.truePeakDb
+                      << " dBTP" << std::endl;
+        }
+        else
+        {
+            std::cout << "[FAIL] " << result.filename << ": "
+                      << result.error << std::endl;
+        }
+    };
+
+    BatchDecoder batch(bconfig);
+    BatchSummary summary = batch.run(files, printResult);
+
+    std::cout << "共 " << summary.files << " 个文件, 失败 " << summary.failed
+              << " 个, 倍速: " << summary.realtimeFactor << "x" << std::endl;
+    return summary.failed == 0 ? 0 : 1;
+}
+
+// 媒体库扫描：输出每个文件的参数，已缓存且未修改的文件不再打开
+int runScan(const std::string &cachePath,
+            const std::vector<std::string> &files)
+{
+    MediaInfoCache cache(cachePath);
+    size_t failed = 0;
+    for (const auto &file : files)
+    {
+        MediaInfo info;
+        if (!cache.probe(file, info))
+        {
+            std::cout << "[FAIL] " << file << std::endl;
+            failed++;
+            continue;
+        }
+        std::cout << file << " 时长: " << info.duration << " 秒, "
+                  << info.sampleRate << " Hz, " << info.channels << " 声道"
+                  << std::endl;
+    }
+    MediaInfoCacheStats stats = cache.getStats();
+    std::cout << "缓存命中 " << stats.hits << " 个, 新探测 " << stats.pending
+              << " 个" << std::endl;
+    return failed == 0 ? 0 : 1;
+}
+
+// 守护模式：从标准输入按行读取命令交给控制器，不等待命令完成；
+// 命令完成时输出"<编号> ok|fail"，status输出一行JSON
+int runDaemon(const AudioPlayerConfig &pconfig)
+{
+    PlayerController controller(pconfig);
+    std::mutex outputMutex;
+    auto reply = [&outputMutex](uint64_t id, bool success)
+    {
+        std::lock_guard<std::mutex> lock(outputMutex);
+        std::cout << id << (success ? " ok" : " fail") << std::endl;
+    };
+
+    std::string line;
+    while (std::getline(std::cin, line))
+    {
+        std::istringstream in(line);
+        std::string verb;
+        in >> verb;
+        std::string arg;
+        std::getline(in >> std::ws, arg);
+
+        PlayerCommand command{PlayerCommandType::PLAY};
+        if (verb == "load")
+            command = {PlayerCommandType::LOAD, arg};
+        else if (verb == "switch")
+            command = {PlayerCommandType::SWITCH, arg};
+        else if (verb == "enqueue")
+            command = {PlayerCommandType::ENQUEUE, arg};
+        else if (verb == "clear")
+            command = {PlayerCommandType::CLEAR_PLAYLIST};
+        else if (verb == "play")
+            command = {PlayerCommandType::PLAY};
+        else if (verb == "pause")
+            command = {PlayerCommandType::PAUSE};
+        else if (verb == "resume")
+            command = {PlayerCommandType::RESUME};
+        else if (verb == "stop")
+            command = {PlayerCommandType::STOP};
+        else if (verb == "seek" || verb == "volume")
+        {
+            bool valid = verb == "seek"
+                             ? parseSeconds(arg, command.seconds)
+                             : parseInteger(arg, 0, command.volume);
+            if (!valid)
+            {
+                std::lock_guard<std::mutex> lock(outputMutex);
+                std::cout << "0 invalid " << verb << std::endl;
+                continue;
+            }
+            command.type = verb == "seek" ? PlayerCommandType::SEEK
+                                          : PlayerCommandType::SET_VOLUME;
+        }
+        else if (verb == "status")
+        {
+            PlayerStatus status = controller.getStatus();
+            std::lock_guard<std::mutex> lock(outputMutex);
+            std::cout << "{\"state\":" << static_cast<int>(status.state)
+                      << ",\"position\":" << status.position
+                      << ",\"duration\":" << status.duration
+                      << ",\"volume\":" << status.volume
+                      << ",\"pending\":" << status.pendingCommands << "}"
+                      << std::endl;
+            continue;
+        }
+        else if (verb == "quit")
+            break;
+        else
+        {
+            if (!verb.empty())
+            {
+                std::lock_guard<std::mutex> lock(outputMutex);
+                std::cout << "0 unknown " << verb << std::endl;
+            }
+            continue;
+        }
+
+        uint64_t id = controller.post(command, reply);
+        if (id != 0)
+        {
+            std::lock_guard<std::mutex> lock(outputMutex);
+            std::cout << id << " queued" << std::endl;
+        }
+    }
+    controller.shutdown();
+    return 0;
+}
+
+int main(int argc, char *argv[])
 {
     // 配置日志系统
     Logger::LoggerConfig lconfig;
     lconfig.filename = "logs/app.log";
     lconfig.level = Logger::Level::DEBUG;
     lconfig.console_output = false;
+    lconfig.async_mode = true; // 解码线程不做文件IO
 
     // 初始化日志系统
     auto &logger = Logger::getInstance();
@@ -69,8 +294,56 @@ int main()
 
     logger.info("Application started");
 
+    // 命令行无设备模式: texas --render <输入文件> [输出WAV文件]
+    if (argc >= 3 && std::string(argv[1]) == "--render")
+    {
+        return runRender(argv[2], argc >= 4 ? argv[3] : "");
+    }
+
+    // 命令行批量模式: texas --batch <线程数，0为CPU核心数> <文件...>
+    if (argc >= 4 && std::string(argv[1]) == "--batch")
+    {
+        int threads = 0;
+        if (!parseInteger(argv[2], 0, threads))
+        {
+            printUsage();
+            return 2;
+        }
+        std::vector<std::string> files(argv + 3, argv + argc);
+        return runBatch(static_cast<size_t>(threads), files);
+    }
+
+    // 媒体库扫描: texas --scan <缓存文件> <文件...>
+    if (argc >= 4 && std::string(argv[1]) == "--scan")
+    {
+        std::vector<std::string> files(argv + 3, argv + argc);
+        return runScan(argv[2], files);
+    }
+
+    // 交互模式可指定目标输出延迟: texas --latency <毫秒>
+    AudioPlayerConfig pconfig;
+    if (argc >= 3 && std::string(argv[1]) == "--latency" &&
+        !parseInteger(argv[2], 0, pconfig.targetLatencyMs))
+    {
+        printUsage();
+        return 2;
+    }
+
+    // 守护模式: texas --daemon [目标延迟毫秒]
+    if (argc >= 2 && std::string(argv[1]) == "--daemon")
+    {
+        if (argc >= 3 && !parseInteger(argv[2], 0, pconfig.targetLatencyMs))
+        {
+            printUsage();
+            return 2;
+        }
+        int ret = runDaemon(pconfig);
+        logger.shutdown();
+        return ret;
+    }
+
     // 创建播放器实例
-    AudioPlayer player;
+    AudioPlayer player(pconfig);
     std::string currentFile;
     bool isRunning = true;
 
@@ -165,6 +438,7 @@ int main()
 
         case 8: // 显示当前状态
             showPlayerStatus(player);
+            logger.info("Player stats: {}", player.getStats().toJson());
             break;
 
         case 9: // 退出
@@ -184,5 +458,6 @@ int main()
     // 确保停止播放
     player.stop();
     logger.info("Application ended");
+    logger.shutdown();
     return 0;
 }
@@ -0,0 +1,410 @@
+#include "media_info_cache.h"
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <vector>
+
+#include "audio_decoder.h"
+#include "logger.h"
+
+namespace {
+constexpr char CACHE_MAGIC[4] = {'T', 'M', 'I', 'C'};
+constexpr uint32_t CACHE_VERSION = 1;
+constexpr size_t RECORD_ALIGN = 8;
+
+// 缓存文件布局：FileHeader，count个按哈希升序的Slot，之后是各条记录。
+// 记录为RecordHeader、路径（补齐到8字节）和seekCount个SeekIndex::Entry。
+// 只在本机使用，按本机字节序存储
+struct FileHeader {
+    char magic[4];
+    uint32_t version;
+    uint64_t count;
+};
+
+struct Slot {
+    uint64_t hash;
+    uint64_t offset;
+    uint64_t size;
+};
+
+struct RecordHeader {
+    uint64_t fileSize;
+    int64_t mtime;
+    uint64_t channelLayout;
+    int64_t bitRate;
+    double duration;
+    double trackGainDb;
+    int32_t sampleRate;
+    int32_t channels;
+    int32_t sampleFormat;
+    int32_t codecId;
+    int32_t streamIndex;
+    int32_t timeBaseNum;
+    int32_t timeBaseDen;
+    int32_t seekTimeBaseNum;
+    int32_t seekTimeBaseDen;
+    uint32_t pathLength;
+    uint64_t seekCount;
+};
+
+// FNV-1a
+uint64_t hashPath(const std::string &path) {
+    uint64_t hash = 14695981039346656037ull;
+    for (unsigned char c : path) {
+        hash = (hash ^ c) * 1099511628211ull;
+    }
+    return hash;
+}
+
+size_t alignedPathBytes(size_t length) {
+    return (length + RECORD_ALIGN - 1) / RECORD_ALIGN * RECORD_ALIGN;
+}
+
+// 写回时待写入的一条记录：未修改的记录直接引用映射中的字节
+struct Blob {
+    uint64_t hash;
+    const uint8_t *data;
+    size_t size;
+    std::vector<uint8_t> owned;
+};
+
+void serialize(const std::string &path, const FileIdentity &identity,
+               const MediaInfo &info, const SeekIndex *index,
+               std::vector<uint8_t> &out) {
+    RecordHeader header{};
+    header.fileSize = identity.size;
+    header.mtime = identity.mtime;
+    header.channelLayout = info.channelLayout;
+    header.bitRate = info.bitRate;
+    header.duration = info.duration;
+    header.trackGainDb = info.trackGainDb;
+    header.sampleRate = info.sampleRate;
+    header.channels = info.channels;
+    header.sampleFormat = info.sampleFormat;
+    header.codecId = info.codecId;
+    header.streamIndex = info.streamIndex;
+    header.timeBaseNum = info.timeBase.num;
+    header.timeBaseDen = info.timeBase.den;
+    if (index) {
+        header.seekTimeBaseNum = index->getTimeBase().num;
+        header.seekTimeBaseDen = index->getTimeBase().den;
+        header.seekCount = index->size();
+    }
+    header.pathLength = static_cast<uint32_t>(path.size());
+
+    size_t pathBytes = alignedPathBytes(path.size());
+    out.assign(sizeof(header) + pathBytes +
+                   header.seekCount * sizeof(SeekIndex::Entry),
+               0);
+    std::memcpy(out.data(), &header, sizeof(header));
+    std::memcpy(out.data() + sizeof(header), path.data(), path.size());
+    if (index) {
+        std::memcpy(out.data() + sizeof(header) + pathBytes,
+                    index->getEntries().data(),
+                    header.seekCount * sizeof(SeekIndex::Entry));
+    }
+}
+}  // namespace
+
+MediaInfoCache::MediaInfoCache(const std::string &cachePath)
+    : cachePath(cachePath) {
+    _logger = Logger::getInstance().getLogger("MediaInfoCache");
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    mapCache();
+}
+
+MediaInfoCache::~MediaInfoCache() {
+    if (!flush()) {
+        _logger->warn("Could not write media info cache: {}", cachePath);
+    }
+}
+
+// 映射缓存文件并检查文件头，不存在或格式不符时按空缓存处理
+void MediaInfoCache::mapCache() {
+    mapping = MediaInput::mapFile(cachePath);
+    mappedCount = 0;
+    if (!mapping) {
+        return;
+    }
+    FileHeader header;
+    if (mapping->size() < sizeof(header)) {
+        mapping.reset();
+        return;
+    }
+    std::memcpy(&header, mapping->data(), sizeof(header));
+    if (std::memcmp(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC)) != 0 ||
+        header.version != CACHE_VERSION ||
+        header.count > (mapping->size() - sizeof(header)) / sizeof(Slot)) {
+        _logger->warn("Ignoring invalid media info cache: {}", cachePath);
+        mapping.reset();
+        return;
+    }
+    mappedCount = header.count;
+    _logger->debug("Media info cache mapped: {} entries", mappedCount);
+}
+
+// 按哈希二分查找，再比较路径；记录越界时视为未命中
+bool MediaInfoCache::findMapped(const std::string &path, uint64_t hash,
+                                Record &record, bool withSeekIndex) const {
+    if (!mapping || mappedCount == 0) {
+        return false;
+    }
+    const uint8_t *base = mapping->data();
+    size_t size = mapping->size();
+    auto slotAt = [base](size_t i) {
+        Slot slot;
+        std::memcpy(&slot, base + sizeof(FileHeader) + i * sizeof(Slot),
+                    sizeof(slot));
+        return slot;
+    };
+
+    size_t low = 0;
+    size_t high = mappedCount;
+    while (low < high) {
+        size_t mid = low + (high - low) / 2;
+        if (slotAt(mid).hash < hash) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+
+    for (size_t i = low; i < mappedCount; i++) {
+        Slot slot = slotAt(i);
+        if (slot.hash != hash) {
+            break;
+        }
+        if (slot.offset > size || slot.size > size - slot.offset ||
+            slot.size < sizeof(RecordHeader)) {
+            continue;
+        }
+        RecordHeader header;
+        const uint8_t *data = base + slot.offset;
+        std::memcpy(&header, data, sizeof(header));
+        size_t pathBytes = alignedPathBytes(header.pathLength);
+        if (pathBytes > slot.size - sizeof(header) ||
+            header.pathLength != path.size() ||
+            std::memcmp(data + sizeof(header), path.data(), path.size()) !=
+                0) {
+            continue;
+        }
+
+        record.identity.size = header.fileSize;
+        record.identity.mtime = header.mtime;
+        MediaInfo &info = record.info;
+        info.sampleRate = header.sampleRate;
+        info.channels = header.channels;
+        info.channelLayout = header.channelLayout;
+        info.sampleFormat = static_cast<AVSampleFormat>(header.sampleFormat);
+        info.codecId = static_cast<AVCodecID>(header.codecId);
+        info.streamIndex = header.streamIndex;
+        info.timeBase = AVRational{header.timeBaseNum, header.timeBaseDen};
+        info.duration = header.duration;
+        info.bitRate = header.bitRate;
+        info.trackGainDb = header.trackGainDb;
+
+        record.seekIndex.reset();
+        size_t entriesBytes = slot.size - sizeof(header) - pathBytes;
+        if (withSeekIndex && header.seekCount > 0 &&
+            header.seekCount <= entriesBytes / sizeof(SeekIndex::Entry)) {
+            std::vector<SeekIndex::Entry> entries(header.seekCount);
+            std::memcpy(entries.data(), data + sizeof(header) + pathBytes,
+                        entries.size() * sizeof(SeekIndex::Entry));
+            record.seekIndex = SeekIndex::fromEntries(
+                std::move(entries),
+                AVRational{header.seekTimeBaseNum, header.seekTimeBaseDen},
+                header.streamIndex);
+        }
+        return true;
+    }
+    return false;
+}
+
+// 新条目优先于映射中的旧条目；文件身份不符时视为未命中
+bool MediaInfoCache::findRecord(const std::string &path,
+                                const FileIdentity &identity, Record &record,
+                                bool withSeekIndex) {
+    auto it = pending.find(path);
+    if (it != pending.end()) {
+        if (!(it->second.identity == identity)) {
+            return false;
+        }
+        record = it->second;
+        return true;
+    }
+    return findMapped(path, hashPath(path), record, withSeekIndex) &&
+           record.identity == identity;
+}
+
+bool MediaInfoCache::find(const std::string &path,
+                          const FileIdentity &identity, MediaInfo &info) {
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    Record record;
+    if (!findRecord(path, identity, record, false)) {
+        misses++;
+        return false;
+    }
+    hits++;
+    info = record.info;
+    return true;
+}
+
+std::shared_ptr<const SeekIndex> MediaInfoCache::findSeekIndex(
+    const std::string &path, const FileIdentity &identity, int streamIndex) {
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    Record record;
+    if (!findRecord(path, identity, record, true) || !record.seekIndex ||
+        record.seekIndex->getStreamIndex() != streamIndex) {
+        return nullptr;
+    }
+    return record.seekIndex;
+}
+
+void MediaInfoCache::insert(const std::string &path,
+                            const FileIdentity &identity,
+                            const MediaInfo &info) {
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    // 已有的定位索引在文件未变时保留
+    Record record;
+    bool existing = findRecord(path, identity, record, true);
+    if (existing && record.info.streamIndex != info.streamIndex) {
+        record.seekIndex.reset();
+    }
+    record.identity = identity;
+    record.info = info;
+    pending[path] = std::move(record);
+}
+
+void MediaInfoCache::insertSeekIndex(const std::string &path,
+                                     const FileIdentity &identity,
+                                     std::shared_ptr<const SeekIndex> index) {
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    Record record;
+    if (!index || !findRecord(path, identity, record, false) ||
+        record.info.streamIndex != index->getStreamIndex()) {
+        return;
+    }
+    record.seekIndex = std::move(index);
+    pending[path] = std::move(record);
+}
+
+bool MediaInfoCache::probe(const std::string &path, MediaInfo &info) {
+    FileIdentity identity;
+    bool hasIdentity = FileIdentity::get(path, identity);
+    if (hasIdentity && find(path, identity, info)) {
+        return true;
+    }
+
+    AudioDecoderConfig config;
+    config.probeMode = ProbeMode::FAST;
+    AudioDecoder decoder(config);
+    if (decoder.open(path) != AudioDecoderError::SUCCESS) {
+        return false;
+    }
+    info = decoder.getMediaInfo();
+    if (hasIdentity) {
+        insert(path, identity, info);
+    }
+    return true;
+}
+
+bool MediaInfoCache::flush() {
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    if (pending.empty()) {
+        return true;
+    }
+
+    // 合并：映射中没有被新条目替换的记录原样写回
+    std::vector<Blob> blobs;
+    blobs.reserve(mappedCount + pending.size());
+    if (mapping) {
+        const uint8_t *base = mapping->data();
+        size_t size = mapping->size();
+        for (size_t i = 0; i < mappedCount; i++) {
+            Slot slot;
+            std::memcpy(&slot, base + sizeof(FileHeader) + i * sizeof(Slot),
+                        sizeof(slot));
+            if (slot.offset > size || slot.size > size - slot.offset ||
+                slot.size < sizeof(RecordHeader)) {
+                continue;
+            }
+            RecordHeader header;
+            std::memcpy(&header, base + slot.offset, sizeof(header));
+            if (header.pathLength > slot.size - sizeof(header)) {
+                continue;
+            }
+            std::string path(
+                reinterpret_cast<const char *>(base + slot.offset) +
+                    sizeof(header),
+                header.pathLength);
+            if (pending.count(path) == 0) {
+                blobs.push_back({slot.hash, base + slot.offset,
+                                 static_cast<size_t>(slot.size), {}});
+            }
+        }
+    }
+    for (const auto &entry : pending) {
+        Blob blob{hashPath(entry.first), nullptr, 0, {}};
+        serialize(entry.first, entry.second.identity, entry.second.info,
+                  entry.second.seekIndex.get(), blob.owned);
+        blob.data = blob.owned.data();
+        blob.size = blob.owned.size();
+        blobs.push_back(std::move(blob));
+    }
+    std::sort(blobs.begin(), blobs.end(),
+              [](const Blob &a, const Blob &b) { return a.hash < b.hash; });
+
+    std::string tmpPath = cachePath + ".tmp";
+    {
+        std::ofstream out(tmpPath, std::ios::binary | std::ios::trunc);
+        if (!out) {
+            return false;
+        }
+        FileHeader header{};
+        std::memcpy(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC));
+        header.version = CACHE_VERSION;
+        header.count = blobs.size();
+        out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+
+        uint64_t offset = sizeof(header) + blobs.size() * sizeof(Slot);
+        for (const Blob &blob : blobs) {
+            Slot slot{blob.hash, offset, blob.size};
+            out.write(reinterpret_cast<const char *>(&slot), sizeof(slot));
+            offset += blob.size;
+        }
+        for (const Blob &blob : blobs) {
+            out.write(reinterpret_cast<const char *>(blob.data), blob.size);
+        }
+        if (!out) {
+            return false;
+        }
+    }
+
+    // Windows上映射中的文件不能被替换，改名前先解除映射
+    size_t written = blobs.size();
+    blobs.clear();
+    mapping.reset();
+    std::error_code ec;
+    std::filesystem::rename(tmpPath, cachePath, ec);
+    if (ec) {
+        std::filesystem::remove(tmpPath, ec);
+        mapCache();
+        return false;
+    }
+    pending.clear();
+    mapCache();
+    _logger->debug("Media info cache written: {} entries", written);
+    return true;
+}
+
+MediaInfoCacheStats MediaInfoCache::getStats() {
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    MediaInfoCacheStats stats;
+    stats.entries = mappedCount;
+    stats.pending = pending.size();
+    stats.hits = hits;
+    stats.misses = misses;
+    return stats;
+}
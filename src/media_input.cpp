@@ -0,0 +1,177 @@
+#include "media_input.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+
+#include <filesystem>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+extern "C" {
+#include <libavutil/error.h>
+}
+
+namespace {
+
+#ifdef _WIN32
+// 映射视图建立后文件句柄和映射句柄都可以关闭，视图本身会保持引用
+void *mapReadOnly(const std::string &path, size_t &size) {
+    HANDLE file = CreateFileW(std::filesystem::u8path(path).c_str(),
+                              GENERIC_READ, FILE_SHARE_READ, nullptr,
+                              OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN,
+                              nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        return nullptr;
+    }
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart <= 0) {
+        CloseHandle(file);
+        return nullptr;
+    }
+    HANDLE mapping =
+        CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    CloseHandle(file);
+    if (!mapping) {
+        return nullptr;
+    }
+    void *address = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    CloseHandle(mapping);
+    size = static_cast<size_t>(fileSize.QuadPart);
+    return address;
+}
+
+void unmap(void *address, size_t) { UnmapViewOfFile(address); }
+#else
+void *mapReadOnly(const std::string &path, size_t &size) {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return nullptr;
+    }
+    struct stat st;
+    if (fstat(fd, &st) < 0 || !S_ISREG(st.st_mode) || st.st_size <= 0) {
+        ::close(fd);
+        return nullptr;
+    }
+    size = static_cast<size_t>(st.st_size);
+    void *address = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    return address == MAP_FAILED ? nullptr : address;
+}
+
+void unmap(void *address, size_t size) { munmap(address, size); }
+#endif
+
+}  // namespace
+
+MediaInput::MediaInput(const uint8_t *data, size_t size, void *mapped)
+    : buffer(data), bufferSize(size), mappedAddress(mapped) {}
+
+MediaInput::~MediaInput() {
+    ioContext.reset();
+    if (mappedAddress) {
+        unmap(mappedAddress, bufferSize);
+    }
+}
+
+std::unique_ptr<MediaInput> MediaInput::mapFile(const std::string &path) {
+    size_t size = 0;
+    void *address = mapReadOnly(path, size);
+    if (!address) {
+        return nullptr;
+    }
+
+#ifndef _WIN32
+    // 解码是顺序读取：让内核加大预读、尽早回收读过的页，
+    // 并提前把文件开头读进页缓存，探测格式时不必等待磁盘
+    madvise(address, size, MADV_SEQUENTIAL);
+    madvise(address, std::min(size, READAHEAD_BYTES), MADV_WILLNEED);
+#endif
+
+    std::unique_ptr<MediaInput> input(
+        new MediaInput(static_cast<const uint8_t *>(address), size, address));
+    if (!input->createIOContext()) {
+        return nullptr;
+    }
+    return input;
+}
+
+std::unique_ptr<MediaInput> MediaInput::fromMemory(const uint8_t *data,
+                                                   size_t size) {
+    if (!data || size == 0) {
+        return nullptr;
+    }
+    std::unique_ptr<MediaInput> input(new MediaInput(data, size, nullptr));
+    if (!input->createIOContext()) {
+        return nullptr;
+    }
+    return input;
+}
+
+bool MediaInput::createIOContext() {
+    auto *ioBuffer = static_cast<unsigned char *>(av_malloc(IO_BUFFER_SIZE));
+    if (!ioBuffer) {
+        return false;
+    }
+    ioContext.reset(avio_alloc_context(ioBuffer, IO_BUFFER_SIZE, 0, this,
+                                       &MediaInput::readPacket, nullptr,
+                                       &MediaInput::seekPacket));
+    if (!ioContext) {
+        av_free(ioBuffer);
+        return false;
+    }
+    return true;
+}
+
+int MediaInput::readPacket(void *opaque, uint8_t *buf, int bufSize) {
+    auto *input = static_cast<MediaInput *>(opaque);
+    size_t remaining = input->bufferSize - input->position;
+    if (remaining == 0) {
+        return AVERROR_EOF;
+    }
+    size_t count = std::min(remaining, static_cast<size_t>(bufSize));
+    std::memcpy(buf, input->buffer + input->position, count);
+    input->position += count;
+    return static_cast<int>(count);
+}
+
+int64_t MediaInput::seekPacket(void *opaque, int64_t offset, int whence) {
+    auto *input = static_cast<MediaInput *>(opaque);
+    int64_t size = static_cast<int64_t>(input->bufferSize);
+
+    int64_t target;
+    switch (whence & ~AVSEEK_FORCE) {
+        case AVSEEK_SIZE:
+            return size;
+        case SEEK_SET:
+            target = offset;
+            break;
+        case SEEK_CUR:
+            target = static_cast<int64_t>(input->position) + offset;
+            break;
+        case SEEK_END:
+            target = size + offset;
+            break;
+        default:
+            return AVERROR(EINVAL);
+    }
+    if (target < 0 || target > size) {
+        return AVERROR(EINVAL);
+    }
+    input->position = static_cast<size_t>(target);
+    return target;
+}
@@ -0,0 +1,250 @@
+#include "packet_prefetcher.h"
+
+#include <algorithm>
+#include <chrono>
+
+#include "audio_decoder.h"
+#include "logger.h"
+
+namespace {
+std::string errorString(int errnum) {
+    char buf[AV_ERROR_MAX_STRING_SIZE];
+    av_strerror(errnum, buf, sizeof(buf));
+    return buf;
+}
+}  // namespace
+
+PacketPrefetcher::PacketPrefetcher() : queue(64) {
+    _logger = Logger::getInstance().getLogger("PacketPrefetcher");
+}
+
+PacketPrefetcher::~PacketPrefetcher() {
+    stop();
+    flush();
+    for (AVPacket *packet : idlePackets) {
+        av_packet_free(&packet);
+    }
+}
+
+void PacketPrefetcher::start(const PrefetchConfig &newConfig,
+                             AVRational newTimeBase, ReadFunction newRead,
+                             ReconnectFunction newReconnect) {
+    stop();
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        config = newConfig;
+        timeBase = newTimeBase;
+        buffering = true;
+        started = false;
+        finished = false;
+        finishCode = 0;
+    }
+    read = std::move(newRead);
+    reconnect = std::move(newReconnect);
+    running = true;
+    prefetchThread = std::thread(&PacketPrefetcher::prefetchLoop, this);
+}
+
+void PacketPrefetcher::stop() {
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        if (!prefetchThread.joinable()) {
+            return;
+        }
+        stopping = true;
+        running = false;
+    }
+    packetAvailable.notify_all();
+    spaceAvailable.notify_all();
+    if (prefetchThread.joinable()) {
+        prefetchThread.join();
+    }
+    stopping = false;
+}
+
+void PacketPrefetcher::flush() {
+    std::lock_guard<std::mutex> lock(queueMutex);
+    clearQueue();
+}
+
+// 调用方需持有queueMutex
+void PacketPrefetcher::clearQueue() {
+    while (!queue.empty()) {
+        AVPacket *packet = queue.front();
+        queue.pop();
+        av_packet_unref(packet);
+        idlePackets.push_back(packet);
+    }
+    queuedBytes = 0;
+    queuedDuration = 0;
+}
+
+// 调用方需持有queueMutex
+AVPacket *PacketPrefetcher::acquirePacket() {
+    if (idlePackets.empty()) {
+        return av_packet_alloc();
+    }
+    AVPacket *packet = idlePackets.back();
+    idlePackets.pop_back();
+    return packet;
+}
+
+// 按字节数和时长两种上限判断缓冲是否已满，调用方需持有queueMutex
+bool PacketPrefetcher::isFull() const {
+    if (queue.empty()) {
+        return false;
+    }
+    if (config.maxBytes > 0 && queuedBytes >= config.maxBytes) {
+        return true;
+    }
+    if (config.maxDurationMs > 0 && timeBase.num > 0) {
+        double ms = queuedDuration * av_q2d(timeBase) * 1000.0;
+        return ms >= config.maxDurationMs;
+    }
+    return false;
+}
+
+// 可被stop()打断的等待，返回false表示已停止
+bool PacketPrefetcher::waitForRetry(int delayMs) {
+    std::unique_lock<std::mutex> lock(queueMutex);
+    return !spaceAvailable.wait_for(lock, std::chrono::milliseconds(delayMs),
+                                    [this]() { return !running.load(); });
+}
+
+void PacketPrefetcher::finish(int code) {
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        finished = true;
+        finishCode = code;
+        buffering = false;
+    }
+    packetAvailable.notify_all();
+}
+
+void PacketPrefetcher::prefetchLoop() {
+    AudioDecoder::PacketPtr packet(av_packet_alloc());
+    int failures = 0;
+
+    while (running) {
+        {
+            std::unique_lock<std::mutex> lock(queueMutex);
+            spaceAvailable.wait(lock,
+                                [this]() { return !running || !isFull(); });
+            if (!running) {
+                break;
+            }
+        }
+
+        int ret = read(packet.get());
+        if (ret == 0) {
+            failures = 0;
+            {
+                std::lock_guard<std::mutex> lock(queueMutex);
+                if (queue.full()) {
+                    queue.reserve(queue.capacity() * 2);
+                }
+                AVPacket *queued = acquirePacket();
+                av_packet_move_ref(queued, packet.get());
+                queuedBytes += queued->size;
+                queuedDuration += std::max<int64_t>(0, queued->duration);
+                queue.push(queued);
+
+                // 积累到抖动缓冲的目标时长，或缓冲已满，才开始交给解码器；
+                // 数据包不带时长时无法按时长积累，直接交出
+                if (buffering) {
+                    double ms = queuedDuration * av_q2d(timeBase) * 1000.0;
+                    buffering = queued->duration > 0 && timeBase.num > 0 &&
+                                ms < config.jitterBufferMs && !isFull();
+                }
+            }
+            packetAvailable.notify_one();
+            continue;
+        }
+
+        if (!running) {
+            break;  // 阻塞的读取被stop()中断
+        }
+        if (ret == AVERROR_EOF) {
+            finish(ret);
+            break;
+        }
+
+        // 读取出错，按指数退避等待后重连
+        if (config.maxReconnects >= 0 && failures >= config.maxReconnects) {
+            _logger->error("Giving up after {} reconnect attempts: {}",
+                           failures, errorString(ret));
+            finish(ret);
+            break;
+        }
+        int shift = std::min(failures, 16);
+        int delayMs = std::min<int64_t>(
+            static_cast<int64_t>(config.reconnectDelayMs) << shift,
+            config.maxReconnectDelayMs);
+        failures++;
+        _logger->warn("Read error: {}, reconnecting in {} ms (attempt {})",
+                      errorString(ret), delayMs, failures);
+        if (!waitForRetry(delayMs)) {
+            break;
+        }
+
+        ret = reconnect();
+        {
+            std::lock_guard<std::mutex> lock(queueMutex);
+            reconnects++;
+        }
+        if (ret < 0) {
+            // 下一次读取会在旧的输入上再次失败，进入下一轮退避
+            _logger->warn("Reconnect failed: {}", errorString(ret));
+        } else {
+            _logger->info("Reconnected after {} attempt(s)", failures);
+        }
+    }
+}
+
+int PacketPrefetcher::pop(AVPacket *packet) {
+    std::unique_lock<std::mutex> lock(queueMutex);
+    while (true) {
+        if (!running) {
+            return AVERROR_EXIT;
+        }
+        if (!queue.empty() && (!buffering || finished)) {
+            break;
+        }
+        if (queue.empty() && finished) {
+            return finishCode;
+        }
+        // 播放中缓冲被读空：重新积累抖动缓冲，避免断续地逐包播放
+        if (queue.empty() && !buffering && started) {
+            buffering = true;
+            rebuffers++;
+            _logger->warn("Prefetch buffer ran dry, rebuffering");
+        }
+        packetAvailable.wait(lock);
+    }
+
+    AVPacket *queued = queue.front();
+    queue.pop();
+    queuedBytes -= std::min<size_t>(queuedBytes, queued->size);
+    queuedDuration -=
+        std::min(queuedDuration, std::max<int64_t>(0, queued->duration));
+    av_packet_move_ref(packet, queued);
+    idlePackets.push_back(queued);
+    started = true;
+    lock.unlock();
+    spaceAvailable.notify_one();
+    return 0;
+}
+
+PrefetchStats PacketPrefetcher::getStats() {
+    std::lock_guard<std::mutex> lock(queueMutex);
+    PrefetchStats stats;
+    stats.active = running;
+    stats.buffering = running && buffering;
+    stats.packets = queue.size();
+    stats.bytes = queuedBytes;
+    stats.bufferedMs =
+        timeBase.num > 0 ? queuedDuration * av_q2d(timeBase) * 1000.0 : 0.0;
+    stats.rebuffers = rebuffers;
+    stats.reconnects = reconnects;
+    return stats;
+}
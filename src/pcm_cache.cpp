@@ -0,0 +1,156 @@
+#include "pcm_cache.h"
+
+#include "audio_decoder.h"
+#include "logger.h"
+
+PcmCache::PcmCache(const PcmCacheConfig &config) : config(config) {
+    _logger = Logger::getInstance().getLogger("PcmCache");
+}
+
+bool PcmCache::isCacheable(const AudioDecoder &decoder) const {
+    double duration = decoder.getDuration();
+    return duration > 0.0 && duration <= config.maxClipSeconds;
+}
+
+std::shared_ptr<const PcmClip> PcmCache::find(const std::string &path) {
+    FileIdentity identity;
+    bool hasIdentity = FileIdentity::get(path, identity);
+
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    auto it = entries.find(path);
+    if (it == entries.end()) {
+        misses++;
+        return nullptr;
+    }
+    if (!hasIdentity || !(it->second.identity == identity)) {
+        // 文件已被修改或删除
+        erase(path);
+        misses++;
+        return nullptr;
+    }
+    lru.splice(lru.begin(), lru, it->second.lruPosition);
+    hits++;
+    return it->second.clip;
+}
+
+std::shared_ptr<const PcmClip> PcmCache::insert(
+    const std::string &path, AudioDecoder &decoder,
+    const AudioOutputFormat &format) {
+    FileIdentity identity;
+    if (!isCacheable(decoder) || !FileIdentity::get(path, identity)) {
+        return nullptr;
+    }
+
+    std::shared_ptr<PcmClip> clip = decodeClip(decoder, format);
+    if (!clip) {
+        return nullptr;
+    }
+    size_t bytes = clip->data.size();
+    if (bytes > config.memoryBudgetBytes) {
+        _logger->debug("Clip larger than cache budget, not cached: {}", path);
+        return clip;
+    }
+
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    erase(path);
+    evictFor(bytes);
+    lru.push_front(path);
+    entries[path] = Entry{clip, identity, lru.begin()};
+    usedBytes += bytes;
+    _logger->debug("Cached {} ({} bytes, {} entries, {} bytes total)", path,
+                   bytes, entries.size(), usedBytes);
+    return clip;
+}
+
+// 与播放器相同的方式逐帧解码和转换，结尾冲刷重采样器的延迟样本
+std::shared_ptr<PcmClip> PcmCache::decodeClip(
+    AudioDecoder &decoder, const AudioOutputFormat &format) {
+    AudioResampler resampler;
+    if (!resampler.init(decoder, format)) {
+        return nullptr;
+    }
+
+    auto clip = std::make_shared<PcmClip>();
+    clip->format = format;
+    clip->sourceSampleRate = decoder.getSampleRate();
+    clip->sourceChannels = decoder.getChannels();
+    clip->sourceFormat = decoder.getSampleFormat();
+
+    size_t frameBytes = format.bytesPerFrame();
+    clip->data.reserve(static_cast<size_t>(decoder.getDuration() *
+                                           format.sampleRate) *
+                       frameBytes);
+    const int capacity = 4096;
+    std::vector<uint8_t> block(capacity * frameBytes);
+
+    auto append = [&](const uint8_t **input, int inputSamples) {
+        while (true) {
+            int converted =
+                resampler.convert(input, inputSamples, block.data(), capacity);
+            if (converted < 0) {
+                return false;
+            }
+            clip->data.insert(clip->data.end(), block.data(),
+                              block.data() + converted * frameBytes);
+            // 输入已全部交给重采样器，之后只取出缓存的样本
+            inputSamples = 0;
+            if (converted < capacity) {
+                return true;
+            }
+        }
+    };
+
+    AudioDecoder::FramePtr frame(av_frame_alloc());
+    int ret;
+    while ((ret = decoder.decodeNextFrame(frame.get())) == 0) {
+        bool ok = append(const_cast<const uint8_t **>(frame->extended_data),
+                         frame->nb_samples);
+        av_frame_unref(frame.get());
+        if (!ok) {
+            return nullptr;
+        }
+    }
+    if (ret != AVERROR_EOF || !append(nullptr, 0)) {
+        return nullptr;
+    }
+    clip->data.shrink_to_fit();
+    return clip;
+}
+
+// 从最久未使用的片段开始淘汰，直到能放下bytes
+void PcmCache::evictFor(size_t bytes) {
+    while (!lru.empty() && usedBytes + bytes > config.memoryBudgetBytes) {
+        std::string oldest = lru.back();
+        erase(oldest);
+        evictions++;
+    }
+}
+
+// 调用方需持有cacheMutex；正在播放的片段由播放器持有引用，淘汰后仍然有效
+void PcmCache::erase(const std::string &path) {
+    auto it = entries.find(path);
+    if (it == entries.end()) {
+        return;
+    }
+    usedBytes -= it->second.clip->data.size();
+    lru.erase(it->second.lruPosition);
+    entries.erase(it);
+}
+
+void PcmCache::clear() {
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    entries.clear();
+    lru.clear();
+    usedBytes = 0;
+}
+
+PcmCacheStats PcmCache::getStats() {
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    PcmCacheStats stats;
+    stats.entries = entries.size();
+    stats.bytes = usedBytes;
+    stats.hits = hits;
+    stats.misses = misses;
+    stats.evictions = evictions;
+    return stats;
+}
@@ -0,0 +1,238 @@
+#include "player_controller.h"
+
+#include <algorithm>
+#include <chrono>
+
+#include "logger.h"
+
+namespace {
+// 可以与队列末尾同类命令合并的命令，只有最后的参数有意义
+bool isCoalescable(PlayerCommandType type) {
+    return type == PlayerCommandType::SEEK ||
+           type == PlayerCommandType::SET_VOLUME;
+}
+}  // namespace
+
+PlayerController::PlayerController(const AudioPlayerConfig &config,
+                                   size_t maxPending)
+    : player(config), maxPending(std::max<size_t>(1, maxPending)) {
+    _logger = Logger::getInstance().getLogger("PlayerController");
+    refreshStatus();
+    commandThread = std::thread(&PlayerController::commandLoop, this);
+}
+
+PlayerController::~PlayerController() { shutdown(); }
+
+uint64_t PlayerController::post(PlayerCommand command,
+                                CommandCallback callback) {
+    std::vector<Waiter> rejected;
+    uint64_t id = 0;
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        if (!isRunning || queue.size() >= maxPending) {
+            rejected.push_back({0, std::move(callback)});
+        } else {
+            id = nextId++;
+            if (isCoalescable(command.type) && !queue.empty() &&
+                queue.back().command.type == command.type) {
+                queue.back().command = std::move(command);
+                queue.back().waiters.push_back({id, std::move(callback)});
+            } else {
+                Pending pending{std::move(command), {}};
+                pending.waiters.push_back({id, std::move(callback)});
+                queue.push_back(std::move(pending));
+            }
+        }
+    }
+    if (id == 0) {
+        complete(rejected, false);
+        return 0;
+    }
+    queueWakeup.notify_one();
+    return id;
+}
+
+std::future<bool> PlayerController::submit(PlayerCommand command) {
+    auto promise = std::make_shared<std::promise<bool>>();
+    std::future<bool> result = promise->get_future();
+    post(std::move(command),
+         [promise](uint64_t, bool success) { promise->set_value(success); });
+    return result;
+}
+
+std::future<bool> PlayerController::load(const std::string &filename) {
+    return submit({PlayerCommandType::LOAD, filename});
+}
+
+std::future<bool> PlayerController::switchFile(const std::string &filename) {
+    return submit({PlayerCommandType::SWITCH, filename});
+}
+
+std::future<bool> PlayerController::enqueue(const std::string &filename) {
+    return submit({PlayerCommandType::ENQUEUE, filename});
+}
+
+std::future<bool> PlayerController::clearPlaylist() {
+    return submit({PlayerCommandType::CLEAR_PLAYLIST});
+}
+
+std::future<bool> PlayerController::play() {
+    return submit({PlayerCommandType::PLAY});
+}
+
+std::future<bool> PlayerController::pause() {
+    return submit({PlayerCommandType::PAUSE});
+}
+
+std::future<bool> PlayerController::resume() {
+    return submit({PlayerCommandType::RESUME});
+}
+
+std::future<bool> PlayerController::stop() {
+    return submit({PlayerCommandType::STOP});
+}
+
+std::future<bool> PlayerController::seek(double seconds) {
+    return submit({PlayerCommandType::SEEK, "", seconds});
+}
+
+std::future<bool> PlayerController::setVolume(int volume) {
+    return submit({PlayerCommandType::SET_VOLUME, "", 0.0, volume});
+}
+
+// 状态快照由命令线程维护，位置直接读取无锁的播放时钟
+PlayerStatus PlayerController::getStatus() const {
+    PlayerStatus snapshot;
+    {
+        std::lock_guard<std::mutex> lock(statusMutex);
+        snapshot = status;
+    }
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        snapshot.pendingCommands = queue.size();
+    }
+    snapshot.position = player.getCurrentPosition();
+    return snapshot;
+}
+
+void PlayerController::shutdown() {
+    std::deque<Pending> dropped;
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        if (!isRunning) {
+            return;
+        }
+        isRunning = false;
+        dropped.swap(queue);
+    }
+    queueWakeup.notify_one();
+    for (auto &pending : dropped) {
+        complete(pending.waiters, false);
+    }
+    if (commandThread.joinable()) {
+        commandThread.join();
+    }
+    player.stop();
+    refreshStatus();
+}
+
+void PlayerController::commandLoop() {
+    std::unique_lock<std::mutex> lock(queueMutex);
+    while (isRunning) {
+        if (queue.empty()) {
+            queueWakeup.wait_for(
+                lock, std::chrono::milliseconds(STATUS_INTERVAL_MS),
+                [this]() { return !isRunning || !queue.empty(); });
+            if (queue.empty()) {
+                lock.unlock();
+                refreshStatus();  // 曲目播完或无缝切换后状态也会变化
+                lock.lock();
+                continue;
+            }
+        }
+        if (!isRunning) {
+            break;
+        }
+        Pending pending = std::move(queue.front());
+        queue.pop_front();
+        lock.unlock();
+
+        bool success = false;
+        try {
+            success = execute(pending.command);
+        } catch (const std::exception &e) {
+            _logger->error("Command failed: {}", e.what());
+        }
+        refreshStatus();
+        {
+            std::lock_guard<std::mutex> statusLock(statusMutex);
+            status.completedCommands += pending.waiters.size();
+        }
+        complete(pending.waiters, success);
+
+        lock.lock();
+    }
+}
+
+bool PlayerController::execute(const PlayerCommand &command) {
+    switch (command.type) {
+        case PlayerCommandType::LOAD:
+            if (!player.loadFile(command.path)) {
+                return false;
+            }
+            break;
+        case PlayerCommandType::SWITCH:
+            if (!player.switchFile(command.path)) {
+                return false;
+            }
+            break;
+        case PlayerCommandType::ENQUEUE:
+            player.enqueue(command.path);
+            return true;
+        case PlayerCommandType::CLEAR_PLAYLIST:
+            player.clearPlaylist();
+            return true;
+        case PlayerCommandType::PLAY:
+            player.play();
+            return player.getState() == AudioPlayer::State::PLAYING;
+        case PlayerCommandType::PAUSE:
+            player.pause();
+            return true;
+        case PlayerCommandType::RESUME:
+            player.resume();
+            return true;
+        case PlayerCommandType::STOP:
+            player.stop();
+            return true;
+        case PlayerCommandType::SEEK:
+            player.seek(command.seconds);
+            return true;
+        case PlayerCommandType::SET_VOLUME:
+            player.setVolume(command.volume);
+            return true;
+    }
+
+    // 加载成功
+    std::lock_guard<std::mutex> lock(statusMutex);
+    status.file = command.path;
+    return true;
+}
+
+// 只在命令线程（以及构造和关闭时）调用，播放器本身不需要跨线程访问
+void PlayerController::refreshStatus() {
+    AudioPlayer::State state = player.getState();
+    double duration = player.getDuration();
+    int volume = player.getVolume();
+    std::lock_guard<std::mutex> lock(statusMutex);
+    status.state = state;
+    status.duration = duration;
+    status.volume = volume;
+}
+
+void PlayerController::complete(std::vector<Waiter> &waiters, bool success) {
+    for (auto &waiter : waiters) {
+        if (waiter.callback) {
+            waiter.callback(waiter.id, success);
+        }
+    }
+}
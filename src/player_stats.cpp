@@ -0,0 +1,147 @@
+#include "player_stats.h"
+
+#include <limits>
+#include <sstream>
+
+namespace {
+
+void appendJson(std::ostringstream &out, const char *name,
+                const LatencySummary &summary) {
+    out << "\"" << name << "\":{"
+        << "\"count\":" << summary.count << ",\"sum_ns\":" << summary.sum
+        << ",\"min_ns\":" << summary.min << ",\"max_ns\":" << summary.max
+        << ",\"p50_ns\":" << summary.p50 << ",\"p90_ns\":" << summary.p90
+        << ",\"p99_ns\":" << summary.p99 << ",\"p999_ns\":" << summary.p999
+        << "}";
+}
+
+void appendMetric(std::ostringstream &out, const std::string &name,
+                  const char *type, const char *help, double value) {
+    out << "# HELP " << name << " " << help << "\n"
+        << "# TYPE " << name << " " << type << "\n"
+        << name << " " << value << "\n";
+}
+
+// 计数器和字节数按整数输出，超过double默认的6位有效数字也不丢精度
+void appendMetric(std::ostringstream &out, const std::string &name,
+                  const char *type, const char *help, uint64_t value) {
+    out << "# HELP " << name << " " << help << "\n"
+        << "# TYPE " << name << " " << type << "\n"
+        << name << " " << value << "\n";
+}
+
+void appendSummary(std::ostringstream &out, const std::string &name,
+                   const char *help, const LatencySummary &summary) {
+    const double NS = 1e-9;
+    out << "# HELP " << name << " " << help << "\n"
+        << "# TYPE " << name << " summary\n"
+        << name << "{quantile=\"0.5\"} " << summary.p50 * NS << "\n"
+        << name << "{quantile=\"0.9\"} " << summary.p90 * NS << "\n"
+        << name << "{quantile=\"0.99\"} " << summary.p99 * NS << "\n"
+        << name << "{quantile=\"0.999\"} " << summary.p999 * NS << "\n"
+        << name << "_sum " << summary.sum * NS << "\n"
+        << name << "_count " << summary.count << "\n";
+}
+
+}  // namespace
+
+std::string PlayerStats::toJson() const {
+    std::ostringstream out;
+    out << "{";
+    appendJson(out, "decode", decode);
+    out << ",";
+    appendJson(out, "resample", resample);
+    out << ",";
+    appendJson(out, "callback", callback);
+    out << ",";
+    appendJson(out, "open", open);
+    out << ",";
+    appendJson(out, "first_audio", firstAudio);
+    out << ",\"callbacks\":" << callbacks << ",\"underruns\":" << underruns
+        << ",\"dropped_events\":" << droppedEvents
+        << ",\"decoder_queue_frames\":" << decoderQueueFrames
+        << ",\"decoder_queue_high_water\":" << decoderQueueHighWater
+        << ",\"prefetch_active\":" << (prefetchActive ? "true" : "false")
+        << ",\"prefetch_buffering\":"
+        << (prefetchBuffering ? "true" : "false")
+        << ",\"prefetch_bytes\":" << prefetchBytes
+        << ",\"prefetch_ms\":" << prefetchMs
+        << ",\"prefetch_rebuffers\":" << prefetchRebuffers
+        << ",\"prefetch_reconnects\":" << prefetchReconnects
+        << ",\"buffered_bytes\":" << bufferedBytes
+        << ",\"buffer_high_water_bytes\":" << bufferHighWaterBytes
+        << ",\"buffer_capacity_bytes\":" << bufferCapacityBytes
+        << ",\"buffered_ms\":" << bufferedMs
+        << ",\"buffer_target_ms\":" << bufferTargetMs
+        << ",\"buffer_growths\":" << bufferGrowths
+        << ",\"buffer_shrinks\":" << bufferShrinks
+        << ",\"producer_wakeups\":" << producerWakeups << "}";
+    return out.str();
+}
+
+std::string PlayerStats::toPrometheus(const std::string &prefix) const {
+    std::ostringstream out;
+    // 累计耗时等浮点值同样需要足够的有效数字
+    out.precision(std::numeric_limits<double>::digits10);
+    appendSummary(out, prefix + "_decode_duration_seconds",
+                  "Time to decode one audio frame", decode);
+    appendSummary(out, prefix + "_resample_duration_seconds",
+                  "Time spent in one resampler conversion", resample);
+    appendSummary(out, prefix + "_callback_duration_seconds",
+                  "Duration of the audio device callback", callback);
+    appendSummary(out, prefix + "_open_duration_seconds",
+                  "Time to open a file and prepare the output", open);
+    appendSummary(out, prefix + "_first_audio_seconds",
+                  "Time from loading a file to its first audible callback",
+                  firstAudio);
+    appendMetric(out, prefix + "_callbacks_total", "counter",
+                 "Audio device callbacks", callbacks);
+    appendMetric(out, prefix + "_underruns_total", "counter",
+                 "Callbacks that had to output silence", underruns);
+    appendMetric(out, prefix + "_dropped_events_total", "counter",
+                 "Callback events dropped because the event ring was full",
+                 droppedEvents);
+    appendMetric(out, prefix + "_decoder_queue_frames", "gauge",
+                 "Frames waiting in the decoder queue",
+                 static_cast<uint64_t>(decoderQueueFrames));
+    appendMetric(out, prefix + "_decoder_queue_high_water_frames", "gauge",
+                 "Highest decoder queue depth for the current track",
+                 static_cast<uint64_t>(decoderQueueHighWater));
+    appendMetric(out, prefix + "_prefetch_buffering", "gauge",
+                 "1 while the network jitter buffer is refilling",
+                 prefetchBuffering ? 1.0 : 0.0);
+    appendMetric(out, prefix + "_prefetch_bytes", "gauge",
+                 "Compressed bytes waiting in the prefetch buffer",
+                 static_cast<uint64_t>(prefetchBytes));
+    appendMetric(out, prefix + "_prefetch_seconds", "gauge",
+                 "Audio waiting in the prefetch buffer", prefetchMs / 1000.0);
+    appendMetric(out, prefix + "_prefetch_rebuffers_total", "counter",
+                 "Times the prefetch buffer ran dry during playback",
+                 prefetchRebuffers);
+    appendMetric(out, prefix + "_prefetch_reconnects_total", "counter",
+                 "Reconnect attempts after input read errors",
+                 prefetchReconnects);
+    appendMetric(out, prefix + "_buffered_bytes", "gauge",
+                 "PCM bytes waiting in the output ring buffer",
+                 static_cast<uint64_t>(bufferedBytes));
+    appendMetric(out, prefix + "_buffer_high_water_bytes", "gauge",
+                 "Highest output ring buffer fill",
+                 static_cast<uint64_t>(bufferHighWaterBytes));
+    appendMetric(out, prefix + "_buffer_capacity_bytes", "gauge",
+                 "Output ring buffer capacity",
+                 static_cast<uint64_t>(bufferCapacityBytes));
+    appendMetric(out, prefix + "_buffered_seconds", "gauge",
+                 "Audio waiting in the output ring buffer",
+                 bufferedMs / 1000.0);
+    appendMetric(out, prefix + "_buffer_target_seconds", "gauge",
+                 "Adaptive fill depth of the output ring buffer",
+                 bufferTargetMs / 1000.0);
+    appendMetric(out, prefix + "_buffer_growths_total", "counter",
+                 "Times the adaptive buffer grew after jitter", bufferGrowths);
+    appendMetric(out, prefix + "_buffer_shrinks_total", "counter",
+                 "Times the adaptive buffer shrank while calm", bufferShrinks);
+    appendMetric(out, prefix + "_producer_wakeups_total", "counter",
+                 "Times the producer woke up after waiting for buffer space",
+                 producerWakeups);
+    return out.str();
+}
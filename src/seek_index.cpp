@@ -0,0 +1,190 @@
+#include "seek_index.h"
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+#include "audio_decoder.h"
+
+namespace {
+constexpr char CACHE_MAGIC[4] = {'T', 'S', 'I', 'X'};
+constexpr uint32_t CACHE_VERSION = 1;
+
+// 缓存文件头，后接count个Entry；只在本机使用，按本机字节序存储
+struct CacheHeader {
+    char magic[4];
+    uint32_t version;
+    uint64_t fileSize;
+    int64_t mtime;
+    int32_t streamIndex;
+    int32_t timeBaseNum;
+    int32_t timeBaseDen;
+    uint32_t reserved;
+    uint64_t count;
+};
+}  // namespace
+
+bool FileIdentity::get(const std::string &filename, FileIdentity &identity) {
+    std::error_code ec;
+    auto size = std::filesystem::file_size(filename, ec);
+    if (ec) {
+        return false;
+    }
+    auto mtime = std::filesystem::last_write_time(filename, ec);
+    if (ec) {
+        return false;
+    }
+    identity.size = size;
+    identity.mtime = mtime.time_since_epoch().count();
+    return true;
+}
+
+std::string SeekIndex::cachePathFor(const std::string &filename) {
+    return filename + ".tsidx";
+}
+
+std::shared_ptr<SeekIndex> SeekIndex::build(const std::string &filename,
+                                            int streamIndex,
+                                            double intervalSeconds,
+                                            const std::atomic<bool> &cancel) {
+    AVFormatContext *ctx = nullptr;
+    if (avformat_open_input(&ctx, filename.c_str(), nullptr, nullptr) < 0) {
+        return nullptr;
+    }
+    AudioDecoder::FormatContextPtr formatContext(ctx);
+
+    if (streamIndex < 0 ||
+        static_cast<unsigned int>(streamIndex) >= ctx->nb_streams ||
+        ctx->streams[streamIndex]->codecpar->codec_type !=
+            AVMEDIA_TYPE_AUDIO) {
+        return nullptr;
+    }
+
+    auto index = std::make_shared<SeekIndex>();
+    index->streamIndex = streamIndex;
+    index->timeBase = ctx->streams[streamIndex]->time_base;
+    int64_t interval =
+        static_cast<int64_t>(intervalSeconds / av_q2d(index->timeBase));
+
+    // 只解复用不解码，记录关键数据包的位置和时间戳
+    AudioDecoder::PacketPtr packet(av_packet_alloc());
+    bool hasLast = false;
+    int64_t lastPts = 0;
+    while (!cancel && av_read_frame(ctx, packet.get()) >= 0) {
+        if (packet->stream_index == streamIndex && packet->pos >= 0 &&
+            (packet->flags & AV_PKT_FLAG_KEY)) {
+            int64_t ts =
+                packet->pts != AV_NOPTS_VALUE ? packet->pts : packet->dts;
+            if (ts != AV_NOPTS_VALUE &&
+                (!hasLast || ts - lastPts >= interval)) {
+                index->entries.push_back(Entry{packet->pos, ts});
+                lastPts = ts;
+                hasLast = true;
+            }
+        }
+        av_packet_unref(packet.get());
+    }
+
+    if (cancel || index->entries.empty()) {
+        return nullptr;
+    }
+
+    std::sort(index->entries.begin(), index->entries.end(),
+              [](const Entry &a, const Entry &b) { return a.pts < b.pts; });
+    return index;
+}
+
+std::shared_ptr<SeekIndex> SeekIndex::load(const std::string &cachePath,
+                                           const FileIdentity &identity,
+                                           int streamIndex) {
+    std::error_code ec;
+    uint64_t cacheSize = std::filesystem::file_size(cachePath, ec);
+    if (ec || cacheSize < sizeof(CacheHeader)) {
+        return nullptr;
+    }
+    std::ifstream in(cachePath, std::ios::binary);
+    if (!in) {
+        return nullptr;
+    }
+
+    CacheHeader header;
+    if (!in.read(reinterpret_cast<char *>(&header), sizeof(header)) ||
+        std::memcmp(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC)) != 0 ||
+        header.version != CACHE_VERSION || header.fileSize != identity.size ||
+        header.mtime != identity.mtime || header.streamIndex != streamIndex ||
+        header.timeBaseDen <= 0 || header.count == 0 ||
+        header.count > (cacheSize - sizeof(header)) / sizeof(Entry)) {
+        return nullptr;
+    }
+
+    auto index = std::make_shared<SeekIndex>();
+    index->streamIndex = streamIndex;
+    index->timeBase = AVRational{header.timeBaseNum, header.timeBaseDen};
+    index->entries.resize(header.count);
+    if (!in.read(reinterpret_cast<char *>(index->entries.data()),
+                 header.count * sizeof(Entry))) {
+        return nullptr;
+    }
+    return index;
+}
+
+bool SeekIndex::save(const std::string &cachePath,
+                     const FileIdentity &identity) const {
+    // 先写临时文件再改名，避免并发读取到不完整的缓存
+    std::string tmpPath = cachePath + ".tmp";
+    {
+        std::ofstream out(tmpPath, std::ios::binary | std::ios::trunc);
+        if (!out) {
+            return false;
+        }
+
+        CacheHeader header{};
+        std::memcpy(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC));
+        header.version = CACHE_VERSION;
+        header.fileSize = identity.size;
+        header.mtime = identity.mtime;
+        header.streamIndex = streamIndex;
+        header.timeBaseNum = timeBase.num;
+        header.timeBaseDen = timeBase.den;
+        header.count = entries.size();
+
+        out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+        out.write(reinterpret_cast<const char *>(entries.data()),
+                  entries.size() * sizeof(Entry));
+        if (!out) {
+            return false;
+        }
+    }
+
+    std::error_code ec;
+    std::filesystem::rename(tmpPath, cachePath, ec);
+    if (ec) {
+        std::filesystem::remove(tmpPath, ec);
+        return false;
+    }
+    return true;
+}
+
+std::shared_ptr<SeekIndex> SeekIndex::fromEntries(std::vector<Entry> entries,
+                                                 AVRational timeBase,
+                                                 int streamIndex) {
+    if (entries.empty() || timeBase.den <= 0) {
+        return nullptr;
+    }
+    auto index = std::make_shared<SeekIndex>();
+    index->entries = std::move(entries);
+    index->timeBase = timeBase;
+    index->streamIndex = streamIndex;
+    return index;
+}
+
+const SeekIndex::Entry *SeekIndex::find(int64_t pts) const {
+    auto it = std::upper_bound(
+        entries.begin(), entries.end(), pts,
+        [](int64_t value, const Entry &entry) { return value < entry.pts; });
+    if (it == entries.begin()) {
+        return nullptr;
+    }
+    return &*(it - 1);
+}
@@ -0,0 +1,173 @@
+#include "texas.h"
+
+#include <utility>
+
+#include "logger.h"
+#include "player_controller.h"
+
+struct texas_player {
+    explicit texas_player(const AudioPlayerConfig &config, size_t maxPending)
+        : controller(config, maxPending) {}
+    PlayerController controller;
+};
+
+namespace {
+// C回调不能抛出到调用方，适配为CommandCallback
+CommandCallback adapt(texas_callback callback, void *userdata) {
+    if (!callback) {
+        return nullptr;
+    }
+    return [callback, userdata](uint64_t id, bool success) {
+        callback(id, success ? 1 : 0, userdata);
+    };
+}
+
+// 异常不能穿过C接口，fn抛出任何异常时返回fallback
+template <typename T, typename Fn>
+T guarded(T fallback, Fn &&fn) {
+    try {
+        return fn();
+    } catch (...) {
+        return fallback;
+    }
+}
+
+// 命令在try块内构造，路径的拷贝同样可能抛出bad_alloc。控制器拒绝命令时
+// 自己以失败调用回调；抛出异常时命令没有进入队列，同样返回0并以失败调用回调
+uint64_t post(texas_player *player, texas_callback callback, void *userdata,
+              PlayerCommandType type, const char *path = nullptr,
+              double seconds = 0.0, int volume = 0) {
+    bool handled = false;
+    uint64_t id = guarded<uint64_t>(0, [&]() -> uint64_t {
+        if (!player) {
+            return 0;
+        }
+        PlayerCommand command{type, path ? path : "", seconds, volume};
+        uint64_t posted = player->controller.post(std::move(command),
+                                                  adapt(callback, userdata));
+        handled = true;
+        return posted;
+    });
+    if (!handled && callback) {
+        callback(0, 0, userdata);
+    }
+    return id;
+}
+
+// 状态快照包含文件名的拷贝，读取同样放在guarded里
+PlayerStatus status(const texas_player *player) {
+    return guarded(PlayerStatus{}, [player]() {
+        return player ? player->controller.getStatus() : PlayerStatus{};
+    });
+}
+}  // namespace
+
+int texas_init_logging(const char *filename) {
+    return guarded(-1, [filename]() {
+        Logger::LoggerConfig config;
+        if (filename) {
+            config.filename = filename;
+        }
+        config.console_output = false;
+        config.async_mode = true;
+        return Logger::getInstance().initialize(config) ? 0 : -1;
+    });
+}
+
+texas_player *texas_player_create(const texas_config *config) {
+    return guarded<texas_player *>(nullptr, [config]() {
+        AudioPlayerConfig pconfig;
+        size_t maxPending = PlayerController::DEFAULT_MAX_PENDING;
+        if (config) {
+            pconfig.targetLatencyMs = config->target_latency_ms;
+            pconfig.headless = config->headless != 0;
+            if (config->output_file) {
+                pconfig.outputFile = config->output_file;
+            }
+            if (config->max_pending > 0) {
+                maxPending = static_cast<size_t>(config->max_pending);
+            }
+        }
+        return new texas_player(pconfig, maxPending);
+    });
+}
+
+void texas_player_destroy(texas_player *player) { delete player; }
+
+uint64_t texas_player_load(texas_player *player, const char *path,
+                           texas_callback callback, void *userdata) {
+    return post(player, callback, userdata, PlayerCommandType::LOAD, path);
+}
+
+uint64_t texas_player_switch(texas_player *player, const char *path,
+                             texas_callback callback, void *userdata) {
+    return post(player, callback, userdata, PlayerCommandType::SWITCH,
+                path);
+}
+
+uint64_t texas_player_enqueue(texas_player *player, const char *path,
+                              texas_callback callback, void *userdata) {
+    return post(player, callback, userdata, PlayerCommandType::ENQUEUE,
+                path);
+}
+
+uint64_t texas_player_clear_playlist(texas_player *player,
+                                     texas_callback callback,
+                                     void *userdata) {
+    return post(player, callback, userdata, PlayerCommandType::CLEAR_PLAYLIST);
+}
+
+uint64_t texas_player_play(texas_player *player, texas_callback callback,
+                           void *userdata) {
+    return post(player, callback, userdata, PlayerCommandType::PLAY);
+}
+
+uint64_t texas_player_pause(texas_player *player, texas_callback callback,
+                            void *userdata) {
+    return post(player, callback, userdata, PlayerCommandType::PAUSE);
+}
+
+uint64_t texas_player_resume(texas_player *player, texas_callback callback,
+                             void *userdata) {
+    return post(player, callback, userdata, PlayerCommandType::RESUME);
+}
+
+uint64_t texas_player_stop(texas_player *player, texas_callback callback,
+                           void *userdata) {
+    return post(player, callback, userdata, PlayerCommandType::STOP);
+}
+
+uint64_t texas_player_seek(texas_player *player, double seconds,
+                           texas_callback callback, void *userdata) {
+    return post(player, callback, userdata, PlayerCommandType::SEEK, nullptr,
+                seconds);
+}
+
+uint64_t texas_player_set_volume(texas_player *player, int volume,
+                                 texas_callback callback, void *userdata) {
+    return post(player, callback, userdata, PlayerCommandType::SET_VOLUME,
+                nullptr, 0.0, volume);
+}
+
+texas_state texas_player_get_state(const texas_player *player) {
+    switch (status(player).state) {
+        case AudioPlayer::State::PLAYING:
+            return TEXAS_STATE_PLAYING;
+        case AudioPlayer::State::PAUSED:
+            return TEXAS_STATE_PAUSED;
+        default:
+            return TEXAS_STATE_STOPPED;
+    }
+}
+
+double texas_player_get_position(const texas_player *player) {
+    return status(player).position;
+}
+
+double texas_player_get_duration(const texas_player *player) {
+    return status(player).duration;
+}
+
+int texas_player_get_volume(const texas_player *player) {
+    return status(player).volume;
+}
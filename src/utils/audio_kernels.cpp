@@ -0,0 +1,388 @@
+// audio_kernels.cpp
+#include "audio_kernels.h"
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64)
+#define TEXAS_KERNELS_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#define TEXAS_TARGET_AVX2
+#else
+#define TEXAS_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#define TEXAS_KERNELS_NEON 1
+#include <arm_neon.h>
+#endif
+
+namespace {
+
+inline float clampSample(float value) {
+    return std::min(1.0f, std::max(-1.0f, value));
+}
+
+inline int16_t scaleS16(int16_t sample, float gain) {
+    long value = std::lrint(sample * gain);
+    return static_cast<int16_t>(std::clamp(value, -32768L, 32767L));
+}
+
+// ---------------------------------------------------------------------------
+// 标量实现
+
+void interleaveScalar(const float *const *planes, size_t offset, int channels,
+                      size_t frames, float gain, float *out) {
+    for (size_t i = 0; i < frames; i++) {
+        for (int c = 0; c < channels; c++) {
+            *out++ = clampSample(planes[c][offset + i] * gain);
+        }
+    }
+}
+
+void gainF32Scalar(const float *in, float *out, size_t count, float gain) {
+    for (size_t i = 0; i < count; i++) {
+        out[i] = clampSample(in[i] * gain);
+    }
+}
+
+void gainS16Scalar(const int16_t *in, int16_t *out, size_t count,
+                   float gain) {
+    for (size_t i = 0; i < count; i++) {
+        out[i] = scaleS16(in[i], gain);
+    }
+}
+
+void rampF32Scalar(const float *in, float *out, size_t frames, int channels,
+                   float startGain, float endGain) {
+    float step = frames > 0 ? (endGain - startGain) / frames : 0.0f;
+    for (size_t i = 0; i < frames; i++) {
+        float gain = startGain + step * i;
+        for (int c = 0; c < channels; c++) {
+            size_t index = i * channels + c;
+            out[index] = clampSample(in[index] * gain);
+        }
+    }
+}
+
+void rampS16Scalar(const int16_t *in, int16_t *out, size_t frames,
+                   int channels, float startGain, float endGain) {
+    float step = frames > 0 ? (endGain - startGain) / frames : 0.0f;
+    for (size_t i = 0; i < frames; i++) {
+        float gain = startGain + step * i;
+        for (int c = 0; c < channels; c++) {
+            size_t index = i * channels + c;
+            out[index] = scaleS16(in[index], gain);
+        }
+    }
+}
+
+void mixStereoScalar(const float *in, float *out, size_t frames,
+                     float leftStart, float rightStart, float leftEnd,
+                     float rightEnd) {
+    float leftStep = frames > 0 ? (leftEnd - leftStart) / frames : 0.0f;
+    float rightStep = frames > 0 ? (rightEnd - rightStart) / frames : 0.0f;
+    for (size_t i = 0; i < frames; i++) {
+        out[i * 2] += in[i * 2] * (leftStart + leftStep * i);
+        out[i * 2 + 1] += in[i * 2 + 1] * (rightStart + rightStep * i);
+    }
+}
+
+void peakF32Scalar(const float *in, size_t count, float *peak,
+                   double *sumSquares) {
+    float maxValue = *peak;
+    double sum = 0.0;
+    for (size_t i = 0; i < count; i++) {
+        maxValue = std::max(maxValue, std::abs(in[i]));
+        sum += static_cast<double>(in[i]) * in[i];
+    }
+    *peak = maxValue;
+    *sumSquares += sum;
+}
+
+const AudioKernels SCALAR_KERNELS = {
+    interleaveScalar, gainF32Scalar,   gainS16Scalar, rampF32Scalar,
+    rampS16Scalar,    mixStereoScalar, peakF32Scalar, "scalar",
+};
+
+// ---------------------------------------------------------------------------
+// AVX2实现：每次处理8个float或16个int16，不足一个向量的尾部交给标量实现
+
+#ifdef TEXAS_KERNELS_X86
+
+TEXAS_TARGET_AVX2 inline __m256 clampAvx2(__m256 value) {
+    return _mm256_min_ps(_mm256_set1_ps(1.0f),
+                         _mm256_max_ps(_mm256_set1_ps(-1.0f), value));
+}
+
+TEXAS_TARGET_AVX2 void interleaveAvx2(const float *const *planes,
+                                      size_t offset, int channels,
+                                      size_t frames, float gain, float *out) {
+    size_t i = 0;
+    __m256 g = _mm256_set1_ps(gain);
+    if (channels == 1) {
+        const float *mono = planes[0] + offset;
+        for (; i + 8 <= frames; i += 8) {
+            __m256 v = _mm256_mul_ps(_mm256_loadu_ps(mono + i), g);
+            _mm256_storeu_ps(out + i, clampAvx2(v));
+        }
+    } else if (channels == 2) {
+        const float *left = planes[0] + offset;
+        const float *right = planes[1] + offset;
+        for (; i + 8 <= frames; i += 8) {
+            __m256 l = _mm256_mul_ps(_mm256_loadu_ps(left + i), g);
+            __m256 r = _mm256_mul_ps(_mm256_loadu_ps(right + i), g);
+            // lo = l0 r0 l1 r1 | l4 r4 l5 r5, hi = l2 r2 l3 r3 | l6 r6 l7 r7
+            __m256 lo = _mm256_unpacklo_ps(l, r);
+            __m256 hi = _mm256_unpackhi_ps(l, r);
+            _mm256_storeu_ps(out + i * 2,
+                             clampAvx2(_mm256_permute2f128_ps(lo, hi, 0x20)));
+            _mm256_storeu_ps(out + i * 2 + 8,
+                             clampAvx2(_mm256_permute2f128_ps(lo, hi, 0x31)));
+        }
+    }
+    // 多声道和尾部样本
+    if (i < frames) {
+        interleaveScalar(planes, offset + i, channels, frames - i, gain,
+                         out + i * channels);
+    }
+}
+
+TEXAS_TARGET_AVX2 void gainF32Avx2(const float *in, float *out, size_t count,
+                                   float gain) {
+    size_t i = 0;
+    __m256 g = _mm256_set1_ps(gain);
+    for (; i + 8 <= count; i += 8) {
+        __m256 v = _mm256_mul_ps(_mm256_loadu_ps(in + i), g);
+        _mm256_storeu_ps(out + i, clampAvx2(v));
+    }
+    gainF32Scalar(in + i, out + i, count - i, gain);
+}
+
+TEXAS_TARGET_AVX2 void gainS16Avx2(const int16_t *in, int16_t *out,
+                                   size_t count, float gain) {
+    size_t i = 0;
+    __m256 g = _mm256_set1_ps(gain);
+    for (; i + 16 <= count; i += 16) {
+        __m256i v =
+            _mm256_loadu_si256(reinterpret_cast<const __m256i *>(in + i));
+        __m256i lo = _mm256_cvtepi16_epi32(_mm256_castsi256_si128(v));
+        __m256i hi = _mm256_cvtepi16_epi32(_mm256_extracti128_si256(v, 1));
+        lo = _mm256_cvtps_epi32(_mm256_mul_ps(_mm256_cvtepi32_ps(lo), g));
+        hi = _mm256_cvtps_epi32(_mm256_mul_ps(_mm256_cvtepi32_ps(hi), g));
+        // packs按128位分别打包，重新排列四个64位块恢复顺序
+        __m256i packed = _mm256_packs_epi32(lo, hi);
+        packed = _mm256_permute4x64_epi64(packed, 0xD8);
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + i), packed);
+    }
+    gainS16Scalar(in + i, out + i, count - i, gain);
+}
+
+// 每个向量4帧，增益向量按l r l r排列，每次迭代加上4帧的增量
+TEXAS_TARGET_AVX2 void mixStereoAvx2(const float *in, float *out,
+                                     size_t frames, float leftStart,
+                                     float rightStart, float leftEnd,
+                                     float rightEnd) {
+    float leftStep = frames > 0 ? (leftEnd - leftStart) / frames : 0.0f;
+    float rightStep = frames > 0 ? (rightEnd - rightStart) / frames : 0.0f;
+    __m256 gain = _mm256_setr_ps(
+        leftStart, rightStart, leftStart + leftStep, rightStart + rightStep,
+        leftStart + leftStep * 2, rightStart + rightStep * 2,
+        leftStart + leftStep * 3, rightStart + rightStep * 3);
+    __m256 step = _mm256_setr_ps(leftStep * 4, rightStep * 4, leftStep * 4,
+                                 rightStep * 4, leftStep * 4, rightStep * 4,
+                                 leftStep * 4, rightStep * 4);
+    size_t i = 0;
+    for (; i + 4 <= frames; i += 4) {
+        __m256 v = _mm256_mul_ps(_mm256_loadu_ps(in + i * 2), gain);
+        _mm256_storeu_ps(out + i * 2,
+                         _mm256_add_ps(_mm256_loadu_ps(out + i * 2), v));
+        gain = _mm256_add_ps(gain, step);
+    }
+    mixStereoScalar(in + i * 2, out + i * 2, frames - i,
+                    leftStart + leftStep * i, rightStart + rightStep * i,
+                    leftEnd, rightEnd);
+}
+
+// 绝对值用清除符号位得到；平方和转为double累加，长时间统计不损失精度
+TEXAS_TARGET_AVX2 void peakF32Avx2(const float *in, size_t count, float *peak,
+                                   double *sumSquares) {
+    __m256 signMask = _mm256_set1_ps(-0.0f);
+    __m256 maxValue = _mm256_setzero_ps();
+    __m256d sumLo = _mm256_setzero_pd();
+    __m256d sumHi = _mm256_setzero_pd();
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256 v = _mm256_loadu_ps(in + i);
+        maxValue = _mm256_max_ps(maxValue, _mm256_andnot_ps(signMask, v));
+        __m256d lo = _mm256_cvtps_pd(_mm256_castps256_ps128(v));
+        __m256d hi = _mm256_cvtps_pd(_mm256_extractf128_ps(v, 1));
+        sumLo = _mm256_add_pd(sumLo, _mm256_mul_pd(lo, lo));
+        sumHi = _mm256_add_pd(sumHi, _mm256_mul_pd(hi, hi));
+    }
+    float lanes[8];
+    double sums[4];
+    _mm256_storeu_ps(lanes, maxValue);
+    _mm256_storeu_pd(sums, _mm256_add_pd(sumLo, sumHi));
+    float result = *peak;
+    for (float lane : lanes) {
+        result = std::max(result, lane);
+    }
+    *peak = result;
+    *sumSquares += sums[0] + sums[1] + sums[2] + sums[3];
+    peakF32Scalar(in + i, count - i, peak, sumSquares);
+}
+
+bool cpuHasAvx2() {
+#if defined(_MSC_VER) && !defined(__clang__)
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7) {
+        return false;
+    }
+    __cpuid(info, 1);
+    bool osxsave = (info[2] & (1 << 27)) != 0;
+    bool avx = (info[2] & (1 << 28)) != 0;
+    // 操作系统需要保存YMM寄存器状态
+    if (!osxsave || !avx || (_xgetbv(0) & 0x6) != 0x6) {
+        return false;
+    }
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+
+const AudioKernels AVX2_KERNELS = {
+    interleaveAvx2, gainF32Avx2,   gainS16Avx2, rampF32Scalar,
+    rampS16Scalar,  mixStereoAvx2, peakF32Avx2, "avx2",
+};
+
+#endif  // TEXAS_KERNELS_X86
+
+// ---------------------------------------------------------------------------
+// NEON实现：AArch64上NEON总是可用，不需要运行时检测
+
+#ifdef TEXAS_KERNELS_NEON
+
+inline float32x4_t clampNeon(float32x4_t value) {
+    return vminq_f32(vdupq_n_f32(1.0f), vmaxq_f32(vdupq_n_f32(-1.0f), value));
+}
+
+void interleaveNeon(const float *const *planes, size_t offset, int channels,
+                    size_t frames, float gain, float *out) {
+    size_t i = 0;
+    if (channels == 1) {
+        const float *mono = planes[0] + offset;
+        for (; i + 4 <= frames; i += 4) {
+            float32x4_t v = vmulq_n_f32(vld1q_f32(mono + i), gain);
+            vst1q_f32(out + i, clampNeon(v));
+        }
+    } else if (channels == 2) {
+        const float *left = planes[0] + offset;
+        const float *right = planes[1] + offset;
+        for (; i + 4 <= frames; i += 4) {
+            float32x4x2_t v;
+            v.val[0] = clampNeon(vmulq_n_f32(vld1q_f32(left + i), gain));
+            v.val[1] = clampNeon(vmulq_n_f32(vld1q_f32(right + i), gain));
+            vst2q_f32(out + i * 2, v);
+        }
+    }
+    if (i < frames) {
+        interleaveScalar(planes, offset + i, channels, frames - i, gain,
+                         out + i * channels);
+    }
+}
+
+void gainF32Neon(const float *in, float *out, size_t count, float gain) {
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        float32x4_t v = vmulq_n_f32(vld1q_f32(in + i), gain);
+        vst1q_f32(out + i, clampNeon(v));
+    }
+    gainF32Scalar(in + i, out + i, count - i, gain);
+}
+
+void gainS16Neon(const int16_t *in, int16_t *out, size_t count, float gain) {
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        int16x8_t v = vld1q_s16(in + i);
+        float32x4_t lo = vcvtq_f32_s32(vmovl_s16(vget_low_s16(v)));
+        float32x4_t hi = vcvtq_f32_s32(vmovl_s16(vget_high_s16(v)));
+        int32x4_t loInt = vcvtnq_s32_f32(vmulq_n_f32(lo, gain));
+        int32x4_t hiInt = vcvtnq_s32_f32(vmulq_n_f32(hi, gain));
+        vst1q_s16(out + i, vcombine_s16(vqmovn_s32(loInt), vqmovn_s32(hiInt)));
+    }
+    gainS16Scalar(in + i, out + i, count - i, gain);
+}
+
+// 每个向量2帧
+void mixStereoNeon(const float *in, float *out, size_t frames,
+                   float leftStart, float rightStart, float leftEnd,
+                   float rightEnd) {
+    float leftStep = frames > 0 ? (leftEnd - leftStart) / frames : 0.0f;
+    float rightStep = frames > 0 ? (rightEnd - rightStart) / frames : 0.0f;
+    const float initial[4] = {leftStart, rightStart, leftStart + leftStep,
+                              rightStart + rightStep};
+    const float increment[4] = {leftStep * 2, rightStep * 2, leftStep * 2,
+                                rightStep * 2};
+    float32x4_t gain = vld1q_f32(initial);
+    float32x4_t step = vld1q_f32(increment);
+    size_t i = 0;
+    for (; i + 2 <= frames; i += 2) {
+        float32x4_t v = vld1q_f32(in + i * 2);
+        vst1q_f32(out + i * 2, vmlaq_f32(vld1q_f32(out + i * 2), v, gain));
+        gain = vaddq_f32(gain, step);
+    }
+    mixStereoScalar(in + i * 2, out + i * 2, frames - i,
+                    leftStart + leftStep * i, rightStart + rightStep * i,
+                    leftEnd, rightEnd);
+}
+
+void peakF32Neon(const float *in, size_t count, float *peak,
+                 double *sumSquares) {
+    float32x4_t maxValue = vdupq_n_f32(0.0f);
+    float64x2_t sum = vdupq_n_f64(0.0);
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        float32x4_t v = vld1q_f32(in + i);
+        maxValue = vmaxq_f32(maxValue, vabsq_f32(v));
+        float64x2_t lo = vcvt_f64_f32(vget_low_f32(v));
+        float64x2_t hi = vcvt_high_f64_f32(v);
+        sum = vfmaq_f64(sum, lo, lo);
+        sum = vfmaq_f64(sum, hi, hi);
+    }
+    *peak = std::max(*peak, vmaxvq_f32(maxValue));
+    *sumSquares += vaddvq_f64(sum);
+    peakF32Scalar(in + i, count - i, peak, sumSquares);
+}
+
+const AudioKernels NEON_KERNELS = {
+    interleaveNeon, gainF32Neon,   gainS16Neon, rampF32Scalar,
+    rampS16Scalar,  mixStereoNeon, peakF32Neon, "neon",
+};
+
+#endif  // TEXAS_KERNELS_NEON
+
+const AudioKernels &detectKernels() {
+#ifdef TEXAS_KERNELS_X86
+    if (cpuHasAvx2()) {
+        return AVX2_KERNELS;
+    }
+#endif
+#ifdef TEXAS_KERNELS_NEON
+    return NEON_KERNELS;
+#endif
+    return SCALAR_KERNELS;
+}
+
+}  // namespace
+
+const AudioKernels &AudioKernels::get() {
+    static const AudioKernels &kernels = detectKernels();
+    return kernels;
+}
+
+const AudioKernels &AudioKernels::scalar() { return SCALAR_KERNELS; }
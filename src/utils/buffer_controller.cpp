@@ -0,0 +1,81 @@
+// buffer_controller.cpp
+#include "buffer_controller.h"
+
+#include <algorithm>
+#include <cmath>
+
+void BufferController::configure(const BufferControllerConfig &newConfig) {
+    config = newConfig;
+    config.minMs = std::max(config.minMs, config.periodMs * 2);
+    config.maxMs = std::max(config.maxMs, config.minMs);
+    config.calmWindows = std::max(config.calmWindows, 1);
+    setTarget(configured ? targetMs : config.initialMs);
+    configured = true;
+    calmCount = 0;
+}
+
+bool BufferController::update(const BufferObservation &observation) {
+    int previous = targetMs;
+    double minFillMs = bytesToMs(observation.minFillBytes);
+    double produceMs = observation.maxProduceNs / 1e6;
+    // 一次回调取走一个周期，加上生产者最慢的一帧，缓冲至少要留这么多余量
+    double margin = config.periodMs + produceMs;
+
+    if (observation.underruns > 0) {
+        setTarget(std::max(targetMs * 2,
+                           targetMs + static_cast<int>(std::ceil(margin))));
+        calmCount = 0;
+    } else if (minFillMs < margin) {
+        setTarget(targetMs +
+                  static_cast<int>(std::ceil(margin - minFillMs)));
+        calmCount = 0;
+    } else {
+        if (calmCount == 0) {
+            calmMinFillMs = minFillMs;
+            calmMaxProduceMs = produceMs;
+        } else {
+            calmMinFillMs = std::min(calmMinFillMs, minFillMs);
+            calmMaxProduceMs = std::max(calmMaxProduceMs, produceMs);
+        }
+        if (++calmCount >= config.calmWindows) {
+            // 保留两倍余量，超出的部分是平稳期间从未用到的缓冲
+            double spare =
+                calmMinFillMs - 2.0 * (config.periodMs + calmMaxProduceMs);
+            int step = std::min(static_cast<int>(spare), targetMs / 8);
+            if (step > 0) {
+                setTarget(targetMs - step);
+            }
+            calmCount = 0;
+        }
+    }
+
+    if (targetMs > previous) {
+        growths++;
+    } else if (targetMs < previous) {
+        shrinks++;
+    }
+    return targetMs != previous;
+}
+
+size_t BufferController::getTargetBytes() const { return bytesForMs(targetMs); }
+
+size_t BufferController::bytesForMs(double ms) const {
+    auto frames = static_cast<size_t>(config.sampleRate * ms / 1000.0);
+    return frames * config.frameBytes;
+}
+
+BufferControllerStats BufferController::getStats() const {
+    return {targetMs, growths, shrinks};
+}
+
+double BufferController::bytesToMs(size_t bytes) const {
+    if (config.sampleRate <= 0 || config.frameBytes == 0) {
+        return 0.0;
+    }
+    return static_cast<double>(bytes) / config.frameBytes * 1000.0 /
+           config.sampleRate;
+}
+
+void BufferController::setTarget(int ms) {
+    targetMs = std::clamp(ms, config.minMs, config.maxMs);
+}
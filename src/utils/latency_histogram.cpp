@@ -0,0 +1,96 @@
+// latency_histogram.cpp
+#include "latency_histogram.h"
+
+#include <algorithm>
+
+namespace {
+
+int bitLength(uint64_t value) {
+    int bits = 0;
+    while (value != 0) {
+        value >>= 1;
+        bits++;
+    }
+    return bits;
+}
+
+}  // namespace
+
+// 小于2^SUB_BUCKET_BITS的值每个值一个桶；更大的值按最高位所在区间右移，
+// 保留SUB_BUCKET_BITS位有效数字，每个区间占SUB_BUCKET_HALF个桶
+size_t LatencyHistogram::bucketIndex(uint64_t value) {
+    int shift = std::max(0, bitLength(value) - SUB_BUCKET_BITS);
+    size_t index = static_cast<size_t>(shift) * SUB_BUCKET_HALF +
+                   static_cast<size_t>(value >> shift);
+    return std::min(index, BUCKET_COUNT - 1);
+}
+
+uint64_t LatencyHistogram::bucketUpperBound(size_t index) {
+    if (index < SUB_BUCKET_COUNT) {
+        return index;
+    }
+    uint64_t shift = (index - SUB_BUCKET_COUNT) / SUB_BUCKET_HALF + 1;
+    uint64_t mantissa = index - shift * SUB_BUCKET_HALF;
+    return ((mantissa + 1) << shift) - 1;
+}
+
+void LatencyHistogram::record(uint64_t nanoseconds) {
+    buckets[bucketIndex(nanoseconds)].fetch_add(1, std::memory_order_relaxed);
+    count.fetch_add(1, std::memory_order_relaxed);
+    sum.fetch_add(nanoseconds, std::memory_order_relaxed);
+
+    // 通常只有一个记录线程，CAS很少重试
+    uint64_t current = min.load(std::memory_order_relaxed);
+    while (nanoseconds < current &&
+           !min.compare_exchange_weak(current, nanoseconds,
+                                      std::memory_order_relaxed)) {
+    }
+    current = max.load(std::memory_order_relaxed);
+    while (nanoseconds > current &&
+           !max.compare_exchange_weak(current, nanoseconds,
+                                      std::memory_order_relaxed)) {
+    }
+}
+
+void LatencyHistogram::reset() {
+    for (auto &bucket : buckets) {
+        bucket.store(0, std::memory_order_relaxed);
+    }
+    count.store(0, std::memory_order_relaxed);
+    sum.store(0, std::memory_order_relaxed);
+    min.store(UINT64_MAX, std::memory_order_relaxed);
+    max.store(0, std::memory_order_relaxed);
+}
+
+LatencySummary LatencyHistogram::summarize() const {
+    LatencySummary summary;
+    std::array<uint64_t, BUCKET_COUNT> counts;
+    uint64_t total = 0;
+    for (size_t i = 0; i < BUCKET_COUNT; i++) {
+        counts[i] = buckets[i].load(std::memory_order_relaxed);
+        total += counts[i];
+    }
+    if (total == 0) {
+        return summary;
+    }
+
+    summary.count = total;
+    summary.sum = sum.load(std::memory_order_relaxed);
+    summary.min = min.load(std::memory_order_relaxed);
+    summary.max = max.load(std::memory_order_relaxed);
+
+    // 百分位取所在桶的上界，并且不超过记录到的最大值
+    const double quantiles[] = {0.5, 0.9, 0.99, 0.999};
+    uint64_t *targets[] = {&summary.p50, &summary.p90, &summary.p99,
+                           &summary.p999};
+    size_t next = 0;
+    uint64_t seen = 0;
+    for (size_t i = 0; i < BUCKET_COUNT && next < 4; i++) {
+        seen += counts[i];
+        while (next < 4 && seen >= quantiles[next] * total) {
+            *targets[next] = std::min(bucketUpperBound(i), summary.max);
+            next++;
+        }
+    }
+    return summary;
+}
@@ -4,41 +4,48 @@
 
 #include "logger.h"
 
+namespace {
+
+spdlog::async_overflow_policy toSpdlogPolicy(Logger::OverflowPolicy policy) {
+    switch (policy) {
+        case Logger::OverflowPolicy::BLOCK:
+            return spdlog::async_overflow_policy::block;
+        case Logger::OverflowPolicy::DROP_NEW:
+#if SPDLOG_VERSION >= 11200
+            return spdlog::async_overflow_policy::discard_new;
+#else
+            return spdlog::async_overflow_policy::overrun_oldest;
+#endif
+        case Logger::OverflowPolicy::DROP_OLDEST:
+            break;
+    }
+    return spdlog::async_overflow_policy::overrun_oldest;
+}
+
+}  // namespace
+
 bool Logger::initialize(const LoggerConfig &config) {
+    std::lock_guard<std::mutex> lock(loggersMutex_);
     config_ = config;
 
     try {
-        // 创建日志目录
+        // 创建日志目录；只有文件名时parent_path为空，不需要创建
         std::filesystem::path log_path(config_.filename);
-        std::filesystem::create_directories(log_path.parent_path());
-
-        std::vector<spdlog::sink_ptr> sinks;
-
-        // 添加控制台输出
-        if (config_.console_output) {
-            auto console_sink =
-                std::make_shared<spdlog::sinks::stdout_color_sink_mt>();
-            console_sink->set_pattern(config_.pattern);
-            sinks.push_back(console_sink);
+        if (log_path.has_parent_path()) {
+            std::error_code ec;
+            std::filesystem::create_directories(log_path.parent_path(), ec);
         }
 
-        // 添加文件输出
-        if (config_.daily_rotation) {
-            auto file_sink =
-                std::make_shared<spdlog::sinks::daily_file_sink_mt>(
-                    config_.filename, 0, 0);
-            file_sink->set_pattern(config_.pattern);
-            sinks.push_back(file_sink);
-        } else {
-            auto file_sink =
-                std::make_shared<spdlog::sinks::rotating_file_sink_mt>(
-                    config_.filename, config_.max_file_size, config_.max_files);
-            file_sink->set_pattern(config_.pattern);
-            sinks.push_back(file_sink);
+        std::vector<spdlog::sink_ptr> sinks = createSinks(config_.filename);
+
+        // 异步模式下所有logger共用一个线程池，队列在这里一次性分配
+        if (config_.async_mode) {
+            threadPool_ = std::make_shared<spdlog::details::thread_pool>(
+                config_.async_queue_size, config_.async_threads);
+            sharedSinks_ = sinks;
         }
 
-        logger_ = std::make_shared<spdlog::logger>("main", sinks.begin(),
-                                                   sinks.end());
+        logger_ = createLogger("main", sinks);
 
         // 设置日志级别
         setLevel(config_.level);
@@ -53,12 +60,64 @@ bool Logger::initialize(const LoggerConfig &config) {
         spdlog::flush_every(std::chrono::seconds(3));
 
         return true;
-    } catch (const spdlog::spdlog_ex &ex) {
+    } catch (const std::exception &ex) {
         std::cerr << "Logger initialization failed: " << ex.what() << std::endl;
         return false;
     }
 }
 
+void Logger::shutdown() {
+    std::lock_guard<std::mutex> lock(loggersMutex_);
+    for (auto &item : loggers_) {
+        item.second->flush();
+    }
+    if (logger_) {
+        logger_->flush();
+    }
+    // 线程池析构时等待后台线程写完队列中的消息
+    loggers_.clear();
+    logger_.reset();
+    sharedSinks_.clear();
+    threadPool_.reset();
+}
+
+// 控制台和文件sink，文件按配置选择按天或按大小轮转
+std::vector<spdlog::sink_ptr> Logger::createSinks(const std::string &filename) {
+    std::vector<spdlog::sink_ptr> sinks;
+
+    // 添加控制台输出
+    if (config_.console_output) {
+        auto console_sink =
+            std::make_shared<spdlog::sinks::stdout_color_sink_mt>();
+        console_sink->set_pattern(config_.pattern);
+        sinks.push_back(console_sink);
+    }
+
+    // 添加文件输出
+    if (config_.daily_rotation) {
+        auto file_sink =
+            std::make_shared<spdlog::sinks::daily_file_sink_mt>(filename, 0, 0);
+        file_sink->set_pattern(config_.pattern);
+        sinks.push_back(file_sink);
+    } else {
+        auto file_sink = std::make_shared<spdlog::sinks::rotating_file_sink_mt>(
+            filename, config_.max_file_size, config_.max_files);
+        file_sink->set_pattern(config_.pattern);
+        sinks.push_back(file_sink);
+    }
+    return sinks;
+}
+
+std::shared_ptr<spdlog::logger> Logger::createLogger(
+    const std::string &name, const std::vector<spdlog::sink_ptr> &sinks) {
+    if (threadPool_) {
+        return std::make_shared<spdlog::async_logger>(
+            name, sinks.begin(), sinks.end(), threadPool_,
+            toSpdlogPolicy(config_.overflow_policy));
+    }
+    return std::make_shared<spdlog::logger>(name, sinks.begin(), sinks.end());
+}
+
 void Logger::setLevel(Level level) {
     if (!logger_) return;
 
@@ -90,44 +149,28 @@ void Logger::setPattern(const std::string &pattern) {
 }
 
 std::shared_ptr<spdlog::logger> Logger::getLogger(const std::string &name) {
+    std::lock_guard<std::mutex> lock(loggersMutex_);
     auto it = loggers_.find(name);
     if (it != loggers_.end()) {
         return it->second;
     }
 
     try {
-        std::vector<spdlog::sink_ptr> sinks;
-
-        if (config_.console_output) {
-            auto console_sink =
-                std::make_shared<spdlog::sinks::stdout_color_sink_mt>();
-            console_sink->set_pattern(config_.pattern);
-            sinks.push_back(console_sink);
+        // 异步模式共用主logger的sink，同步模式每个子logger写独立的文件
+        std::vector<spdlog::sink_ptr> sinks = sharedSinks_;
+        if (!threadPool_) {
+            std::string filename = config_.filename;
+            auto dot_pos = filename.find_last_of('.');
+            if (dot_pos != std::string::npos) {
+                filename.insert(dot_pos, "_" + name);
+            }
+            sinks = createSinks(filename);
         }
 
-        std::string filename = config_.filename;
-        auto dot_pos = filename.find_last_of('.');
-        if (dot_pos != std::string::npos) {
-            filename.insert(dot_pos, "_" + name);
+        auto logger = createLogger(name, sinks);
+        if (logger_) {
+            logger->set_level(logger_->level());
         }
-
-        if (config_.daily_rotation) {
-            auto file_sink =
-                std::make_shared<spdlog::sinks::daily_file_sink_mt>(filename, 0,
-                                                                    0);
-            file_sink->set_pattern(config_.pattern);
-            sinks.push_back(file_sink);
-        } else {
-            auto file_sink =
-                std::make_shared<spdlog::sinks::rotating_file_sink_mt>(
-                    filename, config_.max_file_size, config_.max_files);
-            file_sink->set_pattern(config_.pattern);
-            sinks.push_back(file_sink);
-        }
-
-        auto logger =
-            std::make_shared<spdlog::logger>(name, sinks.begin(), sinks.end());
-        logger->set_level(logger_->level());
         loggers_[name] = logger;
         return logger;
     } catch (const spdlog::spdlog_ex &ex) {
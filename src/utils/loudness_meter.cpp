@@ -0,0 +1,325 @@
+// loudness_meter.cpp
+#include "loudness_meter.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "audio_resampler.h"
+
+namespace {
+
+const double PI = 3.14159265358979323846;
+const double NEG_INF = -std::numeric_limits<double>::infinity();
+const double ABSOLUTE_GATE_LUFS = -70.0;
+const double RELATIVE_GATE_LU = -10.0;
+const double LRA_RELATIVE_GATE_LU = -20.0;
+
+double toLufs(double power) {
+    return power > 0.0 ? -0.691 + 10.0 * std::log10(power) : NEG_INF;
+}
+
+double fromLufs(double lufs) { return std::pow(10.0, (lufs + 0.691) / 10.0); }
+
+double toDb(double amplitude) {
+    return amplitude > 0.0 ? 20.0 * std::log10(amplitude) : NEG_INF;
+}
+
+// 按SDL声道顺序的BS.1770加权：低音炮不计入，环绕声道（与FFmpeg的ebur128
+// 滤镜一致，包括后置中央）加权1.41
+double channelWeight(int channels, int index) {
+    AVChannelLayout layout{};
+    sdlChannelLayout(channels, &layout);
+    AVChannel channel = av_channel_layout_channel_from_index(&layout, index);
+    av_channel_layout_uninit(&layout);
+    switch (channel) {
+        case AV_CHAN_LOW_FREQUENCY:
+            return 0.0;
+        case AV_CHAN_BACK_LEFT:
+        case AV_CHAN_BACK_RIGHT:
+        case AV_CHAN_BACK_CENTER:
+        case AV_CHAN_SIDE_LEFT:
+        case AV_CHAN_SIDE_RIGHT:
+            return 1.41;
+        default:
+            return 1.0;
+    }
+}
+
+// 门限以上的功率的平均值，没有时为0
+double gatedMean(const std::vector<double> &powers, double threshold) {
+    double sum = 0.0;
+    size_t count = 0;
+    for (double power : powers) {
+        if (power > threshold) {
+            sum += power;
+            count++;
+        }
+    }
+    return count > 0 ? sum / count : 0.0;
+}
+
+}  // namespace
+
+LoudnessResult::LoudnessResult()
+    : integratedLufs(NEG_INF),
+      momentaryLufs(NEG_INF),
+      shortTermLufs(NEG_INF),
+      loudnessRange(0.0),
+      samplePeakDb(NEG_INF),
+      truePeakDb(NEG_INF),
+      rmsDb(NEG_INF),
+      frames(0),
+      complete(true) {}
+
+double LoudnessResult::replayGainDb(double referenceLufs,
+                                    double peakLimitDb) const {
+    if (!std::isfinite(integratedLufs)) {
+        return 0.0;
+    }
+    double gain = referenceLufs - integratedLufs;
+    if (std::isfinite(truePeakDb) && truePeakDb + gain > peakLimitDb) {
+        gain = peakLimitDb - truePeakDb;
+    }
+    return gain;
+}
+
+// K加权滤波器按采样率由双线性变换计算，48kHz时与BS.1770给出的系数一致
+LoudnessMeter::LoudnessMeter(int sampleRate, int channels)
+    : sampleRate(std::max(1, sampleRate)),
+      channels(std::max(1, channels)),
+      kernels(AudioKernels::get()) {
+    double rate = static_cast<double>(this->sampleRate);
+
+    double f0 = 1681.974450955533;
+    double gainDb = 3.999843853973347;
+    double q = 0.7071752369554196;
+    double k = std::tan(PI * f0 / rate);
+    double vh = std::pow(10.0, gainDb / 20.0);
+    double vb = std::pow(vh, 0.4996667741545416);
+    double a0 = 1.0 + k / q + k * k;
+    shelf = {(vh + vb * k / q + k * k) / a0, 2.0 * (k * k - vh) / a0,
+             (vh - vb * k / q + k * k) / a0, 2.0 * (k * k - 1.0) / a0,
+             (1.0 - k / q + k * k) / a0};
+
+    f0 = 38.13547087602444;
+    q = 0.5003270373238773;
+    k = std::tan(PI * f0 / rate);
+    a0 = 1.0 + k / q + k * k;
+    highPass = {1.0, -2.0, 1.0, 2.0 * (k * k - 1.0) / a0,
+                (1.0 - k / q + k * k) / a0};
+
+    weights.resize(this->channels);
+    for (int c = 0; c < this->channels; c++) {
+        weights[c] = channelWeight(this->channels, c);
+    }
+    shelfState.resize(this->channels);
+    highPassState.resize(this->channels);
+
+    // 真峰值：96kHz以下4倍、192kHz以下2倍过采样，插值滤波器为Hann窗sinc
+    oversampling = this->sampleRate < 96000    ? MAX_OVERSAMPLING
+                   : this->sampleRate < 192000 ? 2
+                                               : 1;
+    if (oversampling > 1) {
+        int taps = oversampling * TAPS_PER_PHASE;
+        phaseTaps.resize(taps);
+        double center = (taps - 1) / 2.0;
+        for (int n = 0; n < taps; n++) {
+            double x = (n - center) / oversampling;
+            double sinc = x == 0.0 ? 1.0 : std::sin(PI * x) / (PI * x);
+            double window = 0.5 - 0.5 * std::cos(2.0 * PI * (n + 0.5) / taps);
+            // 按相位重排：phaseTaps[p * TAPS_PER_PHASE + k] = h[p + k * L]
+            int phase = n % oversampling;
+            int tap = n / oversampling;
+            phaseTaps[phase * TAPS_PER_PHASE + tap] =
+                static_cast<float>(sinc * window);
+        }
+        history.assign(static_cast<size_t>(this->channels) * TAPS_PER_PHASE,
+                       0.0f);
+    }
+
+    stepFrames = std::max<size_t>(1, this->sampleRate / 10);
+}
+
+void LoudnessMeter::reset() {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::fill(shelfState.begin(), shelfState.end(), FilterState());
+    std::fill(highPassState.begin(), highPassState.end(), FilterState());
+    std::fill(history.begin(), history.end(), 0.0f);
+    historyPos = 0;
+    stepFilled = 0;
+    stepEnergy = 0.0;
+    recentSteps.fill(0.0);
+    completedSteps = 0;
+    blockPowers.clear();
+    shortTermPowers.clear();
+    samplePeak = 0.0f;
+    truePeak = 0.0;
+    sumSquares = 0.0;
+    totalFrames = 0;
+    continuous = true;
+}
+
+void LoudnessMeter::markDiscontinuity() {
+    std::lock_guard<std::mutex> lock(mutex);
+    continuous = false;
+}
+
+void LoudnessMeter::process(const float *samples, size_t frames) {
+    std::lock_guard<std::mutex> lock(mutex);
+    processLocked(samples, frames);
+}
+
+void LoudnessMeter::process(const int16_t *samples, size_t frames) {
+    std::lock_guard<std::mutex> lock(mutex);
+    size_t count = frames * channels;
+    scratch.resize(count);
+    for (size_t i = 0; i < count; i++) {
+        scratch[i] = samples[i] / 32768.0f;
+    }
+    processLocked(scratch.data(), frames);
+}
+
+void LoudnessMeter::processLocked(const float *samples, size_t frames) {
+    kernels.peakF32(samples, frames * channels, &samplePeak, &sumSquares);
+    totalFrames += frames;
+
+    for (size_t i = 0; i < frames; i++) {
+        const float *frame = samples + i * channels;
+        double energy = 0.0;
+        for (int c = 0; c < channels; c++) {
+            truePeak = std::max(truePeak, truePeakOf(c, frame[c]));
+            if (weights[c] == 0.0) {
+                continue;
+            }
+            // 直接I型双二阶滤波，两级串联
+            FilterState &s1 = shelfState[c];
+            double x = frame[c];
+            double y = shelf.b0 * x + shelf.b1 * s1.x1 + shelf.b2 * s1.x2 -
+                       shelf.a1 * s1.y1 - shelf.a2 * s1.y2;
+            s1.x2 = s1.x1;
+            s1.x1 = x;
+            s1.y2 = s1.y1;
+            s1.y1 = y;
+
+            FilterState &s2 = highPassState[c];
+            double z = highPass.b0 * y + highPass.b1 * s2.x1 +
+                       highPass.b2 * s2.x2 - highPass.a1 * s2.y1 -
+                       highPass.a2 * s2.y2;
+            s2.x2 = s2.x1;
+            s2.x1 = y;
+            s2.y2 = s2.y1;
+            s2.y1 = z;
+
+            energy += weights[c] * z * z;
+        }
+        if (oversampling > 1) {
+            historyPos = (historyPos + 1) % TAPS_PER_PHASE;
+        }
+        stepEnergy += energy;
+        if (++stepFilled == stepFrames) {
+            finishStep();
+        }
+    }
+}
+
+// 写入当前样本后计算各相位的插值输出，返回其中最大的绝对值
+double LoudnessMeter::truePeakOf(int channel, float sample) {
+    if (oversampling <= 1) {
+        return std::abs(sample);
+    }
+    float *ring = history.data() + static_cast<size_t>(channel) *
+                                       TAPS_PER_PHASE;
+    ring[historyPos] = sample;
+    double peak = 0.0;
+    for (int phase = 0; phase < oversampling; phase++) {
+        const float *taps = phaseTaps.data() + phase * TAPS_PER_PHASE;
+        double value = 0.0;
+        size_t index = historyPos;
+        for (int k = 0; k < TAPS_PER_PHASE; k++) {
+            value += taps[k] * ring[index];
+            index = index == 0 ? TAPS_PER_PHASE - 1 : index - 1;
+        }
+        peak = std::max(peak, std::abs(value));
+    }
+    return peak;
+}
+
+// 每100ms结束一个步长，产生一个400ms块和一个3秒窗口
+void LoudnessMeter::finishStep() {
+    recentSteps[completedSteps % SHORT_TERM_STEPS] =
+        stepEnergy / static_cast<double>(stepFrames);
+    completedSteps++;
+    stepEnergy = 0.0;
+    stepFilled = 0;
+    if (completedSteps >= BLOCK_STEPS) {
+        blockPowers.push_back(meanOfSteps(BLOCK_STEPS));
+    }
+    if (completedSteps >= SHORT_TERM_STEPS) {
+        shortTermPowers.push_back(meanOfSteps(SHORT_TERM_STEPS));
+    }
+}
+
+// 最近count个步长的均方值的平均，调用方需持有mutex
+double LoudnessMeter::meanOfSteps(int count) const {
+    size_t available = std::min<size_t>(completedSteps, count);
+    if (available == 0) {
+        return 0.0;
+    }
+    double sum = 0.0;
+    for (size_t i = 0; i < available; i++) {
+        sum += recentSteps[(completedSteps - 1 - i) % SHORT_TERM_STEPS];
+    }
+    return sum / static_cast<double>(available);
+}
+
+LoudnessResult LoudnessMeter::result() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    LoudnessResult result;
+    result.frames = totalFrames;
+    result.complete = continuous;
+    result.samplePeakDb = toDb(samplePeak);
+    result.truePeakDb = toDb(std::max<double>(truePeak, samplePeak));
+    if (totalFrames > 0) {
+        result.rmsDb = toDb(std::sqrt(
+            sumSquares / static_cast<double>(totalFrames * channels)));
+    }
+    if (completedSteps >= BLOCK_STEPS) {
+        result.momentaryLufs = toLufs(meanOfSteps(BLOCK_STEPS));
+    }
+    if (completedSteps >= SHORT_TERM_STEPS) {
+        result.shortTermLufs = toLufs(meanOfSteps(SHORT_TERM_STEPS));
+    }
+
+    // 整体响度：先去掉-70 LUFS以下的块，再去掉比剩余平均低10 LU以下的块
+    double absoluteGate = fromLufs(ABSOLUTE_GATE_LUFS);
+    double relative = gatedMean(blockPowers, absoluteGate);
+    if (relative > 0.0) {
+        double relativeGate =
+            relative * std::pow(10.0, RELATIVE_GATE_LU / 10.0);
+        result.integratedLufs = toLufs(
+            gatedMean(blockPowers, std::max(absoluteGate, relativeGate)));
+    }
+
+    // 响度范围：门限后短期响度分布的10%到95%分位
+    double shortMean = gatedMean(shortTermPowers, absoluteGate);
+    if (shortMean > 0.0) {
+        double gate =
+            std::max(absoluteGate,
+                     shortMean * std::pow(10.0, LRA_RELATIVE_GATE_LU / 10.0));
+        std::vector<double> gated;
+        for (double power : shortTermPowers) {
+            if (power > gate) {
+                gated.push_back(power);
+            }
+        }
+        std::sort(gated.begin(), gated.end());
+        if (gated.size() > 1) {
+            size_t last = gated.size() - 1;
+            double low = gated[static_cast<size_t>(std::lround(last * 0.10))];
+            double high = gated[static_cast<size_t>(std::lround(last * 0.95))];
+            result.loudnessRange = toLufs(high) - toLufs(low);
+        }
+    }
+    return result;
+}
@@ -0,0 +1,91 @@
+// playback_clock.cpp
+#include "playback_clock.h"
+
+#include <algorithm>
+#include <chrono>
+
+// 顺序锁：写入前后各递增一次序号，读取方看到相同的偶数序号时数据完整
+void PlaybackClock::beginWrite() {
+    sequence.store(sequence.load(std::memory_order_relaxed) + 1,
+                   std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+}
+
+void PlaybackClock::endWrite() {
+    sequence.store(sequence.load(std::memory_order_relaxed) + 1,
+                   std::memory_order_release);
+}
+
+void PlaybackClock::configure(int sampleRate, int64_t latencyFrames) {
+    beginWrite();
+    rate.store(sampleRate, std::memory_order_relaxed);
+    latency.store(std::max<int64_t>(0, latencyFrames),
+                  std::memory_order_relaxed);
+    endWrite();
+}
+
+void PlaybackClock::advance(int64_t frame, int64_t frames,
+                            int64_t timestampNs, int64_t floor) {
+    int64_t delay = latency.load(std::memory_order_relaxed);
+    beginWrite();
+    startFrame.store(std::max(frame - delay, floor),
+                     std::memory_order_relaxed);
+    endFrame.store(std::max(frame + frames - delay, floor),
+                   std::memory_order_relaxed);
+    timestamp.store(timestampNs, std::memory_order_relaxed);
+    running.store(true, std::memory_order_relaxed);
+    endWrite();
+}
+
+void PlaybackClock::freeze(int64_t frame) {
+    beginWrite();
+    startFrame.store(frame, std::memory_order_relaxed);
+    endFrame.store(frame, std::memory_order_relaxed);
+    running.store(false, std::memory_order_relaxed);
+    endWrite();
+}
+
+ClockReading PlaybackClock::read(int64_t nowNs) const {
+    int64_t start, end, stamp;
+    bool isRunning;
+    int sampleRate;
+    while (true) {
+        uint32_t before = sequence.load(std::memory_order_acquire);
+        if (before & 1) {
+            continue;
+        }
+        start = startFrame.load(std::memory_order_relaxed);
+        end = endFrame.load(std::memory_order_relaxed);
+        stamp = timestamp.load(std::memory_order_relaxed);
+        isRunning = running.load(std::memory_order_relaxed);
+        sampleRate = rate.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (sequence.load(std::memory_order_relaxed) == before) {
+            break;
+        }
+    }
+
+    ClockReading reading;
+    reading.frame = start;
+    reading.running = isRunning;
+    if (isRunning && sampleRate > 0) {
+        // 回调停顿很久时读数停在end，先限制elapsed避免乘法溢出
+        int64_t elapsed = std::clamp<int64_t>(
+            (nowNs > 0 ? nowNs : nowNanos()) - stamp, 0, 1000000000);
+        int64_t advanced = elapsed * sampleRate / 1000000000;
+        reading.frame = std::min(start + advanced, end);
+    }
+    reading.seconds =
+        sampleRate > 0 ? static_cast<double>(reading.frame) / sampleRate : 0.0;
+    return reading;
+}
+
+int64_t PlaybackClock::getLatencyFrames() const {
+    return latency.load(std::memory_order_relaxed);
+}
+
+int64_t PlaybackClock::nowNanos() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
@@ -0,0 +1,29 @@
+// rt_event_ring.cpp
+#include "rt_event_ring.h"
+
+RtEventRing::RtEventRing(size_t capacity)
+    : ring(capacity * sizeof(AudioEvent)) {}
+
+// 只有一个生产者，检查到的可写空间不会被其他线程占用，记录总是整条写入
+bool RtEventRing::push(const AudioEvent &event) {
+    if (ring.writeAvailable() < sizeof(AudioEvent)) {
+        dropped.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    ring.write(reinterpret_cast<const uint8_t *>(&event), sizeof(AudioEvent));
+    return true;
+}
+
+bool RtEventRing::pop(AudioEvent &event) {
+    if (ring.readAvailable() < sizeof(AudioEvent)) {
+        return false;
+    }
+    ring.read(reinterpret_cast<uint8_t *>(&event), sizeof(AudioEvent));
+    return true;
+}
+
+void RtEventRing::clear() { ring.clear(); }
+
+uint64_t RtEventRing::getDroppedCount() const {
+    return dropped.load(std::memory_order_relaxed);
+}
@@ -0,0 +1,98 @@
+// spsc_ring_buffer.cpp
+#include "spsc_ring_buffer.h"
+
+#include <algorithm>
+#include <cstring>
+
+SpscRingBuffer::SpscRingBuffer(size_t capacity) { reset(capacity); }
+
+void SpscRingBuffer::reset(size_t capacity) {
+    if (capacity != bufferCapacity) {
+        storage.reset(capacity > 0 ? new uint8_t[capacity] : nullptr);
+        bufferCapacity = capacity;
+    }
+    // 预先触碰所有页面，避免音频回调中首次访问产生缺页
+    if (storage) {
+        std::memset(storage.get(), 0, bufferCapacity);
+    }
+    readIndex.store(0, std::memory_order_relaxed);
+    writeIndex.store(0, std::memory_order_release);
+}
+
+void SpscRingBuffer::clear() {
+    readIndex.store(writeIndex.load(std::memory_order_acquire),
+                    std::memory_order_release);
+}
+
+size_t SpscRingBuffer::writeAvailable() const {
+    size_t w = writeIndex.load(std::memory_order_relaxed);
+    size_t r = readIndex.load(std::memory_order_acquire);
+    return bufferCapacity - (w - r);
+}
+
+size_t SpscRingBuffer::readAvailable() const {
+    size_t r = readIndex.load(std::memory_order_relaxed);
+    size_t w = writeIndex.load(std::memory_order_acquire);
+    return w - r;
+}
+
+size_t SpscRingBuffer::write(const uint8_t *data, size_t size) {
+    size_t w = writeIndex.load(std::memory_order_relaxed);
+    size_t r = readIndex.load(std::memory_order_acquire);
+    size_t toWrite = std::min(size, bufferCapacity - (w - r));
+    if (toWrite == 0) {
+        return 0;
+    }
+
+    size_t offset = w % bufferCapacity;
+    size_t firstPart = std::min(toWrite, bufferCapacity - offset);
+    std::memcpy(storage.get() + offset, data, firstPart);
+    if (toWrite > firstPart) {
+        std::memcpy(storage.get(), data + firstPart, toWrite - firstPart);
+    }
+
+    writeIndex.store(w + toWrite, std::memory_order_release);
+    return toWrite;
+}
+
+size_t SpscRingBuffer::peek(size_t size, Span &first, Span &second) const {
+    size_t r = readIndex.load(std::memory_order_relaxed);
+    size_t w = writeIndex.load(std::memory_order_acquire);
+    size_t toRead = std::min(size, w - r);
+
+    first = Span();
+    second = Span();
+    if (toRead == 0) {
+        return 0;
+    }
+
+    size_t offset = r % bufferCapacity;
+    size_t firstPart = std::min(toRead, bufferCapacity - offset);
+    first.data = storage.get() + offset;
+    first.size = firstPart;
+    if (toRead > firstPart) {
+        second.data = storage.get();
+        second.size = toRead - firstPart;
+    }
+    return toRead;
+}
+
+void SpscRingBuffer::consume(size_t size) {
+    size_t r = readIndex.load(std::memory_order_relaxed);
+    readIndex.store(r + size, std::memory_order_release);
+}
+
+size_t SpscRingBuffer::read(uint8_t *dest, size_t size) {
+    Span first, second;
+    size_t toRead = peek(size, first, second);
+    if (toRead == 0) {
+        return 0;
+    }
+
+    std::memcpy(dest, first.data, first.size);
+    if (second.size > 0) {
+        std::memcpy(dest + first.size, second.data, second.size);
+    }
+    consume(toRead);
+    return toRead;
+}
@@ -0,0 +1,102 @@
+// thread_pool.cpp
+#include "thread_pool.h"
+
+#include <algorithm>
+
+WorkStealingThreadPool::WorkStealingThreadPool(size_t threadCount) {
+    if (threadCount == 0) {
+        threadCount = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    queues.reserve(threadCount);
+    for (size_t i = 0; i < threadCount; i++) {
+        queues.push_back(std::make_unique<WorkerQueue>());
+    }
+    workers.reserve(threadCount);
+    for (size_t i = 0; i < threadCount; i++) {
+        workers.emplace_back(&WorkStealingThreadPool::workerLoop, this, i);
+    }
+}
+
+WorkStealingThreadPool::~WorkStealingThreadPool() {
+    wait();
+    {
+        std::lock_guard<std::mutex> lock(wakeMutex);
+        stopping = true;
+    }
+    wakeCondition.notify_all();
+    for (auto &worker : workers) {
+        if (worker.joinable()) {
+            worker.join();
+        }
+    }
+}
+
+void WorkStealingThreadPool::submit(Task task) {
+    size_t index = nextQueue.fetch_add(1) % queues.size();
+    pendingTasks++;
+    // 先增加计数再入队，保证取走任务的线程不会把计数减成负数
+    {
+        std::lock_guard<std::mutex> lock(wakeMutex);
+        queuedTasks++;
+    }
+    {
+        std::lock_guard<std::mutex> lock(queues[index]->mutex);
+        queues[index]->tasks.push_back(std::move(task));
+    }
+    wakeCondition.notify_one();
+}
+
+void WorkStealingThreadPool::wait() {
+    std::unique_lock<std::mutex> lock(wakeMutex);
+    idleCondition.wait(lock, [this]() { return pendingTasks == 0; });
+}
+
+// 本地队列从头部取任务，保持提交顺序
+bool WorkStealingThreadPool::popLocal(size_t index, Task &task) {
+    WorkerQueue &queue = *queues[index];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (queue.tasks.empty()) {
+        return false;
+    }
+    task = std::move(queue.tasks.front());
+    queue.tasks.pop_front();
+    return true;
+}
+
+// 从其他线程队列的尾部窃取，减少与队列所有者的竞争
+bool WorkStealingThreadPool::steal(size_t thief, Task &task) {
+    for (size_t i = 1; i < queues.size(); i++) {
+        WorkerQueue &queue = *queues[(thief + i) % queues.size()];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (!queue.tasks.empty()) {
+            task = std::move(queue.tasks.back());
+            queue.tasks.pop_back();
+            return true;
+        }
+    }
+    return false;
+}
+
+void WorkStealingThreadPool::workerLoop(size_t index) {
+    while (true) {
+        Task task;
+        if (popLocal(index, task) || steal(index, task)) {
+            queuedTasks--;
+            task(index);
+
+            if (--pendingTasks == 0) {
+                std::lock_guard<std::mutex> lock(wakeMutex);
+                idleCondition.notify_all();
+            }
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(wakeMutex);
+        wakeCondition.wait(lock,
+                           [this]() { return stopping || queuedTasks > 0; });
+        if (stopping && queuedTasks == 0) {
+            return;
+        }
+    }
+}
@@ -0,0 +1,151 @@
+// thread_scheduling.cpp
+#include "thread_scheduling.h"
+
+#include <algorithm>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+// windows.h之后包含
+#include <avrt.h>
+#else
+#include <pthread.h>
+#include <sched.h>
+#include <sys/resource.h>
+#include <unistd.h>
+#endif
+
+#ifdef __linux__
+#include <sys/syscall.h>
+#endif
+
+#include "logger.h"
+
+namespace {
+
+#ifdef _WIN32
+bool setAffinity(const std::vector<int> &cpus) {
+    DWORD_PTR mask = 0;
+    for (int cpu : cpus) {
+        if (cpu >= 0 && cpu < static_cast<int>(sizeof(DWORD_PTR) * 8)) {
+            mask |= static_cast<DWORD_PTR>(1) << cpu;
+        }
+    }
+    return mask != 0 && SetThreadAffinityMask(GetCurrentThread(), mask) != 0;
+}
+
+bool setHighPriority() {
+    return SetThreadPriority(GetCurrentThread(),
+                             THREAD_PRIORITY_HIGHEST) != 0;
+}
+
+// MMCSS按任务类别统一调度音频线程，不需要管理员权限
+void *setRealtimePriority(const ThreadSchedulingPolicy &policy) {
+    DWORD taskIndex = 0;
+    HANDLE handle =
+        AvSetMmThreadCharacteristicsA(policy.mmcssTask.c_str(), &taskIndex);
+    if (handle) {
+        AvSetMmThreadPriority(handle, AVRT_PRIORITY_HIGH);
+    }
+    return handle;
+}
+#else
+bool setAffinity(const std::vector<int> &cpus) {
+#ifdef __linux__
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    bool any = false;
+    for (int cpu : cpus) {
+        if (cpu >= 0 && cpu < CPU_SETSIZE) {
+            CPU_SET(cpu, &set);
+            any = true;
+        }
+    }
+    return any &&
+           pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+    // macOS只有亲和性提示，没有绑定核心的接口
+    (void)cpus;
+    return false;
+#endif
+}
+
+bool setHighPriority() {
+#ifdef __linux__
+    // Linux的nice值按线程生效
+    const int HIGH_NICE = -10;
+    pid_t tid = static_cast<pid_t>(syscall(SYS_gettid));
+    return setpriority(PRIO_PROCESS, tid, HIGH_NICE) == 0;
+#elif defined(__APPLE__)
+    return pthread_set_qos_class_self_np(QOS_CLASS_USER_INTERACTIVE, 0) == 0;
+#else
+    return false;
+#endif
+}
+
+bool setRealtimePriority(const ThreadSchedulingPolicy &policy) {
+    int schedPolicy = policy.roundRobin ? SCHED_RR : SCHED_FIFO;
+    int low = sched_get_priority_min(schedPolicy);
+    int high = sched_get_priority_max(schedPolicy);
+    sched_param param{};
+    param.sched_priority = policy.realtimePriority > 0
+                               ? std::clamp(policy.realtimePriority, low, high)
+                               : (low + high) / 2;
+    return pthread_setschedparam(pthread_self(), schedPolicy, &param) == 0;
+}
+#endif
+
+}  // namespace
+
+ScopedThreadScheduling::ScopedThreadScheduling(
+    const ThreadSchedulingPolicy &policy, const char *name) {
+    if (policy.isDefault()) {
+        return;
+    }
+    auto logger = Logger::getInstance().getLogger("ThreadScheduling");
+
+    if (!policy.cpuAffinity.empty()) {
+        affinityApplied = setAffinity(policy.cpuAffinity);
+        if (!affinityApplied) {
+            logger->warn("Could not pin {} thread to the requested CPUs",
+                         name);
+        }
+    }
+
+    switch (policy.priority) {
+        case ThreadPriority::NORMAL:
+            break;
+        case ThreadPriority::HIGH:
+            priorityApplied = setHighPriority();
+            break;
+        case ThreadPriority::REALTIME:
+#ifdef _WIN32
+            mmcssHandle = setRealtimePriority(policy);
+            priorityApplied = mmcssHandle != nullptr;
+#else
+            priorityApplied = setRealtimePriority(policy);
+#endif
+            break;
+    }
+    if (policy.priority != ThreadPriority::NORMAL && !priorityApplied) {
+        // 多数情况是没有实时调度的权限，按原来的优先级继续运行
+        logger->warn("Could not raise {} thread priority, keeping defaults",
+                     name);
+    }
+    logger->debug("{} thread scheduling: affinity {}, priority {}", name,
+                  affinityApplied ? "pinned" : "unchanged",
+                  priorityApplied ? "raised" : "unchanged");
+}
+
+ScopedThreadScheduling::~ScopedThreadScheduling() {
+#ifdef _WIN32
+    if (mmcssHandle) {
+        AvRevertMmThreadCharacteristics(mmcssHandle);
+    }
+#endif
+}
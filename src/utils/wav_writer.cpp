@@ -0,0 +1,91 @@
+// wav_writer.cpp
+#include "wav_writer.h"
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+
+namespace {
+constexpr uint16_t WAVE_FORMAT_PCM = 1;
+constexpr uint16_t WAVE_FORMAT_IEEE_FLOAT = 3;
+constexpr uint32_t WAV_HEADER_SIZE = 44;
+
+void putLE16(uint8_t *p, uint16_t v) {
+    p[0] = static_cast<uint8_t>(v);
+    p[1] = static_cast<uint8_t>(v >> 8);
+}
+
+void putLE32(uint8_t *p, uint32_t v) {
+    for (int i = 0; i < 4; i++) {
+        p[i] = static_cast<uint8_t>(v >> (8 * i));
+    }
+}
+}  // namespace
+
+WavWriter::~WavWriter() { close(); }
+
+bool WavWriter::open(const std::string &filename, int rate, int numChannels,
+                     int bits, bool floatSamples) {
+    close();
+
+    std::filesystem::path path(filename);
+    if (path.has_parent_path()) {
+        std::error_code ec;
+        std::filesystem::create_directories(path.parent_path(), ec);
+    }
+
+    file = std::fopen(filename.c_str(), "wb");
+    if (!file) {
+        return false;
+    }
+
+    sampleRate = rate;
+    channels = numChannels;
+    bitsPerSample = bits;
+    isFloat = floatSamples;
+    dataSize = 0;
+    return writeHeader();
+}
+
+bool WavWriter::writeHeader() {
+    uint8_t header[WAV_HEADER_SIZE];
+    uint32_t blockAlign = channels * bitsPerSample / 8;
+    // WAV长度字段只有32位，超出部分截断
+    uint32_t dataBytes = static_cast<uint32_t>(
+        std::min<uint64_t>(dataSize, UINT32_MAX - WAV_HEADER_SIZE));
+
+    std::memcpy(header, "RIFF", 4);
+    putLE32(header + 4, dataBytes + WAV_HEADER_SIZE - 8);
+    std::memcpy(header + 8, "WAVE", 4);
+    std::memcpy(header + 12, "fmt ", 4);
+    putLE32(header + 16, 16);
+    putLE16(header + 20, isFloat ? WAVE_FORMAT_IEEE_FLOAT : WAVE_FORMAT_PCM);
+    putLE16(header + 22, static_cast<uint16_t>(channels));
+    putLE32(header + 24, static_cast<uint32_t>(sampleRate));
+    putLE32(header + 28, sampleRate * blockAlign);
+    putLE16(header + 32, static_cast<uint16_t>(blockAlign));
+    putLE16(header + 34, static_cast<uint16_t>(bitsPerSample));
+    std::memcpy(header + 36, "data", 4);
+    putLE32(header + 40, dataBytes);
+
+    return std::fwrite(header, 1, sizeof(header), file) == sizeof(header);
+}
+
+bool WavWriter::write(const uint8_t *data, size_t size) {
+    if (!file) {
+        return false;
+    }
+    size_t written = std::fwrite(data, 1, size, file);
+    dataSize += written;
+    return written == size;
+}
+
+bool WavWriter::close() {
+    if (!file) {
+        return true;
+    }
+    bool ok = std::fseek(file, 0, SEEK_SET) == 0 && writeHeader();
+    ok = std::fclose(file) == 0 && ok;
+    file = nullptr;
+    return ok;
+}
@@ -9,13 +9,81 @@ add_requires("ffmpeg", {system=false})
 -- 添加sdl2包
 add_requires("libsdl2", {alias = "sdl2", system=false})
 
+-- 编译期最低日志级别，更低级别的日志调用不会生成任何代码
+-- auto: debug模式保留全部级别，release模式保留info及以上
+option("log-level-min")
+    set_default("auto")
+    set_showmenu(true)
+    set_description("Lowest log level compiled into the binary")
+    set_values("auto", "trace", "debug", "info", "warn", "error", "critical")
+option_end()
+
+local log_level = get_config("log-level-min") or "auto"
+if log_level == "auto" then
+    log_level = is_mode("release") and "info" or "trace"
+end
+
+-- 各目标共用的库源文件（不含main.cpp）、依赖和日志级别，在target内调用
+function add_texas_common()
+    add_files("src/**.cpp|main.cpp")
+    add_packages("spdlog", "ffmpeg", "sdl2")
+    -- 实时优先级使用MMCSS
+    if is_plat("windows", "mingw") then
+        add_syslinks("avrt")
+    end
+    add_defines("SPDLOG_ACTIVE_LEVEL=SPDLOG_LEVEL_" .. log_level:upper())
+end
+
 target("texas")
     set_kind("binary")
 
-    add_files("src/**.cpp")
+    add_files("src/main.cpp")
     add_includedirs("include")
+    add_texas_common()
 
-    add_packages("spdlog", "ffmpeg", "sdl2")
+-- 嵌入用的动态库，导出include/texas.h中的C接口：xmake build texas_c
+target("texas_c")
+    set_kind("shared")
+    set_default(false)
+
+    add_includedirs("include", {public = true})
+    add_headerfiles("include/texas.h")
+    add_defines("TEXAS_SHARED")
+    add_defines("TEXAS_BUILD_DLL")
+    set_symbols("hidden")
+    add_texas_common()
+
+-- 浸泡测试：xmake build texas_soak && xmake run texas_soak --duration 7200
+target("texas_soak")
+    set_kind("binary")
+    set_default(false)
+
+    add_files("soak/*.cpp", "bench/bench_signals.cpp")
+    add_includedirs("include", "bench", "soak")
+    add_texas_common()
+    if is_plat("windows", "mingw") then
+        add_syslinks("psapi")
+    end
+
+-- 基准测试：xmake f --bench=y && xmake build texas_bench
+option("bench")
+    set_default(false)
+    set_showmenu(true)
+    set_description("Build the texas_bench benchmark target")
+option_end()
+
+if has_config("bench") then
+    add_requires("benchmark")
+
+    target("texas_bench")
+        set_kind("binary")
+        set_default(false)
+
+        add_files("bench/*.cpp")
+        add_includedirs("include", "bench")
+        add_texas_common()
+        add_packages("benchmark")
+end
 
 
 --